@@ -652,6 +652,7 @@ SystemData* CollectionSystemManager::addNewCustomCollection(std::string name)
 SystemData* CollectionSystemManager::createNewCollectionEntry(std::string name, CollectionSystemDecl sysDecl, bool index)
 {
 	SystemData* newSys = new SystemData(name, sysDecl.longName, mCollectionEnvData, sysDecl.themeFolder, true);
+	newSys->loadTheme();
 
 	CollectionSystemData newCollectionData;
 	newCollectionData.system = newSys;
@@ -15,7 +15,10 @@
 #include <boost/filesystem/operations.hpp>
 
 FileData::FileData(FileType type, const boost::filesystem::path& path, SystemEnvironmentData* envData, SystemData* system)
-	: mType(type), mPath(path), mSystem(system), mEnvData(envData), mSourceFileData(NULL), mParent(NULL), metadata(type == GAME ? GAME_METADATA : FOLDER_METADATA) // metadata is REALLY set in the constructor!
+	: mType(type), mPath(path), mSystem(system), mEnvData(envData), mSourceFileData(NULL), mParent(NULL), metadata(type == GAME ? GAME_METADATA : FOLDER_METADATA), // metadata is REALLY set in the constructor!
+	mGameCount(0), mTreeVersion(1), mFilteredChildrenIndex(NULL), mFilteredChildrenIndexVersion(0), mFilteredChildrenTreeVersion(0),
+	mFilteredChildrenMetadataVersion(0), mDisplayedGameCount(0), mDisplayedGameCountIndexVersion(0), mDisplayedGameCountTreeVersion(0),
+	mDisplayedGameCountMetadataVersion(0)
 {
 	// metadata needs at least a name field (since that's what getName() will return)
 	if(metadata.get("name").empty())
@@ -66,7 +69,7 @@ const std::string FileData::getThumbnailPath() const
 				if(thumbnail.empty())
 				{
 					std::string path = mEnvData->mStartPath + "/images/" + getDisplayName() + "-image" + extList[i];
-					if(boost::filesystem::exists(path))
+					if(mEnvData->mMediaIndex.exists(path))
 						thumbnail = path;
 				}
 			}
@@ -78,19 +81,29 @@ const std::string FileData::getThumbnailPath() const
 
 const std::string& FileData::getName()
 {
-	return metadata.get("name");
+	return metadata.get(MD_ID_NAME);
 }
 
 const std::vector<FileData*>& FileData::getChildrenListToDisplay() {
 
 	FileFilterIndex* idx = CollectionSystemManager::get()->getSystemToView(mSystem)->getIndex();
 	if (idx->isFiltered()) {
-		mFilteredChildren.clear();
-		for(auto it = mChildren.cbegin(); it != mChildren.cend(); it++)
+		if (mFilteredChildrenIndex != idx || mFilteredChildrenIndexVersion != idx->getVersion() || mFilteredChildrenTreeVersion != mTreeVersion ||
+			mFilteredChildrenMetadataVersion != MetaDataList::getLatestVersion())
 		{
-			if (idx->showFile((*it))) {
-				mFilteredChildren.push_back(*it);
+			mFilteredChildren.clear();
+			for(auto it = mChildren.cbegin(); it != mChildren.cend(); it++)
+			{
+				if (idx->showFile((*it))) {
+					mFilteredChildren.push_back(*it);
+				}
 			}
+
+			// showFile() may re-index games whose metadata changed, so take the version afterwards
+			mFilteredChildrenIndex = idx;
+			mFilteredChildrenIndexVersion = idx->getVersion();
+			mFilteredChildrenTreeVersion = mTreeVersion;
+			mFilteredChildrenMetadataVersion = MetaDataList::getLatestVersion();
 		}
 
 		return mFilteredChildren;
@@ -101,6 +114,33 @@ const std::vector<FileData*>& FileData::getChildrenListToDisplay() {
 	}
 }
 
+unsigned int FileData::getDisplayedGameCount() const
+{
+	FileFilterIndex* idx = mSystem->getIndex();
+	if (!idx->isFiltered())
+		return mGameCount;
+
+	if (mDisplayedGameCountIndexVersion != idx->getVersion() || mDisplayedGameCountTreeVersion != mTreeVersion ||
+		mDisplayedGameCountMetadataVersion != MetaDataList::getLatestVersion())
+	{
+		unsigned int count = 0;
+		for(auto it = mChildren.cbegin(); it != mChildren.cend(); it++)
+		{
+			if((*it)->getType() == GAME && idx->showFile(*it))
+				count++;
+			else if((*it)->getType() == FOLDER)
+				count += (*it)->getDisplayedGameCount();
+		}
+
+		mDisplayedGameCount = count;
+		mDisplayedGameCountIndexVersion = idx->getVersion();
+		mDisplayedGameCountTreeVersion = mTreeVersion;
+		mDisplayedGameCountMetadataVersion = MetaDataList::getLatestVersion();
+	}
+
+	return mDisplayedGameCount;
+}
+
 const std::string FileData::getVideoPath() const
 {
 	std::string video = metadata.get("video");
@@ -109,7 +149,7 @@ const std::string FileData::getVideoPath() const
 	if(video.empty())
 	{
 		std::string path = mEnvData->mStartPath + "/images/" + getDisplayName() + "-video.mp4";
-		if(boost::filesystem::exists(path))
+		if(mEnvData->mMediaIndex.exists(path))
 			video = path;
 	}
 
@@ -129,7 +169,7 @@ const std::string FileData::getMarqueePath() const
 			if(marquee.empty())
 			{
 				std::string path = mEnvData->mStartPath + "/images/" + getDisplayName() + "-marquee" + extList[i];
-				if(boost::filesystem::exists(path))
+				if(mEnvData->mMediaIndex.exists(path))
 					marquee = path;
 			}
 		}
@@ -151,7 +191,7 @@ const std::string FileData::getImagePath() const
 			if(image.empty())
 			{
 				std::string path = mEnvData->mStartPath + "/images/" + getDisplayName() + "-image" + extList[i];
-				if(boost::filesystem::exists(path))
+				if(mEnvData->mMediaIndex.exists(path))
 					image = path;
 			}
 		}
@@ -203,6 +243,13 @@ void FileData::addChild(FileData* file)
 		mChildrenByFilename[key] = file;
 		mChildren.push_back(file);
 		file->mParent = this;
+
+		const unsigned int games = (file->getType() == GAME) ? 1 : file->mGameCount;
+		for(FileData* folder = this; folder != NULL; folder = folder->mParent)
+		{
+			folder->mGameCount += games;
+			folder->mTreeVersion++;
+		}
 	}
 }
 
@@ -217,6 +264,13 @@ void FileData::removeChild(FileData* file)
 		{
 			file->mParent = NULL;
 			mChildren.erase(it);
+
+			const unsigned int games = (file->getType() == GAME) ? 1 : file->mGameCount;
+			for(FileData* folder = this; folder != NULL; folder = folder->mParent)
+			{
+				folder->mGameCount -= games;
+				folder->mTreeVersion++;
+			}
 			return;
 		}
 	}
@@ -226,9 +280,31 @@ void FileData::removeChild(FileData* file)
 
 }
 
+const FileData::SortKeys& FileData::getSortKeys() const
+{
+	// built on first use, a sort compares each FileData many times but metadata rarely changes in between
+	if(!mSortKeys || mSortKeys->metadataVersion != metadata.getVersion())
+	{
+		if(!mSortKeys)
+		{
+			mSortKeys.reset(new SortKeys());
+			mSortKeys->system = Utils::String::toUpper(mSystemName);
+		}
+
+		mSortKeys->metadataVersion = metadata.getVersion();
+		mSortKeys->name = Utils::String::toUpper(metadata.get(MD_ID_NAME));
+		mSortKeys->genre = Utils::String::toUpper(metadata.get(MD_ID_GENRE));
+		mSortKeys->developer = Utils::String::toUpper(metadata.get(MD_ID_DEVELOPER));
+		mSortKeys->publisher = Utils::String::toUpper(metadata.get(MD_ID_PUBLISHER));
+	}
+
+	return *mSortKeys;
+}
+
 void FileData::sort(ComparisonFunction& comparator, bool ascending)
 {
 	std::stable_sort(mChildren.begin(), mChildren.end(), comparator);
+	mTreeVersion++;
 
 	for(auto it = mChildren.cbegin(); it != mChildren.cend(); it++)
 	{
@@ -3,8 +3,10 @@
 #define ES_APP_FILE_DATA_H
 
 #include "MetaData.h"
+#include <memory>
 #include <unordered_map>
 
+class FileFilterIndex;
 class SystemData;
 class Window;
 struct SystemEnvironmentData;
@@ -49,6 +51,10 @@ public:
 	virtual const std::string getImagePath() const;
 
 	const std::vector<FileData*>& getChildrenListToDisplay();
+	inline unsigned int getGameCount() const { return mGameCount; }
+	// changes whenever a child is added or removed anywhere below this node
+	inline unsigned int getTreeVersion() const { return mTreeVersion; }
+	unsigned int getDisplayedGameCount() const;
 	std::vector<FileData*> getFilesRecursive(unsigned int typeMask, bool displayedOnly = false) const;
 
 	void addChild(FileData* file); // Error if mType != FOLDER
@@ -83,6 +89,19 @@ public:
 			: comparisonFunction(sortFunction), ascending(sortAscending), description(sortDescription) {}
 	};
 
+	// upper-cased copies of the strings FileSorts compares, rebuilt only when the metadata has changed since
+	struct SortKeys
+	{
+		unsigned int metadataVersion;
+		std::string name;
+		std::string genre;
+		std::string developer;
+		std::string publisher;
+		std::string system;
+	};
+
+	const SortKeys& getSortKeys() const;
+
 	void sort(ComparisonFunction& comparator, bool ascending = true);
 	void sort(const SortType& type);
 	MetaDataList metadata;
@@ -99,7 +118,24 @@ private:
 	SystemData* mSystem;
 	std::unordered_map<std::string,FileData*> mChildrenByFilename;
 	std::vector<FileData*> mChildren;
+	mutable std::unique_ptr<SortKeys> mSortKeys;
+
+	// games below this node, kept up to date by addChild()/removeChild()
+	unsigned int mGameCount;
+	// bumped on this node and its ancestors whenever a child is added or removed below it, and on sort()
+	unsigned int mTreeVersion;
+
+	// filtered results, valid while the tree, the filter index and all metadata they were built from are unchanged
+	// (metadata can change without going through the index, e.g. toggling a favorite)
 	std::vector<FileData*> mFilteredChildren;
+	FileFilterIndex* mFilteredChildrenIndex;
+	unsigned int mFilteredChildrenIndexVersion;
+	unsigned int mFilteredChildrenTreeVersion;
+	unsigned int mFilteredChildrenMetadataVersion;
+	mutable unsigned int mDisplayedGameCount;
+	mutable unsigned int mDisplayedGameCountIndexVersion;
+	mutable unsigned int mDisplayedGameCountTreeVersion;
+	mutable unsigned int mDisplayedGameCountMetadataVersion;
 };
 
 class CollectionFileData : public FileData
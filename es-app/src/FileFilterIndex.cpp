@@ -11,7 +11,7 @@
 #define INCLUDE_UNKNOWN false;
 
 FileFilterIndex::FileFilterIndex()
-	: filterByFavorites(false), filterByGenre(false), filterByHidden(false), filterByKidGame(false), filterByPlayers(false), filterByPubDev(false), filterByRatings(false)
+	: filterByFavorites(false), filterByGenre(false), filterByHidden(false), filterByKidGame(false), filterByPlayers(false), filterByPubDev(false), filterByRatings(false), mShownBitsDirty(true), mVersion(0)
 {
 	clearAllFilters();
 	FilterDataDecl filterDecls[] = {
@@ -84,6 +84,7 @@ void FileFilterIndex::resetIndex()
 	clearIndex(favoritesIndexAllKeys);
 	clearIndex(hiddenIndexAllKeys);
 	clearIndex(kidGameIndexAllKeys);
+	clearBitIndex();
 }
 
 std::string FileFilterIndex::getIndexableKey(FileData* game, FilterIndexType type, bool getSecondary)
@@ -93,12 +94,10 @@ std::string FileFilterIndex::getIndexableKey(FileData* game, FilterIndexType typ
 	{
 		case GENRE_FILTER:
 		{
-			key = strToUpper(game->metadata.get("genre"));
+			key = strToUpper(game->metadata.get(MD_ID_GENRE));
 			Utils::String::trim(key);
 			if (getSecondary && !key.empty()) {
-				std::istringstream f(key);
-				std::string newKey;
-				getline(f, newKey, '/');
+				std::string newKey = key.substr(0, key.find('/'));
 				if (!newKey.empty() && newKey != key)
 				{
 					key = newKey;
@@ -115,18 +114,18 @@ std::string FileFilterIndex::getIndexableKey(FileData* game, FilterIndexType typ
 			if (getSecondary)
 				break;
 
-			key = game->metadata.get("players");
+			key = game->metadata.get(MD_ID_PLAYERS);
 			break;
 		}
 		case PUBDEV_FILTER:
 		{
-			key = strToUpper(game->metadata.get("publisher"));
+			key = strToUpper(game->metadata.get(MD_ID_PUBLISHER));
 			Utils::String::trim(key);
 
 			if ((getSecondary && !key.empty()) || (!getSecondary && key.empty()))
-				key = strToUpper(game->metadata.get("developer"));
+				key = strToUpper(game->metadata.get(MD_ID_DEVELOPER));
 			else
-				key = strToUpper(game->metadata.get("publisher"));
+				key = strToUpper(game->metadata.get(MD_ID_PUBLISHER));
 			break;
 		}
 		case RATINGS_FILTER:
@@ -134,7 +133,7 @@ std::string FileFilterIndex::getIndexableKey(FileData* game, FilterIndexType typ
 			int ratingNumber = 0;
 			if (!getSecondary)
 			{
-				std::string ratingString = game->metadata.get("rating");
+				std::string ratingString = game->metadata.get(MD_ID_RATING);
 				if (!ratingString.empty()) {
 					try {
 						ratingNumber = (int)((std::stod(ratingString)*5)+0.5);
@@ -155,21 +154,21 @@ std::string FileFilterIndex::getIndexableKey(FileData* game, FilterIndexType typ
 		{
 			if (game->getType() != GAME)
 				return "FALSE";
-			key = strToUpper(game->metadata.get("favorite"));
+			key = strToUpper(game->metadata.get(MD_ID_FAVORITE));
 			break;
 		}
 		case HIDDEN_FILTER:
 		{
 			if (game->getType() != GAME)
 				return "FALSE";
-			key = strToUpper(game->metadata.get("hidden"));
+			key = strToUpper(game->metadata.get(MD_ID_HIDDEN));
 			break;
 		}
 		case KIDGAME_FILTER:
 		{
 			if (game->getType() != GAME)
 				return "FALSE";
-			key = strToUpper(game->metadata.get("kidgame"));
+			key = strToUpper(game->metadata.get(MD_ID_KIDGAME));
 			break;
 		}
 	}
@@ -189,6 +188,7 @@ void FileFilterIndex::addToIndex(FileData* game)
 	manageFavoritesEntryInIndex(game);
 	manageHiddenEntryInIndex(game);
 	manageKidGameEntryInIndex(game);
+	addToBitIndex(game);
 }
 
 void FileFilterIndex::removeFromIndex(FileData* game)
@@ -200,10 +200,13 @@ void FileFilterIndex::removeFromIndex(FileData* game)
 	manageFavoritesEntryInIndex(game, true);
 	manageHiddenEntryInIndex(game, true);
 	manageKidGameEntryInIndex(game, true);
+	removeFromBitIndex(game);
 }
 
 void FileFilterIndex::setFilter(FilterIndexType type, std::vector<std::string>* values)
 {
+	markDirty();
+
 	// test if it exists before setting
 	if(type == NONE)
 	{
@@ -231,6 +234,7 @@ void FileFilterIndex::setFilter(FilterIndexType type, std::vector<std::string>*
 
 void FileFilterIndex::clearAllFilters()
 {
+	markDirty();
 	for (std::vector<FilterDataDecl>::const_iterator it = filterDataDecl.cbegin(); it != filterDataDecl.cend(); ++it )
 	{
 		FilterDataDecl filterData = (*it);
@@ -297,7 +301,7 @@ bool FileFilterIndex::showFile(FileData* game)
 	// if folder, needs further inspection - i.e. see if folder contains at least one element
 	// that should be shown
 	if (game->getType() == FOLDER) {
-		std::vector<FileData*> children = game->getChildren();
+		const std::vector<FileData*>& children = game->getChildren();
 		// iterate through all of the children, until there's a match
 
 		for (std::vector<FileData*>::const_iterator it = children.cbegin(); it != children.cend(); ++it ) {
@@ -309,6 +313,28 @@ bool FileFilterIndex::showFile(FileData* game)
 		return false;
 	}
 
+	// games added to this index are answered from the bitsets, anything else (e.g. games shown through
+	// a collection bundle, which only imports the key counts) falls back to matching the metadata
+	auto ordinalIt = mFileOrdinals.find(game);
+	if (ordinalIt == mFileOrdinals.cend())
+		return matchesFilters(game);
+
+	// metadata can also be replaced without going through remove/addToIndex (e.g. by the scraper)
+	if (mOrdinalVersions[ordinalIt->second] != game->metadata.getVersion())
+	{
+		addToBitIndex(game);
+		ordinalIt = mFileOrdinals.find(game);
+	}
+
+	if (mShownBitsDirty)
+		updateShownBits();
+
+	const unsigned int ordinal = ordinalIt->second;
+	return (mShownBits[ordinal / 64] >> (ordinal % 64)) & 1;
+}
+
+bool FileFilterIndex::matchesFilters(FileData* game)
+{
 	bool keepGoing = false;
 
 	for (std::vector<FilterDataDecl>::const_iterator it = filterDataDecl.cbegin(); it != filterDataDecl.cend(); ++it ) {
@@ -533,4 +559,126 @@ void FileFilterIndex::manageIndexEntry(std::map<std::string, int>* index, std::s
 void FileFilterIndex::clearIndex(std::map<std::string, int> indexMap)
 {
 	indexMap.clear();
-}
\ No newline at end of file
+}
+
+void FileFilterIndex::addToBitIndex(FileData* game)
+{
+	if (mFileOrdinals.find(game) != mFileOrdinals.cend())
+		removeFromBitIndex(game);
+
+	unsigned int ordinal;
+	if (mFreeOrdinals.size() > 0)
+	{
+		ordinal = mFreeOrdinals.back();
+		mFreeOrdinals.pop_back();
+	}
+	else
+	{
+		ordinal = (unsigned int)mOrdinalKeys.size();
+		mOrdinalKeys.push_back(std::vector<std::pair<int, unsigned int>>());
+		mOrdinalVersions.push_back(0);
+	}
+	mFileOrdinals[game] = ordinal;
+	mOrdinalVersions[ordinal] = game->metadata.getVersion();
+
+	std::vector<std::pair<int, unsigned int>>& ordinalKeys = mOrdinalKeys[ordinal];
+	for (std::vector<FilterDataDecl>::const_iterator it = filterDataDecl.cbegin(); it != filterDataDecl.cend(); ++it )
+	{
+		// the same keys matchesFilters() would test: the primary key, and the secondary key if it's known
+		std::string keys[2] = { getIndexableKey(game, (*it).type, false), "" };
+		if ((*it).hasSecondaryKey)
+		{
+			keys[1] = getIndexableKey(game, (*it).type, true);
+			if (keys[1] == UNKNOWN_LABEL || keys[1] == keys[0])
+				keys[1] = "";
+		}
+
+		FilterBitIndex& bitIndex = mBitIndexes[(*it).type - 1];
+		for (int i = 0; i < 2; i++)
+		{
+			if (keys[i].empty())
+				continue;
+
+			auto idIt = bitIndex.keyIds.find(keys[i]);
+			if (idIt == bitIndex.keyIds.cend())
+			{
+				idIt = bitIndex.keyIds.insert(std::make_pair(keys[i], (unsigned int)bitIndex.keyBits.size())).first;
+				bitIndex.keyBits.push_back(std::vector<uint64_t>());
+			}
+
+			std::vector<uint64_t>& bits = bitIndex.keyBits[idIt->second];
+			if (bits.size() <= ordinal / 64)
+				bits.resize(ordinal / 64 + 1, 0);
+			bits[ordinal / 64] |= (uint64_t)1 << (ordinal % 64);
+
+			ordinalKeys.push_back(std::make_pair((int)(*it).type, idIt->second));
+		}
+	}
+
+	markDirty();
+}
+
+void FileFilterIndex::removeFromBitIndex(FileData* game)
+{
+	auto ordinalIt = mFileOrdinals.find(game);
+	if (ordinalIt == mFileOrdinals.cend())
+		return;
+
+	const unsigned int ordinal = ordinalIt->second;
+	std::vector<std::pair<int, unsigned int>>& ordinalKeys = mOrdinalKeys[ordinal];
+	for (auto it = ordinalKeys.cbegin(); it != ordinalKeys.cend(); ++it)
+		mBitIndexes[it->first - 1].keyBits[it->second][ordinal / 64] &= ~((uint64_t)1 << (ordinal % 64));
+
+	ordinalKeys.clear();
+	mFreeOrdinals.push_back(ordinal);
+	mFileOrdinals.erase(ordinalIt);
+	markDirty();
+}
+
+void FileFilterIndex::clearBitIndex()
+{
+	for (int i = 0; i < KIDGAME_FILTER; i++)
+	{
+		mBitIndexes[i].keyIds.clear();
+		mBitIndexes[i].keyBits.clear();
+	}
+
+	mFileOrdinals.clear();
+	mOrdinalKeys.clear();
+	mOrdinalVersions.clear();
+	mFreeOrdinals.clear();
+	mShownBits.clear();
+	markDirty();
+}
+
+// ANDs together, for every active filter, the OR of the bitsets of the keys being filtered for
+void FileFilterIndex::updateShownBits()
+{
+	const size_t words = (mOrdinalKeys.size() + 63) / 64;
+	mShownBits.assign(words, ~(uint64_t)0);
+
+	std::vector<uint64_t> matching;
+	for (std::vector<FilterDataDecl>::const_iterator it = filterDataDecl.cbegin(); it != filterDataDecl.cend(); ++it )
+	{
+		if (!*((*it).filteredByRef))
+			continue;
+
+		const FilterBitIndex& bitIndex = mBitIndexes[(*it).type - 1];
+		matching.assign(words, 0);
+		for (std::vector<std::string>::const_iterator keyIt = (*it).currentFilteredKeys->cbegin(); keyIt != (*it).currentFilteredKeys->cend(); ++keyIt )
+		{
+			auto idIt = bitIndex.keyIds.find(*keyIt);
+			if (idIt == bitIndex.keyIds.cend())
+				continue;
+
+			const std::vector<uint64_t>& bits = bitIndex.keyBits[idIt->second];
+			for (size_t i = 0; i < bits.size() && i < words; i++)
+				matching[i] |= bits[i];
+		}
+
+		for (size_t i = 0; i < words; i++)
+			mShownBits[i] &= matching[i];
+	}
+
+	mShownBitsDirty = false;
+}
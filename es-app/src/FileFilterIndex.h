@@ -2,8 +2,10 @@
 #ifndef ES_APP_FILE_FILTER_INDEX_H
 #define ES_APP_FILE_FILTER_INDEX_H
 
+#include <stdint.h>
 #include <map>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 class FileData;
@@ -32,6 +34,13 @@ struct FilterDataDecl
 	std::string menuLabel; // text to show in menu
 };
 
+// dense ids for the keys of one filter type, and for each key the files (by ordinal) that match it
+struct FilterBitIndex
+{
+	std::unordered_map<std::string, unsigned int> keyIds;
+	std::vector<std::vector<uint64_t>> keyBits;
+};
+
 class FileFilterIndex
 {
 public:
@@ -47,6 +56,9 @@ public:
 	bool isKeyBeingFilteredBy(std::string key, FilterIndexType type);
 	std::vector<FilterDataDecl>& getFilterDataDecls();
 
+	// changes whenever the filters or the indexed games change, so results of showFile() can be cached
+	inline unsigned int getVersion() const { return mVersion; }
+
 	void importIndex(FileFilterIndex* indexToImport);
 	void resetIndex();
 	void resetFilters();
@@ -55,6 +67,13 @@ public:
 private:
 	std::vector<FilterDataDecl> filterDataDecl;
 	std::string getIndexableKey(FileData* game, FilterIndexType type, bool getSecondary);
+	bool matchesFilters(FileData* game);
+
+	void addToBitIndex(FileData* game);
+	void removeFromBitIndex(FileData* game);
+	void clearBitIndex();
+	void updateShownBits();
+	inline void markDirty() { mShownBitsDirty = true; mVersion++; }
 
 	void manageGenreEntryInIndex(FileData* game, bool remove = false);
 	void managePlayerEntryInIndex(FileData* game, bool remove = false);
@@ -92,6 +111,16 @@ private:
 	std::vector<std::string> hiddenIndexFilteredKeys;
 	std::vector<std::string> kidGameIndexFilteredKeys;
 
+	// inverted index of the games added to this index, so applying filters is bitset work instead of string matching
+	FilterBitIndex mBitIndexes[KIDGAME_FILTER];
+	std::unordered_map<FileData*, unsigned int> mFileOrdinals;
+	std::vector<std::vector<std::pair<int, unsigned int>>> mOrdinalKeys; // (filter type, key id) bits set per ordinal
+	std::vector<unsigned int> mOrdinalVersions; // metadata version each ordinal was indexed with
+	std::vector<unsigned int> mFreeOrdinals;
+	std::vector<uint64_t> mShownBits;
+	bool mShownBitsDirty;
+	unsigned int mVersion;
+
 	FileData* mRootFolder;
 
 };
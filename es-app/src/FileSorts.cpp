@@ -1,7 +1,5 @@
 #include "FileSorts.h"
 
-#include "utils/StringUtil.h"
-
 namespace FileSorts
 {
 	const FileData::SortType typesArr[] = {
@@ -42,14 +40,12 @@ namespace FileSorts
 	bool compareName(const FileData* file1, const FileData* file2)
 	{
 		// we compare the actual metadata name, as collection files have the system appended which messes up the order
-		std::string name1 = Utils::String::toUpper(file1->metadata.get("name"));
-		std::string name2 = Utils::String::toUpper(file2->metadata.get("name"));
-		return name1.compare(name2) < 0;
+		return file1->getSortKeys().name.compare(file2->getSortKeys().name) < 0;
 	}
 
 	bool compareRating(const FileData* file1, const FileData* file2)
 	{
-		return file1->metadata.getFloat("rating") < file2->metadata.getFloat("rating");
+		return file1->metadata.getFloat(MD_ID_RATING) < file2->metadata.getFloat(MD_ID_RATING);
 	}
 
 	bool compareTimesPlayed(const FileData* file1, const FileData* file2)
@@ -57,7 +53,7 @@ namespace FileSorts
 		//only games have playcount metadata
 		if(file1->metadata.getType() == GAME_METADATA && file2->metadata.getType() == GAME_METADATA)
 		{
-			return (file1)->metadata.getInt("playcount") < (file2)->metadata.getInt("playcount");
+			return (file1)->metadata.getInt(MD_ID_PLAYCOUNT) < (file2)->metadata.getInt(MD_ID_PLAYCOUNT);
 		}
 
 		return false;
@@ -65,48 +61,38 @@ namespace FileSorts
 
 	bool compareLastPlayed(const FileData* file1, const FileData* file2)
 	{
-		// since it's stored as an ISO string (YYYYMMDDTHHMMSS), we can compare as a string
-		// as it's a lot faster than the time casts and then time comparisons
-		return (file1)->metadata.get("lastplayed") < (file2)->metadata.get("lastplayed");
+		// dates are kept decoded as YYYYMMDDhhmmss integers, so this is a plain integer comparison
+		return (file1)->metadata.getDate(MD_ID_LASTPLAYED) < (file2)->metadata.getDate(MD_ID_LASTPLAYED);
 	}
 
 	bool compareNumPlayers(const FileData* file1, const FileData* file2)
 	{
-		return (file1)->metadata.getInt("players") < (file2)->metadata.getInt("players");
+		return (file1)->metadata.getInt(MD_ID_PLAYERS) < (file2)->metadata.getInt(MD_ID_PLAYERS);
 	}
 
 	bool compareReleaseDate(const FileData* file1, const FileData* file2)
 	{
-		// since it's stored as an ISO string (YYYYMMDDTHHMMSS), we can compare as a string
-		// as it's a lot faster than the time casts and then time comparisons
-		return (file1)->metadata.get("releasedate") < (file2)->metadata.get("releasedate");
+		// dates are kept decoded as YYYYMMDDhhmmss integers, so this is a plain integer comparison
+		return (file1)->metadata.getDate(MD_ID_RELEASEDATE) < (file2)->metadata.getDate(MD_ID_RELEASEDATE);
 	}
 
 	bool compareGenre(const FileData* file1, const FileData* file2)
 	{
-		std::string genre1 = Utils::String::toUpper(file1->metadata.get("genre"));
-		std::string genre2 = Utils::String::toUpper(file2->metadata.get("genre"));
-		return genre1.compare(genre2) < 0;
+		return file1->getSortKeys().genre.compare(file2->getSortKeys().genre) < 0;
 	}
 
 	bool compareDeveloper(const FileData* file1, const FileData* file2)
 	{
-		std::string developer1 = Utils::String::toUpper(file1->metadata.get("developer"));
-		std::string developer2 = Utils::String::toUpper(file2->metadata.get("developer"));
-		return developer1.compare(developer2) < 0;
+		return file1->getSortKeys().developer.compare(file2->getSortKeys().developer) < 0;
 	}
 
 	bool comparePublisher(const FileData* file1, const FileData* file2)
 	{
-		std::string publisher1 = Utils::String::toUpper(file1->metadata.get("publisher"));
-		std::string publisher2 = Utils::String::toUpper(file2->metadata.get("publisher"));
-		return publisher1.compare(publisher2) < 0;
+		return file1->getSortKeys().publisher.compare(file2->getSortKeys().publisher) < 0;
 	}
 
 	bool compareSystem(const FileData* file1, const FileData* file2)
 	{
-		std::string system1 = Utils::String::toUpper(file1->getSystemName());
-		std::string system2 = Utils::String::toUpper(file2->getSystemName());
-		return system1.compare(system2) < 0;
+		return file1->getSortKeys().system.compare(file2->getSortKeys().system) < 0;
 	}
 };
@@ -3,11 +3,13 @@
 #include "FileData.h"
 #include "FileFilterIndex.h"
 #include "Log.h"
+#include "platform.h"
 #include "Settings.h"
 #include "SystemData.h"
 #include "Util.h"
 #include <boost/filesystem/operations.hpp>
 #include <pugixml/src/pugixml.hpp>
+#include <unordered_map>
 
 FileData* findOrCreateFile(SystemData* system, const boost::filesystem::path& path, FileType type, bool trustGamelist)
 {
@@ -169,6 +171,31 @@ void addFileDataNode(pugi::xml_node& parent, const FileData* file, const char* t
 	}
 }
 
+// key used to match gamelist entries to FileDatas without touching the disk:
+// the path resolved against the system's start path, with "." and ".." folded and made relative to it when possible
+static std::string getGamelistPathKey(const boost::filesystem::path& path, const boost::filesystem::path& startPath)
+{
+	boost::filesystem::path resolved = resolvePath(path, startPath, true);
+	boost::filesystem::path folded;
+	for(auto it = resolved.begin(); it != resolved.end(); ++it)
+	{
+		if(*it == ".")
+			continue;
+
+		if(*it == ".." && folded.has_filename() && folded.filename() != "..")
+			folded.remove_filename();
+		else
+			folded /= *it;
+	}
+
+	std::string key = folded.generic_string();
+	std::string prefix = startPath.generic_string() + "/";
+	if(key.compare(0, prefix.size(), prefix) == 0)
+		return key.substr(prefix.size());
+
+	return key;
+}
+
 void updateGamelist(SystemData* system)
 {
 	//We do this by reading the XML again, adding changes and then writing it back,
@@ -211,6 +238,29 @@ void updateGamelist(SystemData* system)
 	if (rootFolder != nullptr)
 	{
 		int numUpdated = 0;
+		const boost::filesystem::path startPath = system->getStartPath();
+
+		// index the existing entries by path once, instead of searching the whole XML for every changed file
+		std::unordered_map<std::string, pugi::xml_node> gameIndex;
+		std::unordered_map<std::string, pugi::xml_node> folderIndex;
+		const char* tagList[2] = { "game", "folder" };
+		std::unordered_map<std::string, pugi::xml_node>* indexList[2] = { &gameIndex, &folderIndex };
+		for(int i = 0; i < 2; i++)
+		{
+			const char* tag = tagList[i];
+			for(pugi::xml_node fileNode = root.child(tag); fileNode; fileNode = fileNode.next_sibling(tag))
+			{
+				pugi::xml_node pathNode = fileNode.child("path");
+				if(!pathNode)
+				{
+					LOG(LogError) << "<" << tag << "> node contains no <path> child!";
+					continue;
+				}
+
+				// keep the first entry for a path, like the old linear search did
+				indexList[i]->insert(std::make_pair(getGamelistPathKey(pathNode.text().get(), startPath), fileNode));
+			}
+		}
 
 		//get only files, no folders
 		std::vector<FileData*> files = rootFolder->getFilesRecursive(GAME | FOLDER);
@@ -230,23 +280,12 @@ void updateGamelist(SystemData* system)
 
 			// check if the file already exists in the XML
 			// if it does, remove it before adding
-			for(pugi::xml_node fileNode = root.child(tag); fileNode; fileNode = fileNode.next_sibling(tag))
+			std::unordered_map<std::string, pugi::xml_node>& index = ((*fit)->getType() == GAME) ? gameIndex : folderIndex;
+			auto nodeIt = index.find(getGamelistPathKey((*fit)->getPath(), startPath));
+			if(nodeIt != index.cend())
 			{
-				pugi::xml_node pathNode = fileNode.child("path");
-				if(!pathNode)
-				{
-					LOG(LogError) << "<" << tag << "> node contains no <path> child!";
-					continue;
-				}
-
-				boost::filesystem::path nodePath = resolvePath(pathNode.text().get(), system->getStartPath(), true);
-				boost::filesystem::path gamePath((*fit)->getPath());
-				if(nodePath == gamePath || (boost::filesystem::exists(nodePath) && boost::filesystem::exists(gamePath) && boost::filesystem::equivalent(nodePath, gamePath)))
-				{
-					// found it
-					root.remove_child(fileNode);
-					break;
-				}
+				root.remove_child(nodeIt->second);
+				index.erase(nodeIt);
 			}
 
 			// it was either removed or never existed to begin with; either way, we can add it now
@@ -263,8 +302,33 @@ void updateGamelist(SystemData* system)
 
 			LOG(LogInfo) << "Added/Updated " << numUpdated << " entities in '" << xmlReadPath << "'";
 
-			if (!doc.save_file(xmlWritePath.c_str())) {
-				LOG(LogError) << "Error saving gamelist.xml to \"" << xmlWritePath << "\" (for system " << system->getName() << ")!";
+			// write through a temporary file so an interrupted save can never leave a truncated gamelist behind,
+			// it has to be on the disk before the rename or a power loss may still leave an empty gamelist
+			boost::filesystem::path xmlTempPath(xmlWritePath.generic_string() + ".tmp");
+			boost::system::error_code ec;
+#ifdef WIN32
+			FILE* file = _wfopen(xmlTempPath.c_str(), L"wb");
+#else
+			FILE* file = fopen(xmlTempPath.c_str(), "wb");
+#endif
+			bool saved = false;
+			if (file != NULL) {
+				pugi::xml_writer_file writer(file);
+				doc.save(writer);
+				saved = !ferror(file) && syncFile(file);
+				saved = (fclose(file) == 0) && saved;
+			}
+
+			if (!saved) {
+				LOG(LogError) << "Error saving gamelist.xml to \"" << xmlTempPath << "\" (for system " << system->getName() << ")!";
+				boost::filesystem::remove(xmlTempPath, ec);
+			}else{
+				boost::filesystem::rename(xmlTempPath, xmlWritePath, ec);
+				if(ec)
+				{
+					LOG(LogError) << "Error saving gamelist.xml to \"" << xmlWritePath << "\" (for system " << system->getName() << "): " << ec.message();
+					boost::filesystem::remove(xmlTempPath, ec);
+				}
 			}
 		}
 	}else{
@@ -0,0 +1,61 @@
+#include "MediaIndex.h"
+
+#include "utils/StringUtil.h"
+#include "Log.h"
+#include <boost/filesystem/operations.hpp>
+
+MediaIndex::MediaIndex() : mValid(false)
+{
+}
+
+void MediaIndex::build(const std::string& startPath)
+{
+	mStartPath = startPath;
+	mFiles.clear();
+
+	addFolder(mStartPath + "/images");
+
+	mValid = true;
+}
+
+void MediaIndex::addFolder(const std::string& folder)
+{
+	boost::system::error_code ec;
+	if(!boost::filesystem::is_directory(folder, ec))
+		return;
+
+	for(boost::filesystem::directory_iterator end, dir(folder, ec); !ec && dir != end; dir.increment(ec))
+		mFiles.insert(getKey(folder + "/" + dir->path().filename().string()));
+
+	if(ec)
+		LOG(LogWarning) << "Error listing media folder \"" << folder << "\": " << ec.message();
+}
+
+void MediaIndex::invalidate()
+{
+	mValid = false;
+	mFiles.clear();
+}
+
+bool MediaIndex::exists(const std::string& path)
+{
+	if(!mValid)
+	{
+		if(mStartPath.empty())
+			return boost::filesystem::exists(path);
+
+		build(mStartPath);
+	}
+
+	return mFiles.find(getKey(path)) != mFiles.cend();
+}
+
+std::string MediaIndex::getKey(const std::string& path)
+{
+#if defined(WIN32) || defined(__APPLE__)
+	// "Game-Image.PNG" is found when looking for "Game-image.png" on the filesystems these default to
+	return Utils::String::toUpper(path);
+#else
+	return path;
+#endif
+}
@@ -0,0 +1,37 @@
+#pragma once
+#ifndef ES_APP_MEDIA_INDEX_H
+#define ES_APP_MEDIA_INDEX_H
+
+#include <string>
+#include <unordered_set>
+
+// A listing of the local media folder of a system ([startpath]/images, where local videos live too).
+// FileData uses it to check for local images, marquees and videos without touching the filesystem
+// on every lookup. Whoever writes new files into that folder must call invalidate().
+class MediaIndex
+{
+public:
+	MediaIndex();
+
+	// Lists the media folder below startPath, replacing any previous listing.
+	void build(const std::string& startPath);
+
+	// Drops the listing, the folders are listed again on the next lookup.
+	void invalidate();
+
+	// Returns true if path is one of the listed media files, ignoring case where the filesystem usually does.
+	// path must be built as [startpath]/images/[file].
+	bool exists(const std::string& path);
+
+private:
+	void addFolder(const std::string& folder);
+
+	// how a path is stored in mFiles, upper-cased on Windows and macOS
+	static std::string getKey(const std::string& path);
+
+	std::string mStartPath;
+	std::unordered_set<std::string> mFiles;
+	bool mValid;
+};
+
+#endif // ES_APP_MEDIA_INDEX_H
@@ -3,42 +3,48 @@
 #include "Log.h"
 #include "Util.h"
 #include <pugixml/src/pugixml.hpp>
+#include <limits.h>
+#include <string.h>
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
 
 MetaDataDecl gameDecls[] = {
-	// key,         type,                   default,            statistic,  name in GuiMetaDataEd,  prompt in GuiMetaDataEd
-	{"name",        MD_STRING,              "",                 false,      "name",                 "enter game name"},
-	{"desc",        MD_MULTILINE_STRING,    "",                 false,      "description",          "enter description"},
-	{"image",       MD_PATH,                "",                 false,      "image",                "enter path to image"},
-	{"video",       MD_PATH     ,           "",                 false,      "video",                "enter path to video"},
-	{"marquee",     MD_PATH,                "",                 false,      "marquee",              "enter path to marquee"},
-	{"thumbnail",   MD_PATH,                "",                 false,      "thumbnail",            "enter path to thumbnail"},
-	{"rating",      MD_RATING,              "0.000000",         false,      "rating",               "enter rating"},
-	{"releasedate", MD_DATE,                "not-a-date-time",  false,      "release date",         "enter release date"},
-	{"developer",   MD_STRING,              "unknown",          false,      "developer",            "enter game developer"},
-	{"publisher",   MD_STRING,              "unknown",          false,      "publisher",            "enter game publisher"},
-	{"genre",       MD_STRING,              "unknown",          false,      "genre",                "enter game genre"},
-	{"players",     MD_INT,                 "1",                false,      "players",              "enter number of players"},
-	{"favorite",    MD_BOOL,                "false",            false,      "favorite",             "enter favorite off/on"},
-	{"hidden",      MD_BOOL,                "false",            false,      "hidden",               "enter hidden off/on" },
-	{"kidgame",     MD_BOOL,                "false",            false,      "kidgame",              "enter kidgame off/on" },
-	{"playcount",   MD_INT,                 "0",                true,       "play count",           "enter number of times played"},
-	{"lastplayed",  MD_TIME,                "0",                true,       "last played",          "enter last played date"}
+	// id,              key,           type,                   default,            statistic,  name in GuiMetaDataEd,  prompt in GuiMetaDataEd
+	{MD_ID_NAME,        "name",        MD_STRING,              "",                 false,      "name",                 "enter game name"},
+	{MD_ID_DESC,        "desc",        MD_MULTILINE_STRING,    "",                 false,      "description",          "enter description"},
+	{MD_ID_IMAGE,       "image",       MD_PATH,                "",                 false,      "image",                "enter path to image"},
+	{MD_ID_VIDEO,       "video",       MD_PATH,                "",                 false,      "video",                "enter path to video"},
+	{MD_ID_MARQUEE,     "marquee",     MD_PATH,                "",                 false,      "marquee",              "enter path to marquee"},
+	{MD_ID_THUMBNAIL,   "thumbnail",   MD_PATH,                "",                 false,      "thumbnail",            "enter path to thumbnail"},
+	{MD_ID_RATING,      "rating",      MD_RATING,              "0.000000",         false,      "rating",               "enter rating"},
+	{MD_ID_RELEASEDATE, "releasedate", MD_DATE,                "not-a-date-time",  false,      "release date",         "enter release date"},
+	{MD_ID_DEVELOPER,   "developer",   MD_STRING,              "unknown",          false,      "developer",            "enter game developer"},
+	{MD_ID_PUBLISHER,   "publisher",   MD_STRING,              "unknown",          false,      "publisher",            "enter game publisher"},
+	{MD_ID_GENRE,       "genre",       MD_STRING,              "unknown",          false,      "genre",                "enter game genre"},
+	{MD_ID_PLAYERS,     "players",     MD_INT,                 "1",                false,      "players",              "enter number of players"},
+	{MD_ID_FAVORITE,    "favorite",    MD_BOOL,                "false",            false,      "favorite",             "enter favorite off/on"},
+	{MD_ID_HIDDEN,      "hidden",      MD_BOOL,                "false",            false,      "hidden",               "enter hidden off/on" },
+	{MD_ID_KIDGAME,     "kidgame",     MD_BOOL,                "false",            false,      "kidgame",              "enter kidgame off/on" },
+	{MD_ID_PLAYCOUNT,   "playcount",   MD_INT,                 "0",                true,       "play count",           "enter number of times played"},
+	{MD_ID_LASTPLAYED,  "lastplayed",  MD_TIME,                "0",                true,       "last played",          "enter last played date"}
 };
 const std::vector<MetaDataDecl> gameMDD(gameDecls, gameDecls + sizeof(gameDecls) / sizeof(gameDecls[0]));
 
 MetaDataDecl folderDecls[] = {
-	{"name",        MD_STRING,              "",                 false,      "name",                 "enter game name"},
-	{"desc",        MD_MULTILINE_STRING,    "",                 false,      "description",          "enter description"},
-	{"image",       MD_PATH,                "",                 false,      "image",                "enter path to image"},
-	{"thumbnail",   MD_PATH,                "",                 false,      "thumbnail",            "enter path to thumbnail"},
-	{"video",       MD_PATH,                "",                 false,      "video",                "enter path to video"},
-	{"marquee",     MD_PATH,                "",                 false,      "marquee",              "enter path to marquee"},
-	{"rating",      MD_RATING,              "0.000000",         false,      "rating",               "enter rating"},
-	{"releasedate", MD_DATE,                "not-a-date-time",  false,      "release date",         "enter release date"},
-	{"developer",   MD_STRING,              "unknown",          false,      "developer",            "enter game developer"},
-	{"publisher",   MD_STRING,              "unknown",          false,      "publisher",            "enter game publisher"},
-	{"genre",       MD_STRING,              "unknown",          false,      "genre",                "enter game genre"},
-	{"players",     MD_INT,                 "1",                false,      "players",              "enter number of players"}
+	{MD_ID_NAME,        "name",        MD_STRING,              "",                 false,      "name",                 "enter game name"},
+	{MD_ID_DESC,        "desc",        MD_MULTILINE_STRING,    "",                 false,      "description",          "enter description"},
+	{MD_ID_IMAGE,       "image",       MD_PATH,                "",                 false,      "image",                "enter path to image"},
+	{MD_ID_THUMBNAIL,   "thumbnail",   MD_PATH,                "",                 false,      "thumbnail",            "enter path to thumbnail"},
+	{MD_ID_VIDEO,       "video",       MD_PATH,                "",                 false,      "video",                "enter path to video"},
+	{MD_ID_MARQUEE,     "marquee",     MD_PATH,                "",                 false,      "marquee",              "enter path to marquee"},
+	{MD_ID_RATING,      "rating",      MD_RATING,              "0.000000",         false,      "rating",               "enter rating"},
+	{MD_ID_RELEASEDATE, "releasedate", MD_DATE,                "not-a-date-time",  false,      "release date",         "enter release date"},
+	{MD_ID_DEVELOPER,   "developer",   MD_STRING,              "unknown",          false,      "developer",            "enter game developer"},
+	{MD_ID_PUBLISHER,   "publisher",   MD_STRING,              "unknown",          false,      "publisher",            "enter game publisher"},
+	{MD_ID_GENRE,       "genre",       MD_STRING,              "unknown",          false,      "genre",                "enter game genre"},
+	{MD_ID_PLAYERS,     "players",     MD_INT,                 "1",                false,      "players",              "enter number of players"}
 };
 const std::vector<MetaDataDecl> folderMDD(folderDecls, folderDecls + sizeof(folderDecls) / sizeof(folderDecls[0]));
 
@@ -58,14 +64,244 @@ const std::vector<MetaDataDecl>& getMDDByType(MetaDataListType type)
 
 
 
+// Interned metadata strings, shared by every MetaDataList.
+// Most fields (defaults, genres, developers, ratings, player counts...) only have a handful of distinct values
+// across a whole library, so each one is stored once. Default values are pinned and never reference counted.
+// The pool is never destroyed, so MetaDataLists that outlive main() can still release their strings.
+class MetaDataStringPool
+{
+public:
+	static MetaDataStringPool* getInstance()
+	{
+		static MetaDataStringPool* sInstance = new MetaDataStringPool();
+		return sInstance;
+	}
+
+	const MetaDataPoolEntry* intern(const std::string& value)
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		auto it = mStrings.find(value);
+		if(it == mStrings.cend())
+			it = mStrings.insert(MetaDataPoolEntry(value, 0)).first;
+
+		if(it->second != PINNED)
+			it->second++;
+
+		return &(*it);
+	}
+
+	const MetaDataPoolEntry* pin(const std::string& value)
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		MetaDataPoolEntry& entry = *(mStrings.insert(MetaDataPoolEntry(value, 0)).first);
+		entry.second = PINNED;
+		return &entry;
+	}
+
+	// locked versions are used when a whole MetaDataList is copied or destroyed, to only take the lock once
+	inline std::mutex& getMutex() { return mMutex; }
+
+	inline void retainLocked(const MetaDataPoolEntry* entry)
+	{
+		if(entry->second != PINNED)
+			const_cast<MetaDataPoolEntry*>(entry)->second++;
+	}
+
+	inline void releaseLocked(const MetaDataPoolEntry* entry)
+	{
+		if(entry->second == PINNED)
+			return;
+
+		// erase by iterator, the key would be a reference into the element being erased
+		if(--(const_cast<MetaDataPoolEntry*>(entry)->second) == 0)
+			mStrings.erase(mStrings.find(entry->first));
+	}
+
+	void release(const MetaDataPoolEntry* entry)
+	{
+		// the count is only read under the lock, pin() may turn an interned entry into a pinned one at any time
+		std::unique_lock<std::mutex> lock(mMutex);
+		releaseLocked(entry);
+	}
+
+private:
+	static const unsigned int PINNED = (unsigned int)-1;
+
+	std::mutex mMutex;
+	std::unordered_map<std::string, unsigned int> mStrings;
+};
+
+// per-field type and pinned default, taken from gameDecls (which declares every field)
+struct MetaDataFieldInfo
+{
+	MetaDataType type;
+	const MetaDataPoolEntry* defaultValue;
+};
+
+static const MetaDataFieldInfo* getFieldInfo()
+{
+	static MetaDataFieldInfo* sFields = NULL;
+	static std::once_flag sOnce;
+	std::call_once(sOnce, []
+	{
+		sFields = new MetaDataFieldInfo[MD_ID_COUNT];
+		for(auto it = gameMDD.cbegin(); it != gameMDD.cend(); it++)
+		{
+			sFields[it->id].type = it->type;
+			sFields[it->id].defaultValue = MetaDataStringPool::getInstance()->pin(it->defaultValue);
+		}
+		for(auto it = folderMDD.cbegin(); it != folderMDD.cend(); it++)
+			MetaDataStringPool::getInstance()->pin(it->defaultValue);
+	});
+
+	return sFields;
+}
+
+static std::atomic<unsigned int> sVersionCounter(0);
+
+unsigned int MetaDataList::getLatestVersion()
+{
+	return sVersionCounter;
+}
+
+MetaDataId getMetaDataId(const std::string& key)
+{
+	static std::unordered_map<std::string, MetaDataId> sIds = []
+	{
+		std::unordered_map<std::string, MetaDataId> ids;
+		for(auto it = gameMDD.cbegin(); it != gameMDD.cend(); it++)
+			ids[it->key] = it->id;
+		return ids;
+	}();
+
+	auto it = sIds.find(key);
+	return it != sIds.cend() ? it->second : MD_ID_COUNT;
+}
+
+// "19950101T000000" -> 19950101000000, partial dates are padded ("1995" -> 19950000000000) so they still sort correctly
+// "0" and "" decode to 0 and anything without digits ("not-a-date-time") to the largest value,
+// the same order the strings used to sort in
+static long long decodeDate(const std::string& value)
+{
+	if(value.empty() || value == "0")
+		return 0;
+
+	long long date = 0;
+	int digits = 0;
+	for(auto it = value.cbegin(); it != value.cend() && digits < 14; it++)
+	{
+		if(*it >= '0' && *it <= '9')
+		{
+			date = date * 10 + (*it - '0');
+			digits++;
+		}
+		else if(*it != 'T')
+		{
+			break;
+		}
+	}
+
+	if(digits == 0)
+		return LLONG_MAX;
+
+	for(; digits < 14; digits++)
+		date *= 10;
+
+	return date;
+}
+
 MetaDataList::MetaDataList(MetaDataListType type)
-	: mType(type), mWasChanged(false)
+	: mType(type), mWasChanged(false), mVersion(0)
 {
+	const MetaDataFieldInfo* fields = getFieldInfo();
+	for(int i = 0; i < MD_ID_COUNT; i++)
+	{
+		mSlots[i].string = fields[i].defaultValue;
+		mSlots[i].i = 0;
+		mSlots[i].f = 0.0f;
+		mSlots[i].decoded = 0;
+	}
+
+	// folders may declare different defaults than games, and the decoded values must match the strings
 	const std::vector<MetaDataDecl>& mdd = getMDD();
 	for(auto iter = mdd.cbegin(); iter != mdd.cend(); iter++)
-		set(iter->key, iter->defaultValue);
+		set(iter->id, iter->defaultValue);
+	for(int i = 0; i < MD_ID_COUNT; i++)
+	{
+		if(mSlots[i].string == fields[i].defaultValue)
+			set((MetaDataId)i, fields[i].defaultValue->first);
+	}
+
+	mWasChanged = false;
+}
+
+// a copy gets a version of its own, or caches keyed on the version could take it for the original
+MetaDataList::MetaDataList(const MetaDataList& other)
+	: mType(other.mType), mWasChanged(other.mWasChanged), mVersion(++sVersionCounter)
+{
+	memcpy(mSlots, other.mSlots, sizeof(mSlots));
+	retainAll();
+}
+
+MetaDataList::MetaDataList(MetaDataList&& other)
+	: mType(other.mType), mWasChanged(other.mWasChanged), mVersion(++sVersionCounter)
+{
+	// take over other's references and leave it holding pinned defaults only
+	memcpy(mSlots, other.mSlots, sizeof(mSlots));
+
+	const MetaDataFieldInfo* fields = getFieldInfo();
+	for(int i = 0; i < MD_ID_COUNT; i++)
+		other.mSlots[i].string = fields[i].defaultValue;
+	other.mVersion = ++sVersionCounter;
+}
+
+MetaDataList::~MetaDataList()
+{
+	releaseAll();
+}
+
+MetaDataList& MetaDataList::operator=(const MetaDataList& other)
+{
+	if(this == &other)
+		return *this;
+
+	MetaDataList copy(other);
+	return *this = std::move(copy);
 }
 
+MetaDataList& MetaDataList::operator=(MetaDataList&& other)
+{
+	if(this == &other)
+		return *this;
+
+	mType = other.mType;
+	mWasChanged = other.mWasChanged;
+	mVersion = ++sVersionCounter;
+
+	Slot slots[MD_ID_COUNT];
+	memcpy(slots, mSlots, sizeof(mSlots));
+	memcpy(mSlots, other.mSlots, sizeof(mSlots));
+	memcpy(other.mSlots, slots, sizeof(mSlots));
+	other.mVersion = ++sVersionCounter;
+
+	return *this;
+}
+
+void MetaDataList::retainAll()
+{
+	MetaDataStringPool* pool = MetaDataStringPool::getInstance();
+	std::unique_lock<std::mutex> lock(pool->getMutex());
+	for(int i = 0; i < MD_ID_COUNT; i++)
+		pool->retainLocked(mSlots[i].string);
+}
+
+void MetaDataList::releaseAll()
+{
+	MetaDataStringPool* pool = MetaDataStringPool::getInstance();
+	std::unique_lock<std::mutex> lock(pool->getMutex());
+	for(int i = 0; i < MD_ID_COUNT; i++)
+		pool->releaseLocked(mSlots[i].string);
+}
 
 MetaDataList MetaDataList::createFromXML(MetaDataListType type, pugi::xml_node& node, const boost::filesystem::path& relativeTo)
 {
@@ -84,9 +320,9 @@ MetaDataList MetaDataList::createFromXML(MetaDataListType type, pugi::xml_node&
 			{
 				value = resolvePath(value, relativeTo, true).generic_string();
 			}
-			mdl.set(iter->key, value);
+			mdl.set(iter->id, value);
 		}else{
-			mdl.set(iter->key, iter->defaultValue);
+			mdl.set(iter->id, iter->defaultValue);
 		}
 	}
 
@@ -99,51 +335,95 @@ void MetaDataList::appendToXML(pugi::xml_node& parent, bool ignoreDefaults, cons
 
 	for(auto mddIter = mdd.cbegin(); mddIter != mdd.cend(); mddIter++)
 	{
-		auto mapIter = mMap.find(mddIter->key);
-		if(mapIter != mMap.cend())
-		{
-			// we have this value!
-			// if it's just the default (and we ignore defaults), don't write it
-			if(ignoreDefaults && mapIter->second == mddIter->defaultValue)
-				continue;
-			
-			// try and make paths relative if we can
-			std::string value = mapIter->second;
-			if (mddIter->type == MD_PATH)
-				value = makeRelativePath(value, relativeTo, true).generic_string();
-
-			parent.append_child(mapIter->first.c_str()).text().set(value.c_str());
-		}
+		const std::string& value = get(mddIter->id);
+
+		// if it's just the default (and we ignore defaults), don't write it
+		if(ignoreDefaults && value == mddIter->defaultValue)
+			continue;
+
+		// try and make paths relative if we can
+		if (mddIter->type == MD_PATH)
+			parent.append_child(mddIter->key.c_str()).text().set(makeRelativePath(value, relativeTo, true).generic_string().c_str());
+		else
+			parent.append_child(mddIter->key.c_str()).text().set(value.c_str());
 	}
 }
 
 void MetaDataList::set(const std::string& key, const std::string& value)
 {
-	mMap[key] = value;
+	MetaDataId id = getMetaDataId(key);
+	if(id == MD_ID_COUNT)
+	{
+		LOG(LogError) << "Tried to set unknown metadata \"" << key << "\"";
+		return;
+	}
+
+	set(id, value);
+}
+
+void MetaDataList::set(MetaDataId id, const std::string& value)
+{
+	Slot& slot = mSlots[id];
+	MetaDataStringPool* pool = MetaDataStringPool::getInstance();
+
+	if(slot.string->first != value)
+	{
+		const MetaDataPoolEntry* old = slot.string;
+		slot.string = pool->intern(value);
+		pool->release(old);
+	}
+
+	slot.i = atoi(value.c_str());
+	slot.f = (float)atof(value.c_str());
+	switch(getFieldInfo()[id].type)
+	{
+	case MD_DATE:
+	case MD_TIME:
+		slot.decoded = decodeDate(value);
+		break;
+	case MD_BOOL:
+		slot.decoded = (value == "true") ? 1 : 0;
+		break;
+	default:
+		slot.decoded = 0;
+		break;
+	}
+
 	mWasChanged = true;
+	mVersion = ++sVersionCounter;
+}
+
+// reading an unknown key throws, like the std::map::at() the string-keyed getters used to be
+static MetaDataId getKnownMetaDataId(const std::string& key)
+{
+	MetaDataId id = getMetaDataId(key);
+	if(id == MD_ID_COUNT)
+		throw std::out_of_range("Unknown metadata \"" + key + "\"");
+
+	return id;
 }
 
 const std::string& MetaDataList::get(const std::string& key) const
 {
-	return mMap.at(key);
+	return get(getKnownMetaDataId(key));
 }
 
 int MetaDataList::getInt(const std::string& key) const
 {
-	return atoi(get(key).c_str());
+	return getInt(getKnownMetaDataId(key));
 }
 
 float MetaDataList::getFloat(const std::string& key) const
 {
-	return (float)atof(get(key).c_str());
+	return getFloat(getKnownMetaDataId(key));
 }
 
 bool MetaDataList::isDefault()
 {
 	const std::vector<MetaDataDecl>& mdd = getMDD();
 
-	for (unsigned int i = 1; i < mMap.size(); i++) {
-		if (mMap.at(mdd[i].key) != mdd[i].defaultValue) return false;
+	for (unsigned int i = 1; i < mdd.size(); i++) {
+		if (get(mdd[i].id) != mdd[i].defaultValue) return false;
 	}
 
 	return true;
@@ -3,7 +3,9 @@
 #define ES_APP_META_DATA_H
 
 #include <boost/filesystem/path.hpp>
-#include <map>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace pugi { class xml_node; }
 
@@ -23,8 +25,33 @@ enum MetaDataType
 	MD_TIME //used for lastplayed
 };
 
+// every field that can appear in gameDecls or folderDecls, used as the slot index in MetaDataList
+enum MetaDataId
+{
+	MD_ID_NAME,
+	MD_ID_DESC,
+	MD_ID_IMAGE,
+	MD_ID_VIDEO,
+	MD_ID_MARQUEE,
+	MD_ID_THUMBNAIL,
+	MD_ID_RATING,
+	MD_ID_RELEASEDATE,
+	MD_ID_DEVELOPER,
+	MD_ID_PUBLISHER,
+	MD_ID_GENRE,
+	MD_ID_PLAYERS,
+	MD_ID_FAVORITE,
+	MD_ID_HIDDEN,
+	MD_ID_KIDGAME,
+	MD_ID_PLAYCOUNT,
+	MD_ID_LASTPLAYED,
+
+	MD_ID_COUNT
+};
+
 struct MetaDataDecl
 {
+	MetaDataId id;
 	std::string key;
 	MetaDataType type;
 	std::string defaultValue;
@@ -41,6 +68,17 @@ enum MetaDataListType
 
 const std::vector<MetaDataDecl>& getMDDByType(MetaDataListType type);
 
+// returns MD_ID_COUNT if key isn't a known metadata field
+MetaDataId getMetaDataId(const std::string& key);
+
+// an interned metadata string and its reference count, owned by the string pool in MetaData.cpp
+typedef std::pair<const std::string, unsigned int> MetaDataPoolEntry;
+
+// Metadata for one FileData, stored as one slot per MetaDataId.
+// Every value is kept as an interned string (so the string-keyed get() can keep returning a reference);
+// every value is additionally stored decoded so getInt()/getFloat()/getBool()/getDate() never have to parse.
+// getInt()/getFloat() are atoi()/atof() of the string whatever the field's type, boolean fields decode "true" to 1
+// for getBool(), and dates are decoded to a sortable YYYYMMDDhhmmss integer for getDate().
 class MetaDataList
 {
 public:
@@ -48,25 +86,55 @@ public:
 	void appendToXML(pugi::xml_node& parent, bool ignoreDefaults, const boost::filesystem::path& relativeTo) const;
 
 	MetaDataList(MetaDataListType type);
-	
+	MetaDataList(const MetaDataList& other);
+	MetaDataList(MetaDataList&& other);
+	~MetaDataList();
+
+	MetaDataList& operator=(const MetaDataList& other);
+	MetaDataList& operator=(MetaDataList&& other);
+
 	void set(const std::string& key, const std::string& value);
+	void set(MetaDataId id, const std::string& value);
 
 	const std::string& get(const std::string& key) const;
 	int getInt(const std::string& key) const;
 	float getFloat(const std::string& key) const;
 
+	inline const std::string& get(MetaDataId id) const { return mSlots[id].string->first; }
+	inline int getInt(MetaDataId id) const { return mSlots[id].i; }
+	inline float getFloat(MetaDataId id) const { return mSlots[id].f; }
+	inline bool getBool(MetaDataId id) const { return mSlots[id].decoded != 0; }
+	inline long long getDate(MetaDataId id) const { return mSlots[id].decoded; }
+
 	bool isDefault();
 
 	bool wasChanged() const;
 	void resetChangedFlag();
 
+	// changes on every set(), copy and assignment, and is never reused by another list, so caches derived from the values can check it
+	inline unsigned int getVersion() const { return mVersion; }
+	// the version handed out by the latest set() on any list, caches derived from all metadata can check it
+	static unsigned int getLatestVersion();
+
 	inline MetaDataListType getType() const { return mType; }
 	inline const std::vector<MetaDataDecl>& getMDD() const { return getMDDByType(getType()); }
 
 private:
+	struct Slot
+	{
+		const MetaDataPoolEntry* string;
+		int i;
+		float f;
+		long long decoded; // MD_BOOL: 0/1, MD_DATE and MD_TIME: the date, 0 for other types
+	};
+
+	void retainAll();
+	void releaseAll();
+
 	MetaDataListType mType;
-	std::map<std::string, std::string> mMap;
+	Slot mSlots[MD_ID_COUNT];
 	bool mWasChanged;
+	unsigned int mVersion;
 };
 
 #endif // ES_APP_META_DATA_H
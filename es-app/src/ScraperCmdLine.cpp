@@ -222,6 +222,7 @@ int run_scraper_cmdline()
 					if(choice >= 0 && choice < (int)mdls.size())
 					{
 						params.game->metadata = mdls.at(choice);
+						params.game->getSystemEnvData()->mMediaIndex.invalidate();
 						break;
 					}else{
 						out << "Invalid choice.\n";
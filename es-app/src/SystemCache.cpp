@@ -0,0 +1,256 @@
+#include "SystemCache.h"
+
+#include "utils/CacheStream.h"
+#include "FileData.h"
+#include "Log.h"
+#include "platform.h"
+#include "Settings.h"
+#include "SystemData.h"
+#include <boost/filesystem/operations.hpp>
+#include <ctime>
+#include <fstream>
+
+// bump this whenever the layout below changes, old cache entries are then simply rebuilt
+#define SYSTEM_CACHE_MAGIC   "ESSC"
+#define SYSTEM_CACHE_VERSION 1
+
+// cache entry layout (native endianness, the cache is never shared between machines):
+//   magic, version, start path, extensions, scan flags, metadata declaration counts,
+//   gamelist path/mtime/size, scanned folders with their mtimes,
+//   then the FileData tree below the root folder, depth first:
+//   type, path, non-default metadata as (declaration index, value) pairs, and for folders their children
+
+static std::string getSystemCachePath(SystemData* system)
+{
+	return getHomePath() + "/.emulationstation/cache/systems/" + system->getName() + ".bin";
+}
+
+// everything that changes the result of populateFolder()/parseGamelist() without touching the disk
+static void writeCacheHeader(CacheWriter& writer, SystemData* system)
+{
+	writer.writeString(SYSTEM_CACHE_MAGIC);
+	writer.writeU32(SYSTEM_CACHE_VERSION);
+	writer.writeString(system->getStartPath());
+
+	const std::vector<std::string>& extensions = system->getExtensions();
+	writer.writeU32((uint32_t)extensions.size());
+	for(auto it = extensions.cbegin(); it != extensions.cend(); it++)
+		writer.writeString(*it);
+
+	writer.writeU8(Settings::getInstance()->getBool("ParseGamelistOnly"));
+	writer.writeU8(Settings::getInstance()->getBool("IgnoreGamelist"));
+	writer.writeU8(Settings::getInstance()->getBool("ShowHiddenFiles"));
+	writer.writeU32((uint32_t)getMDDByType(GAME_METADATA).size());
+	writer.writeU32((uint32_t)getMDDByType(FOLDER_METADATA).size());
+}
+
+static void writeCacheNode(CacheWriter& writer, const FileData* file)
+{
+	writer.writeU8((uint8_t)file->getType());
+	writer.writeString(file->getPath().generic_string());
+
+	// only store what differs from a freshly constructed FileData
+	const std::vector<MetaDataDecl>& mdd = file->metadata.getMDD();
+	std::vector<uint8_t> changed;
+	for(unsigned int i = 0; i < mdd.size(); i++)
+	{
+		if(file->metadata.get(mdd.at(i).id) != mdd.at(i).defaultValue)
+			changed.push_back((uint8_t)i);
+	}
+
+	writer.writeU8((uint8_t)changed.size());
+	for(auto it = changed.cbegin(); it != changed.cend(); it++)
+	{
+		writer.writeU8(*it);
+		writer.writeString(file->metadata.get(mdd.at(*it).id));
+	}
+
+	if(file->getType() == FOLDER)
+	{
+		const std::vector<FileData*>& children = file->getChildren();
+		writer.writeU32((uint32_t)children.size());
+		for(auto it = children.cbegin(); it != children.cend(); it++)
+			writeCacheNode(writer, *it);
+	}
+}
+
+static bool readCacheNode(CacheReader& reader, SystemData* system, FileData* parent)
+{
+	FileType type = (FileType)reader.readU8();
+	std::string path = reader.readString();
+	if(!reader.ok() || (type != GAME && type != FOLDER))
+		return false;
+
+	FileData* file = new FileData(type, path, system->getSystemEnvData(), system);
+
+	const std::vector<MetaDataDecl>& mdd = file->metadata.getMDD();
+	unsigned int count = reader.readU8();
+	for(unsigned int i = 0; i < count; i++)
+	{
+		unsigned int index = reader.readU8();
+		std::string value = reader.readString();
+		if(!reader.ok() || index >= mdd.size())
+		{
+			delete file;
+			return false;
+		}
+
+		file->metadata.set(mdd.at(index).id, value);
+	}
+	file->metadata.resetChangedFlag();
+
+	parent->addChild(file);
+
+	if(type == FOLDER)
+	{
+		unsigned int childCount = reader.readU32();
+		for(unsigned int i = 0; i < childCount; i++)
+		{
+			if(!readCacheNode(reader, system, file))
+				return false;
+		}
+	}
+
+	return reader.ok();
+}
+
+bool loadSystemCache(SystemData* system)
+{
+	if(!Settings::getInstance()->getBool("SystemCache"))
+		return false;
+
+	std::string cachePath = getSystemCachePath(system);
+
+	// one sequential read, everything else happens in memory
+	std::ifstream file(cachePath.c_str(), std::ios::in | std::ios::binary);
+	if(!file.is_open())
+		return false;
+
+	std::string buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	file.close();
+
+	CacheWriter expectedHeader;
+	writeCacheHeader(expectedHeader, system);
+	if(buffer.compare(0, expectedHeader.getBuffer().size(), expectedHeader.getBuffer()) != 0)
+	{
+		LOG(LogInfo) << "System cache for \"" << system->getName() << "\" is out of date (configuration changed)";
+		return false;
+	}
+
+	const std::string body = buffer.substr(expectedHeader.getBuffer().size());
+	CacheReader reader(body);
+	boost::system::error_code ec;
+
+	// the gamelist must be the same file, untouched since the entry was written
+	std::string gamelistPath = reader.readString();
+	int64_t gamelistTime = reader.readI64();
+	int64_t gamelistSize = reader.readI64();
+	std::string currentGamelistPath = Settings::getInstance()->getBool("IgnoreGamelist") ? "" : system->getGamelistPath(false);
+	if(!boost::filesystem::exists(currentGamelistPath, ec))
+		currentGamelistPath = "";
+
+	if(currentGamelistPath != gamelistPath ||
+		(!gamelistPath.empty() && ((int64_t)boost::filesystem::last_write_time(gamelistPath, ec) != gamelistTime || (int64_t)boost::filesystem::file_size(gamelistPath, ec) != gamelistSize || ec)))
+	{
+		LOG(LogInfo) << "System cache for \"" << system->getName() << "\" is out of date (gamelist changed)";
+		return false;
+	}
+
+	// a file being added or removed changes the modification time of the folder holding it
+	unsigned int folderCount = reader.readU32();
+	for(unsigned int i = 0; i < folderCount && reader.ok(); i++)
+	{
+		std::string folderPath = reader.readString();
+		int64_t folderTime = reader.readI64();
+		if((int64_t)boost::filesystem::last_write_time(folderPath, ec) != folderTime || ec)
+		{
+			LOG(LogInfo) << "System cache for \"" << system->getName() << "\" is out of date (\"" << folderPath << "\" changed)";
+			return false;
+		}
+	}
+
+	FileData* root = system->getRootFolder();
+	unsigned int childCount = reader.readU32();
+	for(unsigned int i = 0; i < childCount && reader.ok(); i++)
+	{
+		if(!readCacheNode(reader, system, root))
+			break;
+	}
+
+	if(!reader.ok())
+	{
+		LOG(LogWarning) << "System cache \"" << cachePath << "\" is corrupt, rebuilding it";
+
+		// throw away whatever was read, the caller will fill the root folder the slow way
+		while(root->getChildren().size() > 0)
+			delete root->getChildren().back();
+		return false;
+	}
+
+	LOG(LogInfo) << "Loaded system \"" << system->getName() << "\" from cache";
+	return true;
+}
+
+void writeSystemCache(SystemData* system, const std::vector<std::string>& scannedFolders)
+{
+	if(!Settings::getInstance()->getBool("SystemCache"))
+		return;
+
+	CacheWriter writer;
+	writeCacheHeader(writer, system);
+	boost::system::error_code ec;
+
+	std::string gamelistPath = Settings::getInstance()->getBool("IgnoreGamelist") ? "" : system->getGamelistPath(false);
+	if(!boost::filesystem::exists(gamelistPath, ec))
+		gamelistPath = "";
+
+	writer.writeString(gamelistPath);
+	writer.writeI64(gamelistPath.empty() ? 0 : (int64_t)boost::filesystem::last_write_time(gamelistPath, ec));
+	writer.writeI64(gamelistPath.empty() ? 0 : (int64_t)boost::filesystem::file_size(gamelistPath, ec));
+
+	// modification times only have a resolution of one second, so a folder that changed during this second
+	// could change again without its time moving; don't cache it until it has settled
+	const std::time_t now = std::time(NULL);
+
+	writer.writeU32((uint32_t)scannedFolders.size());
+	for(auto it = scannedFolders.cbegin(); it != scannedFolders.cend(); it++)
+	{
+		std::time_t folderTime = boost::filesystem::last_write_time(*it, ec);
+		if(folderTime >= now - 1)
+			return;
+
+		writer.writeString(*it);
+		writer.writeI64((int64_t)folderTime);
+	}
+
+	const std::vector<FileData*>& children = system->getRootFolder()->getChildren();
+	writer.writeU32((uint32_t)children.size());
+	for(auto it = children.cbegin(); it != children.cend(); it++)
+		writeCacheNode(writer, *it);
+
+	// write through a temporary file so a partially written entry is never picked up
+	boost::filesystem::path cachePath(getSystemCachePath(system));
+	boost::filesystem::path tempPath(cachePath.generic_string() + ".tmp");
+	boost::filesystem::create_directories(cachePath.parent_path(), ec);
+
+	std::ofstream file(tempPath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if(!file.is_open())
+	{
+		LOG(LogWarning) << "Could not open \"" << tempPath << "\" for writing";
+		return;
+	}
+
+	file.write(writer.getBuffer().data(), writer.getBuffer().size());
+	file.close();
+
+	if(file.fail())
+	{
+		LOG(LogWarning) << "Error writing system cache \"" << tempPath << "\"";
+		boost::filesystem::remove(tempPath, ec);
+		return;
+	}
+
+	boost::filesystem::rename(tempPath, cachePath, ec);
+	if(ec)
+		LOG(LogWarning) << "Error writing system cache \"" << cachePath << "\": " << ec.message();
+}
@@ -0,0 +1,18 @@
+#pragma once
+#ifndef ES_APP_SYSTEM_CACHE_H
+#define ES_APP_SYSTEM_CACHE_H
+
+#include <string>
+#include <vector>
+
+class SystemData;
+
+// Loads the FileData tree and metadata of a SystemData from its binary cache in ~/.emulationstation/cache/.
+// Returns false (and leaves the system untouched) if there is no cache entry or it is out of date.
+bool loadSystemCache(SystemData* system);
+
+// Writes the FileData tree and metadata of a SystemData to its binary cache.
+// scannedFolders are the folders walked by the ROM scan, their modification times are used to invalidate the entry.
+void writeSystemCache(SystemData* system, const std::vector<std::string>& scannedFolders);
+
+#endif // ES_APP_SYSTEM_CACHE_H
@@ -7,10 +7,15 @@
 #include "Log.h"
 #include "platform.h"
 #include "Settings.h"
+#include "SystemCache.h"
 #include "ThemeData.h"
+#include "Window.h"
 #include <boost/filesystem/operations.hpp>
 #include <pugixml/src/pugixml.hpp>
+#include <condition_variable>
 #include <fstream>
+#include <mutex>
+#include <thread>
 #ifdef WIN32
 #include <Windows.h>
 #endif
@@ -28,11 +33,20 @@ SystemData::SystemData(const std::string& name, const std::string& fullName, Sys
 		mRootFolder = new FileData(FOLDER, mEnvData->mStartPath, mEnvData, this);
 		mRootFolder->metadata.set("name", mFullName);
 
-		if(!Settings::getInstance()->getBool("ParseGamelistOnly"))
-			populateFolder(mRootFolder);
+		mEnvData->mMediaIndex.build(mEnvData->mStartPath);
 
-		if(!Settings::getInstance()->getBool("IgnoreGamelist"))
-			parseGamelist(this);
+		if(!loadSystemCache(this))
+		{
+			std::vector<std::string> scannedFolders;
+
+			if(!Settings::getInstance()->getBool("ParseGamelistOnly"))
+				populateFolder(mRootFolder, scannedFolders);
+
+			if(!Settings::getInstance()->getBool("IgnoreGamelist"))
+				parseGamelist(this);
+
+			writeSystemCache(this, scannedFolders);
+		}
 
 		mRootFolder->sort(FileSorts::SortTypes.at(0));
 
@@ -44,7 +58,9 @@ SystemData::SystemData(const std::string& name, const std::string& fullName, Sys
 		mRootFolder = new FileData(FOLDER, "" + name, mEnvData, this);
 	}
 	setIsGameSystemStatus();
-	loadTheme();
+
+	// the theme is loaded separately with loadTheme(), on the main thread,
+	// so that game systems can be built from loader threads
 }
 
 SystemData::~SystemData()
@@ -79,7 +95,7 @@ bool isHidden(const boost::filesystem::path &filePath)
 #endif
 }
 
-void SystemData::populateFolder(FileData* folder)
+void SystemData::populateFolder(FileData* folder, std::vector<std::string>& scannedFolders)
 {
 	const boost::filesystem::path& folderPath = folder->getPath();
 	if(!boost::filesystem::is_directory(folderPath))
@@ -89,6 +105,7 @@ void SystemData::populateFolder(FileData* folder)
 	}
 
 	const std::string folderStr = folderPath.generic_string();
+	scannedFolders.push_back(folderStr);
 
 	//make sure that this isn't a symlink to a thing we already have
 	if(boost::filesystem::is_symlink(folderPath))
@@ -135,7 +152,7 @@ void SystemData::populateFolder(FileData* folder)
 		if(!isGame && boost::filesystem::is_directory(filePath))
 		{
 			FileData* newFolder = new FileData(FOLDER, filePath.generic_string(), mEnvData, this);
-			populateFolder(newFolder);
+			populateFolder(newFolder, scannedFolders);
 
 			//ignore folders that do not contain games
 			if(newFolder->getChildrenByFilename().size() == 0)
@@ -177,8 +194,92 @@ std::vector<std::string> readList(const std::string& str, const char* delims = "
 	return ret;
 }
 
+// builds the FileData tree, gamelist and filter index of every pending system
+// if "ThreadedLoading" is set, systems are built on a pool of worker threads while the
+// calling thread updates the loading screen; the returned vector is in the same order as pendingSystems
+std::vector<SystemData*> SystemData::loadSystems(const std::vector<PendingSystem>& pendingSystems, Window* window)
+{
+	std::vector<SystemData*> systems(pendingSystems.size(), NULL);
+	const unsigned int total = (unsigned int)pendingSystems.size();
+	const bool showProgress = (window != NULL) && Settings::getInstance()->getBool("SplashScreen");
+
+	unsigned int threadCount = std::thread::hardware_concurrency();
+	if(threadCount == 0)
+		threadCount = 2;
+	if(threadCount > total)
+		threadCount = total;
+
+	if(!Settings::getInstance()->getBool("ThreadedLoading") || threadCount <= 1)
+	{
+		for(unsigned int i = 0; i < total; i++)
+		{
+			const PendingSystem& pending = pendingSystems.at(i);
+			systems[i] = new SystemData(pending.name, pending.fullName, pending.envData, pending.themeFolder);
+
+			if(showProgress)
+				window->renderLoadingScreen("LOADING SYSTEMS... " + std::to_string(i + 1) + "/" + std::to_string(total));
+		}
+
+		return systems;
+	}
+
+	LOG(LogInfo) << "Loading " << total << " systems using " << threadCount << " threads";
+
+	std::mutex mutex;
+	std::condition_variable finishedCondition;
+	unsigned int nextSystem = 0;
+	unsigned int finishedSystems = 0;
+
+	auto worker = [&]()
+	{
+		while(true)
+		{
+			unsigned int index;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				if(nextSystem >= total)
+					return;
+				index = nextSystem++;
+			}
+
+			const PendingSystem& pending = pendingSystems.at(index);
+			SystemData* newSys = new SystemData(pending.name, pending.fullName, pending.envData, pending.themeFolder);
+
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				systems[index] = newSys;
+				finishedSystems++;
+			}
+			finishedCondition.notify_one();
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for(unsigned int i = 0; i < threadCount; i++)
+		threads.push_back(std::thread(worker));
+
+	// GL may only be used from this thread, so the loading screen is redrawn here as workers finish
+	unsigned int reportedSystems = 0;
+	while(reportedSystems < total)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			finishedCondition.wait(lock, [&] { return finishedSystems > reportedSystems; });
+			reportedSystems = finishedSystems;
+		}
+
+		if(showProgress)
+			window->renderLoadingScreen("LOADING SYSTEMS... " + std::to_string(reportedSystems) + "/" + std::to_string(total));
+	}
+
+	for(auto it = threads.begin(); it != threads.end(); it++)
+		it->join();
+
+	return systems;
+}
+
 //creates systems from information located in a config file
-bool SystemData::loadConfig()
+bool SystemData::loadConfig(Window* window)
 {
 	deleteSystems();
 
@@ -212,6 +313,8 @@ bool SystemData::loadConfig()
 		return false;
 	}
 
+	std::vector<PendingSystem> pendingSystems;
+
 	for(pugi::xml_node system = systemList.child("system"); system; system = system.next_sibling("system"))
 	{
 		std::string name, fullname, path, cmd, themeFolder;
@@ -277,12 +380,24 @@ bool SystemData::loadConfig()
 		envData->mLaunchCommand = cmd;
 		envData->mPlatformIds = platformIds;
 
-		SystemData* newSys = new SystemData(name, fullname, envData, themeFolder);
+		pendingSystems.push_back(PendingSystem { name, fullname, envData, themeFolder });
+	}
+
+	std::vector<SystemData*> loadedSystems = loadSystems(pendingSystems, window);
+
+	// the themes of all systems (and collections) below share their parsed includes
+	ThemeData::IncludeCacheScope includeCache;
+
+	// insert the systems in the order they appear in es_systems.cfg, regardless of the order they finished loading in
+	for(unsigned int i = 0; i < loadedSystems.size(); i++)
+	{
+		SystemData* newSys = loadedSystems.at(i);
 		if(newSys->getRootFolder()->getChildrenByFilename().size() == 0)
 		{
-			LOG(LogWarning) << "System \"" << name << "\" has no games! Ignoring it.";
+			LOG(LogWarning) << "System \"" << newSys->getName() << "\" has no games! Ignoring it.";
 			delete newSys;
 		}else{
+			newSys->loadTheme();
 			sSystemVector.push_back(newSys);
 		}
 	}
@@ -431,7 +546,7 @@ bool SystemData::hasGamelist() const
 
 unsigned int SystemData::getGameCount() const
 {
-	return (unsigned int)mRootFolder->getFilesRecursive(GAME).size();
+	return mRootFolder->getGameCount();
 }
 
 SystemData* SystemData::getRandomSystem()
@@ -479,7 +594,7 @@ FileData* SystemData::getRandomGame()
 
 unsigned int SystemData::getDisplayedGameCount() const
 {
-	return (unsigned int)mRootFolder->getFilesRecursive(GAME, true).size();
+	return mRootFolder->getDisplayedGameCount();
 }
 
 void SystemData::loadTheme()
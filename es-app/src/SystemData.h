@@ -2,6 +2,7 @@
 #ifndef ES_APP_SYSTEM_DATA_H
 #define ES_APP_SYSTEM_DATA_H
 
+#include "MediaIndex.h"
 #include "PlatformId.h"
 #include <algorithm>
 #include <memory>
@@ -11,6 +12,7 @@
 class FileData;
 class FileFilterIndex;
 class ThemeData;
+class Window;
 
 struct SystemEnvironmentData
 {
@@ -18,6 +20,7 @@ struct SystemEnvironmentData
 	std::vector<std::string> mSearchExtensions;
 	std::string mLaunchCommand;
 	std::vector<PlatformIds::PlatformId> mPlatformIds;
+	MediaIndex mMediaIndex;
 };
 
 class SystemData
@@ -46,7 +49,7 @@ public:
 	unsigned int getDisplayedGameCount() const;
 
 	static void deleteSystems();
-	static bool loadConfig(); //Load the system config file at getConfigPath(). Returns true if no errors were encountered. An example will be written if the file doesn't exist.
+	static bool loadConfig(Window* window = NULL); //Load the system config file at getConfigPath(). Returns true if no errors were encountered. An example will be written if the file doesn't exist. If window is set, loading progress is drawn to it.
 	static void writeExampleConfig(const std::string& path);
 	static std::string getConfigPath(bool forWrite); // if forWrite, will only return ~/.emulationstation/es_systems.cfg, never /etc/emulationstation/es_systems.cfg
 
@@ -68,6 +71,16 @@ public:
 	FileFilterIndex* getIndex() { return mFilterIndex; };
 
 private:
+	struct PendingSystem
+	{
+		std::string name;
+		std::string fullName;
+		SystemEnvironmentData* envData;
+		std::string themeFolder;
+	};
+
+	static std::vector<SystemData*> loadSystems(const std::vector<PendingSystem>& pendingSystems, Window* window);
+
 	bool mIsCollectionSystem;
 	bool mIsGameSystem;
 	std::string mName;
@@ -76,7 +89,7 @@ private:
 	std::string mThemeFolder;
 	std::shared_ptr<ThemeData> mTheme;
 
-	void populateFolder(FileData* folder);
+	void populateFolder(FileData* folder, std::vector<std::string>& scannedFolders);
 	void indexAllGameFilters(const FileData* folder);
 	void setIsGameSystemStatus();
 
@@ -15,8 +15,6 @@
 #include "SystemData.h"
 #include "Util.h"
 #include <boost/filesystem/operations.hpp>
-#include <pugixml/src/pugixml.hpp>
-#include <unordered_map>
 
 #define FADE_TIME 			300
 
@@ -24,10 +22,9 @@ SystemScreenSaver::SystemScreenSaver(Window* window) :
 	mVideoScreensaver(NULL),
 	mImageScreensaver(NULL),
 	mWindow(window),
-	mVideosCounted(false),
-	mVideoCount(0),
-	mImagesCounted(false),
-	mImageCount(0),
+	mIndexedMetadataVersion(0),
+	mIndexBuilt(false),
+	mRandomEngine((unsigned int)time(NULL)),
 	mState(STATE_INACTIVE),
 	mOpacity(0.0f),
 	mTimer(0),
@@ -80,14 +77,7 @@ void SystemScreenSaver::startScreenSaver()
 		std::string path = "";
 		pickRandomVideo(path);
 
-		int retry = 200;
-		while(retry > 0 && ((path.empty() || !boost::filesystem::exists(path)) || mCurrentGame == NULL))
-		{
-			retry--;
-			pickRandomVideo(path);
-		}
-
-		if (!path.empty() && boost::filesystem::exists(path))
+		if (!path.empty())
 		{
 #ifdef _RPI_
 			// Create the correct type of video component
@@ -256,161 +246,81 @@ void SystemScreenSaver::renderScreenSaver()
 	}
 }
 
-unsigned long SystemScreenSaver::countGameListNodes(const char *nodeName)
+void SystemScreenSaver::updateMediaIndex()
 {
-	unsigned long nodeCount = 0;
-	std::vector<SystemData*>::const_iterator it;
-	for (it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); ++it)
+	// We only want images and videos from game systems that are not collections
+	std::vector<std::pair<SystemData*, unsigned int> > trees;
+	for (auto it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); ++it)
 	{
-		// We only want images and videos from game systems that are not collections
 		if (!(*it)->isCollection() && (*it)->isGameSystem())
-		{
-			pugi::xml_document doc;
-			pugi::xml_node root;
-			std::string xmlReadPath = (*it)->getGamelistPath(false);
-
-			if(boost::filesystem::exists(xmlReadPath))
-			{
-				pugi::xml_parse_result result = doc.load_file(xmlReadPath.c_str());
-				if (!result)
-					continue;
-				root = doc.child("gameList");
-				if (!root)
-					continue;
-				for(pugi::xml_node fileNode = root.child("game"); fileNode; fileNode = fileNode.next_sibling("game"))
-				{
-					pugi::xml_node node = fileNode.child(nodeName);
-					if (node)
-						++nodeCount;
-				}
-			}
-		}
+			trees.push_back(std::make_pair(*it, (*it)->getRootFolder()->getTreeVersion()));
 	}
-	return nodeCount;
-}
 
-void SystemScreenSaver::countVideos()
-{
-	if (!mVideosCounted)
-	{
-		mVideoCount = countGameListNodes("video");
-		mVideosCounted = true;
-	}
-}
+	if (mIndexBuilt && trees == mIndexedTrees && mIndexedMetadataVersion == MetaDataList::getLatestVersion())
+		return;
 
-void SystemScreenSaver::countImages()
-{
-	if (!mImagesCounted)
+	mVideoIndex.clear();
+	mImageIndex.clear();
+	for (auto it = trees.cbegin(); it != trees.cend(); ++it)
 	{
-		mImageCount = countGameListNodes("image");
-		mImagesCounted = true;
+		std::vector<FileData*> games = it->first->getRootFolder()->getFilesRecursive(GAME);
+		for (auto game = games.cbegin(); game != games.cend(); ++game)
+		{
+			MediaEntry entry;
+			entry.game = *game;
+
+			entry.path = (*game)->getVideoPath();
+			if (!entry.path.empty())
+				mVideoIndex.push_back(entry);
+
+			entry.path = (*game)->getImagePath();
+			if (!entry.path.empty())
+				mImageIndex.push_back(entry);
+		}
 	}
+
+	mIndexedTrees = trees;
+	mIndexedMetadataVersion = MetaDataList::getLatestVersion();
+	mIndexBuilt = true;
 }
 
-void SystemScreenSaver::pickGameListNode(unsigned long index, const char *nodeName, std::string& path)
+void SystemScreenSaver::pickRandomMedia(std::vector<MediaEntry>& index, std::string& path)
 {
-	std::vector<SystemData*>::const_iterator it;
-	for (it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); ++it)
+	while (!index.empty())
 	{
-		pugi::xml_document doc;
-		pugi::xml_node root;
-
-		// We only want nodes from game systems that are not collections
-		if (!(*it)->isGameSystem() || (*it)->isCollection())
-			continue;
-
-		std::string xmlReadPath = (*it)->getGamelistPath(false);
-
-		if(boost::filesystem::exists(xmlReadPath))
+		// rand() % size favors the first entries whenever size doesn't divide RAND_MAX + 1
+		size_t pick = std::uniform_int_distribution<size_t>(0, index.size() - 1)(mRandomEngine);
+		if (boost::filesystem::exists(index[pick].path))
 		{
-			pugi::xml_parse_result result = doc.load_file(xmlReadPath.c_str());
-			if (!result)
-				continue;
-			root = doc.child("gameList");
-			if (!root)
-				continue;
-			for(pugi::xml_node fileNode = root.child("game"); fileNode; fileNode = fileNode.next_sibling("game"))
-			{
-				pugi::xml_node node = fileNode.child(nodeName);
-				if (node)
-				{
-					// See if this is the desired index
-					if (index-- == 0)
-					{
-						// Yes. Resolve to a full path
-						path = resolvePath(node.text().get(), (*it)->getStartPath(), true).generic_string();
-						mSystemName = (*it)->getFullName();
-						mGameName = fileNode.child("name").text().get();
-
-						// getting corresponding FileData
-
-						// try the easy way. Should work for the majority of cases, unless in subfolders
-						FileData* rootFileData = (*it)->getRootFolder();
-						std::string gamePath = resolvePath(fileNode.child("path").text().get(), (*it)->getStartPath(), false).string();
-
-						std::string shortPath = gamePath;
-						shortPath = shortPath.replace(0, (*it)->getStartPath().length()+1, "");
-
-						const std::unordered_map<std::string, FileData*>& children = rootFileData->getChildrenByFilename();
-						std::unordered_map<std::string, FileData*>::const_iterator screenSaverGame = children.find(shortPath);
-
-						if (screenSaverGame != children.cend())
-						{
-							// Found the corresponding FileData
-							mCurrentGame = screenSaverGame->second;
-						}
-						else
-						{
-							// Couldn't find FileData. Going for the full iteration.
-							// iterate on children
-							FileType type = GAME;
-							std::vector<FileData*> allFiles = rootFileData->getFilesRecursive(type);
-							std::vector<FileData*>::const_iterator itf;  // declare an iterator to a vector of strings
-
-							int i = 0;
-							for(itf=allFiles.cbegin() ; itf < allFiles.cend(); itf++,i++ ) {
-								if ((*itf)->getPath() == gamePath)
-								{
-									mCurrentGame = (*itf);
-									break;
-								}
-							}
-						}
-
-						// end of getting FileData
-						if (Settings::getInstance()->getString("ScreenSaverGameInfo") != "never")
-							writeSubtitle(mGameName.c_str(), mSystemName.c_str(),
-								(Settings::getInstance()->getString("ScreenSaverGameInfo") == "always"));
-						return;
-					}
-				}
-			}
+			path = index[pick].path;
+			mCurrentGame = index[pick].game;
+			mSystemName = mCurrentGame->getSystem()->getFullName();
+			mGameName = mCurrentGame->metadata.get(MD_ID_NAME);
+
+			if (Settings::getInstance()->getString("ScreenSaverGameInfo") != "never")
+				writeSubtitle(mGameName.c_str(), mSystemName.c_str(),
+					(Settings::getInstance()->getString("ScreenSaverGameInfo") == "always"));
+			return;
 		}
+
+		// the file is gone, don't pick it again until the index is rebuilt
+		index[pick] = index.back();
+		index.pop_back();
 	}
 }
 
 void SystemScreenSaver::pickRandomVideo(std::string& path)
 {
-	countVideos();
+	updateMediaIndex();
 	mCurrentGame = NULL;
-	if (mVideoCount > 0)
-	{
-		int video = (int)(((float)rand() / float(RAND_MAX)) * (float)mVideoCount);
-
-		pickGameListNode(video, "video", path);
-	}
+	pickRandomMedia(mVideoIndex, path);
 }
 
 void SystemScreenSaver::pickRandomGameListImage(std::string& path)
 {
-	countImages();
+	updateMediaIndex();
 	mCurrentGame = NULL;
-	if (mImageCount > 0)
-	{
-		int image = (int)(((float)rand() / float(RAND_MAX)) * (float)mImageCount);
-
-		pickGameListNode(image, "image", path);
-	}
+	pickRandomMedia(mImageIndex, path);
 }
 
 void SystemScreenSaver::pickRandomCustomImage(std::string& path)
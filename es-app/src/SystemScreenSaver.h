@@ -3,9 +3,11 @@
 #define ES_APP_SYSTEM_SCREEN_SAVER_H
 
 #include "Window.h"
+#include <random>
 
 class ImageComponent;
 class Sound;
+class SystemData;
 class VideoComponent;
 
 // Screensaver implementation for main window
@@ -27,10 +29,16 @@ public:
 	virtual void launchGame();
 
 private:
-	unsigned long countGameListNodes(const char *nodeName);
-	void countVideos();
-	void countImages();
-	void pickGameListNode(unsigned long index, const char *nodeName, std::string& path);
+	struct MediaEntry
+	{
+		FileData* game;
+		std::string path;
+	};
+
+	// Rebuilds the media indexes if any game tree or any metadata changed since they were built
+	void updateMediaIndex();
+	// Picks an entry whose file exists, entries of missing files are dropped on the way
+	void pickRandomMedia(std::vector<MediaEntry>& index, std::string& path);
 	void pickRandomVideo(std::string& path);
 	void pickRandomGameListImage(std::string& path);
 	void pickRandomCustomImage(std::string& path);
@@ -45,11 +53,13 @@ private:
 	};
 
 private:
-	bool			mVideosCounted;
-	unsigned long		mVideoCount;
+	std::vector<MediaEntry>	mVideoIndex;
+	std::vector<MediaEntry>	mImageIndex;
+	std::vector<std::pair<SystemData*, unsigned int> > mIndexedTrees;
+	unsigned int	mIndexedMetadataVersion;
+	bool			mIndexBuilt;
+	std::mt19937	mRandomEngine;
 	VideoComponent*		mVideoScreensaver;
-	bool			mImagesCounted;
-	unsigned long		mImageCount;
 	ImageComponent*		mImageScreensaver;
 	Window*			mWindow;
 	STATE			mState;
@@ -33,6 +33,7 @@ void AsyncReqComponent::update(int deltaTime)
 	}
 
 	mTime += deltaTime;
+	invalidate();
 }
 
 void AsyncReqComponent::render(const Transform4x4f& /*parentTrans*/)
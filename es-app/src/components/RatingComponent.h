@@ -3,8 +3,7 @@
 #define ES_APP_COMPONENTS_RATING_COMPONENT_H
 
 #include "GuiComponent.h"
-#include "platform.h"
-#include GLHEADER
+#include "Renderer.h"
 
 class TextureResource;
 
@@ -43,11 +42,7 @@ private:
 
 	float mValue;
 
-	struct Vertex
-	{
-		Vector2f pos;
-		Vector2f tex;
-	} mVertices[12];
+	Renderer::Vertex mVertices[12];
 
 
 	GLubyte mColors[12*4];
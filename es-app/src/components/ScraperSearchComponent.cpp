@@ -221,6 +221,25 @@ void ScraperSearchComponent::stop()
 	mBlockAccept = false;
 }
 
+void ScraperSearchComponent::showResult(const ScraperSearchResult& result)
+{
+	stop();
+
+	mScraperResults.clear();
+	mScraperResults.push_back(result);
+
+	// the image is already on disk, don't download the thumbnail again
+	mScraperResults.back().thumbnailUrl = "";
+	updateInfoPane();
+
+	const std::string& image = result.mdl.get("image");
+	if(!image.empty())
+	{
+		mResultThumbnail->setImage(image);
+		mGrid.onSizeChanged(); // a hack to fix the thumbnail position since its size changed
+	}
+}
+
 void ScraperSearchComponent::onSearchDone(const std::vector<ScraperSearchResult>& results)
 {
 	mResultList->clear();
@@ -376,6 +395,10 @@ void ScraperSearchComponent::update(int deltaTime)
 {
 	GuiComponent::update(deltaTime);
 
+	// the busy animation runs and the results show up whenever a request finishes
+	if(mBlockAccept || mThumbnailReq || mSearchHandle || mMDResolveHandle)
+		invalidate();
+
 	if(mBlockAccept)
 	{
 		mBusyAnim.update(deltaTime);
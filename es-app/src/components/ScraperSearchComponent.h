@@ -29,6 +29,9 @@ public:
 	void search(const ScraperSearchParams& params);
 	void openInputScreen(ScraperSearchParams& from);
 	void stop();
+
+	// Shows a result that was scraped elsewhere (with its assets already resolved) without searching for it.
+	void showResult(const ScraperSearchResult& result);
 	inline SearchType getSearchType() const { return mSearchType; }
 
 	// Metadata assets will be resolved before calling the accept callback (e.g. result.mdl's "image" is automatically downloaded and properly set).
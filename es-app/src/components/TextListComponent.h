@@ -290,6 +290,9 @@ void TextListComponent<T>::update(int deltaTime)
 {
 	listUpdate(deltaTime);
 
+	const int prevMarqueeOffset = mMarqueeOffset;
+	const int prevMarqueeOffset2 = mMarqueeOffset2;
+
 	if(!isScrolling() && size() > 0)
 	{
 		// always reset the marquee offsets
@@ -323,6 +326,9 @@ void TextListComponent<T>::update(int deltaTime)
 		}
 	}
 
+	if(mMarqueeOffset != prevMarqueeOffset || mMarqueeOffset2 != prevMarqueeOffset2)
+		GuiComponent::invalidate();
+
 	GuiComponent::update(deltaTime);
 }
 
@@ -105,6 +105,7 @@ void GuiFastSelect::update(int deltaTime)
 		{
 			scroll();
 			mScrollAccumulator -= 150;
+			invalidate();
 		}
 	}
 
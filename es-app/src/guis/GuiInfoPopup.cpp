@@ -69,9 +69,10 @@ void GuiInfoPopup::render(const Transform4x4f& /*parentTrans*/)
 	Transform4x4f trans = getTransform() * Transform4x4f::Identity();
 	if(running && updateState())
 	{
-		// if we're still supposed to be rendering it
+		// if we're still supposed to be rendering it, the fade and the timeout need the next frame too
 		Renderer::setMatrix(trans);
 		renderChildren(trans);
+		invalidate();
 	}
 }
 
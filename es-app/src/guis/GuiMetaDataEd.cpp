@@ -194,6 +194,9 @@ void GuiMetaDataEd::save()
 	// enter game in index
 	mScraperParams.system->getIndex()->addToIndex(mScraperParams.game);
 
+	// media may have been scraped or changed by hand
+	mScraperParams.game->getSystemEnvData()->mMediaIndex.invalidate();
+
 	if(mSavedCallback)
 		mSavedCallback();
 
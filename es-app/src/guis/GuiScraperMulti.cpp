@@ -5,9 +5,14 @@
 #include "components/ScraperSearchComponent.h"
 #include "components/TextComponent.h"
 #include "guis/GuiMsgBox.h"
+#include "scrapers/ScraperPipeline.h"
 #include "views/ViewController.h"
+#include "FileFilterIndex.h"
 #include "Gamelist.h"
+#include "HttpCache.h"
+#include "Log.h"
 #include "PowerSaver.h"
+#include "Settings.h"
 #include "SystemData.h"
 #include "Window.h"
 
@@ -27,6 +32,8 @@ GuiScraperMulti::GuiScraperMulti(Window* window, const std::queue<ScraperSearchP
 	mCurrentGame = 0;
 	mTotalSuccessful = 0;
 	mTotalSkipped = 0;
+	mTotalErrors = 0;
+	mFinished = false;
 
 	// set up grid
 	mTitle = std::make_shared<TextComponent>(mWindow, "SCRAPING IN PROGRESS", Font::get(FONT_SIZE_LARGE), 0x555555FF, ALIGN_CENTER);
@@ -68,6 +75,30 @@ GuiScraperMulti::GuiScraperMulti(Window* window, const std::queue<ScraperSearchP
 	setSize(Renderer::getScreenWidth() * 0.95f, Renderer::getScreenHeight() * 0.849f);
 	setPosition((Renderer::getScreenWidth() - mSize.x()) / 2, (Renderer::getScreenHeight() - mSize.y()) / 2);
 
+	if(!approveResults)
+	{
+		// nobody has to look at the results, so keep several games in flight
+		mPipeline = std::unique_ptr<ScraperPipeline>(new ScraperPipeline(mSearchQueue, Settings::getInstance()->getInt("ScraperConcurrency")));
+		mPipeline->setResultCallback([this](const ScraperSearchParams& search, const ScraperSearchResult& result)
+		{
+			applyResult(search, result);
+			mSearchComp->showResult(result);
+			mCurrentGame++;
+			mTotalSuccessful++;
+		});
+		mPipeline->setSkipCallback([this](const ScraperSearchParams& search, const std::string& error)
+		{
+			mCurrentGame++;
+			if(error.empty())
+				mTotalSkipped++;
+			else
+				mTotalErrors++;
+		});
+
+		updatePipelineProgress();
+		return;
+	}
+
 	doNextSearch();
 }
 
@@ -89,6 +120,43 @@ void GuiScraperMulti::onSizeChanged()
 	mGrid.setSize(mSize);
 }
 
+void GuiScraperMulti::update(int deltaTime)
+{
+	GuiComponent::update(deltaTime);
+
+	if(!mPipeline || mFinished)
+		return;
+
+	mPipeline->update();
+	if(mPipeline->isDone())
+	{
+		finish();
+		return;
+	}
+
+	updatePipelineProgress();
+	invalidate();
+}
+
+void GuiScraperMulti::updatePipelineProgress()
+{
+	const ScraperSearchParams* oldest = mPipeline->getOldestInFlight();
+	if(!oldest)
+		return;
+
+	mSystem->setText(strToUpper(oldest->system->getFullName()));
+
+	const ScraperPipelineStats& stats = mPipeline->getStats();
+	std::stringstream ss;
+	ss << "GAME " << (mCurrentGame + 1) << " OF " << mTotalGames << " - " << mPipeline->getInFlightCount() << " IN FLIGHT";
+	if(stats.getFinished() > 0)
+		ss << " - " << (int)(stats.getGamesPerMinute() + 0.5f) << " GAMES/MIN";
+	if(stats.errors > 0)
+		ss << " - " << stats.errors << " ERROR" << ((stats.errors > 1) ? "S" : "");
+	ss << " - " << strToUpper(oldest->game->getPath().filename().string());
+	mSubtitle->setText(ss.str());
+}
+
 void GuiScraperMulti::doNextSearch()
 {
 	if(mSearchQueue.empty())
@@ -109,12 +177,19 @@ void GuiScraperMulti::doNextSearch()
 	mSearchComp->search(mSearchQueue.front());
 }
 
-void GuiScraperMulti::acceptResult(const ScraperSearchResult& result)
+void GuiScraperMulti::applyResult(const ScraperSearchParams& search, const ScraperSearchResult& result)
 {
-	ScraperSearchParams& search = mSearchQueue.front();
-
+	// re-index so filters and cached game counts see the new metadata
+	search.system->getIndex()->removeFromIndex(search.game);
 	search.game->metadata = result.mdl;
+	search.system->getIndex()->addToIndex(search.game);
+	search.game->getSystemEnvData()->mMediaIndex.invalidate();
 	updateGamelist(search.system);
+}
+
+void GuiScraperMulti::acceptResult(const ScraperSearchResult& result)
+{
+	applyResult(mSearchQueue.front(), result);
 
 	mSearchQueue.pop();
 	mCurrentGame++;
@@ -132,6 +207,27 @@ void GuiScraperMulti::skip()
 
 void GuiScraperMulti::finish()
 {
+	if(mFinished)
+		return;
+
+	mFinished = true;
+
+	if(mPipeline)
+	{
+		const ScraperPipelineStats& stats = mPipeline->getStats();
+		LOG(LogInfo) << "Scraped " << stats.getFinished() << " games in " << stats.elapsed << "ms (" << stats.getGamesPerMinute() << " games/min): "
+			<< stats.scraped << " scraped, " << stats.skipped << " without results, " << stats.errors << " errors, "
+			<< "latency " << stats.getAverageLatency() << "ms average, " << stats.maxLatency << "ms max";
+
+		HttpCache* cache = HttpCache::getInstance();
+		LOG(LogInfo) << "Scraper http cache: " << cache->getHitCount() << " hits, " << cache->getRevalidatedCount() << " revalidated, "
+			<< cache->getMissCount() << " misses (" << (int)(cache->getHitRate() * 100 + 0.5f) << "% served from disk), "
+			<< cache->getEvictionCount() << " evicted";
+
+		// whatever is still in flight is dropped, only finished games were saved
+		mPipeline->stop();
+	}
+
 	std::stringstream ss;
 	if(mTotalSuccessful == 0)
 	{
@@ -143,6 +239,9 @@ void GuiScraperMulti::finish()
 			ss << "\n" << mTotalSkipped << " GAME" << ((mTotalSkipped > 1) ? "S" : "") << " SKIPPED.";
 	}
 
+	if(mTotalErrors > 0)
+		ss << "\n" << mTotalErrors << " GAME" << ((mTotalErrors > 1) ? "S" : "") << " FAILED, SEE THE LOG.";
+
 	mWindow->pushGui(new GuiMsgBox(mWindow, ss.str(),
 		"OK", [&] { delete this; }));
 
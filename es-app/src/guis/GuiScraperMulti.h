@@ -7,6 +7,7 @@
 #include "scrapers/Scraper.h"
 #include "GuiComponent.h"
 
+class ScraperPipeline;
 class ScraperSearchComponent;
 class TextComponent;
 
@@ -17,21 +18,30 @@ public:
 	virtual ~GuiScraperMulti();
 
 	void onSizeChanged() override;
+	void update(int deltaTime) override;
 	std::vector<HelpPrompt> getHelpPrompts() override;
 
 private:
 	void acceptResult(const ScraperSearchResult& result);
 	void skip();
 	void doNextSearch();
-	
+
+	void applyResult(const ScraperSearchParams& search, const ScraperSearchResult& result);
+	void updatePipelineProgress();
+
 	void finish();
 
 	unsigned int mTotalGames;
 	unsigned int mCurrentGame;
 	unsigned int mTotalSuccessful;
 	unsigned int mTotalSkipped;
+	unsigned int mTotalErrors;
+	bool mFinished;
 	std::queue<ScraperSearchParams> mSearchQueue;
 
+	// only used when results don't need approval, scrapes several games at once
+	std::unique_ptr<ScraperPipeline> mPipeline;
+
 	NinePatchComponent mBackground;
 	ComponentGrid mGrid;
 
@@ -1,6 +1,7 @@
 //EmulationStation, a graphical front-end for ROM browsing. Created by Alec "Aloshi" Lofquist.
 //http://www.aloshi.com
 
+#include "components/VideoVlcComponent.h"
 #include "guis/GuiDetectDevice.h"
 #include "guis/GuiMsgBox.h"
 #include "views/ViewController.h"
@@ -79,6 +80,9 @@ bool parseArgs(int argc, char* argv[])
 		}else if(strcmp(argv[i], "--show-hidden-files") == 0)
 		{
 			Settings::getInstance()->setBool("ShowHiddenFiles", true);
+		}else if(strcmp(argv[i], "--no-threaded-loading") == 0)
+		{
+			Settings::getInstance()->setBool("ThreadedLoading", false);
 		}else if(strcmp(argv[i], "--draw-framerate") == 0)
 		{
 			Settings::getInstance()->setBool("DrawFramerate", true);
@@ -146,6 +150,7 @@ bool parseArgs(int argc, char* argv[])
 				"--resolution [width] [height]	try and force a particular resolution\n"
 				"--gamelist-only			skip automatic game search, only read from gamelist.xml\n"
 				"--ignore-gamelist		ignore the gamelist (useful for troubleshooting)\n"
+				"--no-threaded-loading		load systems one at a time on the main thread\n"
 				"--draw-framerate		display the framerate\n"
 				"--no-exit			don't show the exit option in the menu\n"
 				"--no-splash			don't show the splash screen\n"
@@ -184,11 +189,11 @@ bool verifyHomeFolderExists()
 }
 
 // Returns true if everything is OK,
-bool loadSystemConfigFile(const char** errorString)
+bool loadSystemConfigFile(Window* window, const char** errorString)
 {
 	*errorString = NULL;
 
-	if(!SystemData::loadConfig())
+	if(!SystemData::loadConfig(window))
 	{
 		LOG(LogError) << "Error while parsing systems configuration file!";
 		*errorString = "IT LOOKS LIKE YOUR SYSTEMS CONFIGURATION FILE HAS NOT BEEN SET UP OR IS INVALID. YOU'LL NEED TO DO THIS BY HAND, UNFORTUNATELY.\n\n"
@@ -298,7 +303,7 @@ int main(int argc, char* argv[])
 	}
 
 	const char* errorMsg = NULL;
-	if(!loadSystemConfigFile(&errorMsg))
+	if(!loadSystemConfigFile(scrape_cmdline ? NULL : &window, &errorMsg))
 	{
 		// something went terribly wrong
 		if(errorMsg == NULL)
@@ -350,13 +355,23 @@ int main(int argc, char* argv[])
 	int ps_time = SDL_GetTicks();
 
 	bool running = true;
+	bool idle = false;
 
 	while(running)
 	{
 		SDL_Event event;
 		bool ps_standby = PowerSaver::getState() && (int) SDL_GetTicks() - ps_time > PowerSaver::getMode();
 
-		if(ps_standby ? SDL_WaitEventTimeout(&event, PowerSaver::getTimeout()) : SDL_PollEvent(&event))
+		// while the last frame was skipped there's no swap to wait on, so wait for events (at most a frame) instead of spinning
+		bool gotEvent;
+		if(ps_standby)
+			gotEvent = SDL_WaitEventTimeout(&event, PowerSaver::getTimeout()) != 0;
+		else if(idle)
+			gotEvent = SDL_WaitEventTimeout(&event, 16) != 0;
+		else
+			gotEvent = SDL_PollEvent(&event) != 0;
+
+		if(gotEvent)
 		{
 			do
 			{
@@ -364,6 +379,10 @@ int main(int argc, char* argv[])
 
 				if(event.type == SDL_QUIT)
 					running = false;
+
+				// e.g. the window was uncovered, what was on screen may be gone
+				if(event.type == SDL_WINDOWEVENT)
+					window.invalidate();
 			} while(SDL_PollEvent(&event));
 
 			// triggered if exiting from SDL_WaitEvent due to event
@@ -397,8 +416,14 @@ int main(int argc, char* argv[])
 			deltaTime = 1000;
 
 		window.update(deltaTime);
-		window.render();
-		Renderer::swapBuffers();
+
+		// nothing changed, the last frame is still on screen
+		idle = !window.needsRender();
+		if(!idle)
+		{
+			window.render();
+			Renderer::swapBuffers();
+		}
 
 		Log::flush();
 	}
@@ -406,6 +431,7 @@ int main(int argc, char* argv[])
 	while(window.peekGui() != ViewController::get())
 		delete window.peekGui();
 	window.deinit();
+	VideoVlcComponent::stopMediaParser();
 
 	CollectionSystemManager::deinit();
 	SystemData::deleteSystems();
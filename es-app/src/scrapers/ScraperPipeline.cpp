@@ -0,0 +1,141 @@
+#include "scrapers/ScraperPipeline.h"
+
+#include "FileData.h"
+#include "Log.h"
+
+ScraperPipeline::ScraperPipeline(const std::queue<ScraperSearchParams>& searches, unsigned int concurrency)
+	: mQueue(searches), mConcurrency(concurrency > 0 ? concurrency : 1), mStarted(false)
+{
+}
+
+void ScraperPipeline::startGames()
+{
+	if(!mStarted)
+	{
+		mStartTime = std::chrono::steady_clock::now();
+		mStarted = true;
+	}
+
+	while(mInFlight.size() < mConcurrency && !mQueue.empty())
+	{
+		mInFlight.push_back(InFlight());
+		InFlight& game = mInFlight.back();
+		game.params = mQueue.front();
+		game.startTime = std::chrono::steady_clock::now();
+		game.done = false;
+		game.found = false;
+		game.search = startScraperSearch(game.params);
+		mQueue.pop();
+	}
+}
+
+void ScraperPipeline::update()
+{
+	startGames();
+
+	// take the finished games out first, the callbacks are free to stop() us
+	std::list<InFlight> finished;
+	auto it = mInFlight.begin();
+	while(it != mInFlight.end())
+	{
+		advance(*it);
+		if(it->done)
+			finished.splice(finished.end(), mInFlight, it++);
+		else
+			it++;
+	}
+
+	mStats.elapsed = (unsigned int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - mStartTime).count();
+
+	for(auto game = finished.begin(); game != finished.end(); game++)
+		finishGame(*game);
+
+	// keep the pipeline full, the next search goes out while the remaining downloads are still running
+	if(!finished.empty())
+		startGames();
+}
+
+void ScraperPipeline::advance(InFlight& game)
+{
+	if(game.search)
+	{
+		AsyncHandleStatus status = game.search->status();
+		if(status == ASYNC_IN_PROGRESS)
+			return;
+
+		if(status == ASYNC_ERROR)
+		{
+			game.error = game.search->getStatusString();
+			game.done = true;
+			return;
+		}
+
+		// always accept the first result, its image is downloaded alongside the other games' searches
+		const std::vector<ScraperSearchResult>& results = game.search->getResults();
+		if(results.empty())
+		{
+			game.done = true;
+			return;
+		}
+
+		game.resolve = resolveMetaDataAssets(results.front(), game.params);
+		game.search.reset();
+	}
+
+	if(game.resolve)
+	{
+		AsyncHandleStatus status = game.resolve->status();
+		if(status == ASYNC_IN_PROGRESS)
+			return;
+
+		if(status == ASYNC_ERROR)
+		{
+			game.error = game.resolve->getStatusString();
+		}else{
+			game.result = game.resolve->getResult();
+			game.found = true;
+		}
+
+		game.done = true;
+	}
+}
+
+void ScraperPipeline::finishGame(InFlight& game)
+{
+	unsigned int latency = (unsigned int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - game.startTime).count();
+	mStats.totalLatency += latency;
+	if(latency > mStats.maxLatency)
+		mStats.maxLatency = latency;
+
+	if(game.found)
+	{
+		mStats.scraped++;
+		if(mResultCallback)
+			mResultCallback(game.params, game.result);
+		return;
+	}
+
+	if(game.error.empty())
+	{
+		mStats.skipped++;
+	}else{
+		mStats.errors++;
+		LOG(LogWarning) << "Scraping \"" << game.params.game->getPath().generic_string() << "\" failed: " << game.error;
+	}
+
+	if(mSkipCallback)
+		mSkipCallback(game.params, game.error);
+}
+
+void ScraperPipeline::stop()
+{
+	while(!mQueue.empty())
+		mQueue.pop();
+
+	mInFlight.clear();
+}
+
+const ScraperSearchParams* ScraperPipeline::getOldestInFlight() const
+{
+	return mInFlight.empty() ? nullptr : &mInFlight.front().params;
+}
@@ -0,0 +1,84 @@
+#pragma once
+#ifndef ES_APP_SCRAPERS_SCRAPER_PIPELINE_H
+#define ES_APP_SCRAPERS_SCRAPER_PIPELINE_H
+
+#include "scrapers/Scraper.h"
+#include <chrono>
+#include <functional>
+#include <list>
+
+struct ScraperPipelineStats
+{
+	ScraperPipelineStats() : scraped(0), skipped(0), errors(0), totalLatency(0), maxLatency(0), elapsed(0) {};
+
+	unsigned int scraped; // games that got a result
+	unsigned int skipped; // games without any result
+	unsigned int errors;  // games that failed with a network or disk error
+
+	unsigned int totalLatency; // ms from starting a game's search to having its assets on disk, summed over all finished games
+	unsigned int maxLatency;
+	unsigned int elapsed;      // ms since the first search started
+
+	inline unsigned int getFinished() const { return scraped + skipped + errors; }
+	inline unsigned int getAverageLatency() const { return getFinished() ? totalLatency / getFinished() : 0; }
+	inline float getGamesPerMinute() const { return elapsed ? getFinished() * 60000.0f / elapsed : 0; }
+};
+
+// Scrapes a queue of games without user interaction, always taking the first result.
+// Up to "concurrency" games are in flight at once, so the asset downloads of one game overlap the searches of the next;
+// the per-host connection and rate limits of HttpReq keep this from hammering the scraper site.
+class ScraperPipeline
+{
+public:
+	ScraperPipeline(const std::queue<ScraperSearchParams>& searches, unsigned int concurrency);
+
+	// called once per game, in the order the games finish (which is not necessarily the queue order);
+	// the skip callback gets an empty error if the scraper simply had no result for the game
+	inline void setResultCallback(const std::function<void(const ScraperSearchParams&, const ScraperSearchResult&)>& resultCallback) { mResultCallback = resultCallback; }
+	inline void setSkipCallback(const std::function<void(const ScraperSearchParams&, const std::string&)>& skipCallback) { mSkipCallback = skipCallback; }
+
+	// advances every game in flight and starts new ones, call this from update()
+	void update();
+
+	// drops the queue and everything in flight
+	void stop();
+
+	inline bool isDone() const { return mQueue.empty() && mInFlight.empty(); }
+	inline unsigned int getInFlightCount() const { return (unsigned int)mInFlight.size(); }
+	inline const ScraperPipelineStats& getStats() const { return mStats; }
+
+	// the game that has been in flight the longest, null if none
+	const ScraperSearchParams* getOldestInFlight() const;
+
+private:
+	struct InFlight
+	{
+		ScraperSearchParams params;
+		std::unique_ptr<ScraperSearchHandle> search;
+		std::unique_ptr<MDResolveHandle> resolve;
+		std::chrono::steady_clock::time_point startTime;
+
+		// set once the game is finished
+		bool done;
+		bool found;
+		ScraperSearchResult result;
+		std::string error;
+	};
+
+	void startGames();
+	void advance(InFlight& game);
+	void finishGame(InFlight& game);
+
+	std::queue<ScraperSearchParams> mQueue;
+	std::list<InFlight> mInFlight;
+	unsigned int mConcurrency;
+
+	std::chrono::steady_clock::time_point mStartTime;
+	bool mStarted;
+	ScraperPipelineStats mStats;
+
+	std::function<void(const ScraperSearchParams&, const ScraperSearchResult&)> mResultCallback;
+	std::function<void(const ScraperSearchParams&, const std::string&)> mSkipCallback;
+};
+
+#endif // ES_APP_SCRAPERS_SCRAPER_PIPELINE_H
@@ -6,6 +6,7 @@
 #include "animations/MoveCameraAnimation.h"
 #include "guis/GuiMenu.h"
 #include "views/gamelist/DetailedGameListView.h"
+#include "views/gamelist/GridGameListView.h"
 #include "views/gamelist/IGameListView.h"
 #include "views/gamelist/VideoGameListView.h"
 #include "views/SystemView.h"
@@ -14,6 +15,7 @@
 #include "Log.h"
 #include "Settings.h"
 #include "SystemData.h"
+#include "ThemeData.h"
 #include "Window.h"
 
 ViewController* ViewController::sInstance = NULL;
@@ -285,6 +287,8 @@ std::shared_ptr<IGameListView> ViewController::getGameListView(SystemData* syste
 		selectedViewType = DETAILED;
 	if (viewPreference.compare("video") == 0)
 		selectedViewType = VIDEO;
+	if (viewPreference.compare("grid") == 0)
+		selectedViewType = GRID;
 
 	if (selectedViewType == AUTOMATIC)
 	{
@@ -313,9 +317,9 @@ std::shared_ptr<IGameListView> ViewController::getGameListView(SystemData* syste
 		case DETAILED:
 			view = std::shared_ptr<IGameListView>(new DetailedGameListView(mWindow, system->getRootFolder()));
 			break;
-		// case GRID placeholder for future implementation.
-		//		view = std::shared_ptr<IGameListView>(new GridGameListView(mWindow, system->getRootFolder()));
-		//		break;
+		case GRID:
+			view = std::shared_ptr<IGameListView>(new GridGameListView(mWindow, system->getRootFolder()));
+			break;
 		case BASIC:
 		default:
 			view = std::shared_ptr<IGameListView>(new BasicGameListView(mWindow, system->getRootFolder()));
@@ -472,6 +476,7 @@ void ViewController::reloadAll()
 
 
 	// load themes, create gamelistviews and reset filters
+	ThemeData::IncludeCacheScope includeCache;
 	for(auto it = cursorMap.cbegin(); it != cursorMap.cend(); it++)
 	{
 		it->first->loadTheme();
@@ -61,8 +61,8 @@ public:
 		AUTOMATIC,
 		BASIC,
 		DETAILED,
-		VIDEO
-		// GRID TODO!
+		VIDEO,
+		GRID
 	};
 
 	struct State
@@ -25,7 +25,7 @@ public:
 
 protected:
 	virtual void populateList(const std::vector<FileData*>& files) override;
-	virtual void remove(FileData* game, bool deleteFile) override;
+	virtual void removeEntry(FileData* game) override;
 	virtual void addPlaceholder();
 
 	TextListComponent<FileData*> mList;
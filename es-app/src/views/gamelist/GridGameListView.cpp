@@ -1,12 +1,14 @@
 #include "views/gamelist/GridGameListView.h"
 
 #include "views/ViewController.h"
+#include "SystemData.h"
 
 GridGameListView::GridGameListView(Window* window, FileData* root) : ISimpleGameListView(window, root),
 	mGrid(window)
 {
 	mGrid.setPosition(0, mSize.y() * 0.2f);
 	mGrid.setSize(mSize.x(), mSize.y() * 0.8f);
+	mGrid.setDefaultZIndex(20);
 	addChild(&mGrid);
 
 	populateList(root->getChildrenListToDisplay());
@@ -19,7 +21,7 @@ FileData* GridGameListView::getCursor()
 
 void GridGameListView::setCursor(FileData* file)
 {
-	if(!mGrid.setCursor(file))
+	if(!mGrid.setCursor(file) && (!file->isPlaceHolder()))
 	{
 		populateList(file->getParent()->getChildrenListToDisplay());
 		mGrid.setCursor(file);
@@ -37,10 +39,25 @@ bool GridGameListView::input(InputConfig* config, Input input)
 void GridGameListView::populateList(const std::vector<FileData*>& files)
 {
 	mGrid.clear();
-	for(auto it = files.cbegin(); it != files.cend(); it++)
+	mHeaderText.setText(mRoot->getSystem()->getFullName());
+	if (files.size() > 0)
 	{
-		mGrid.add((*it)->getName(), (*it)->getThumbnailPath(), *it);
+		for(auto it = files.cbegin(); it != files.cend(); it++)
+		{
+			mGrid.add((*it)->getName(), (*it)->getThumbnailPath(), *it);
+		}
 	}
+	else
+	{
+		addPlaceholder();
+	}
+}
+
+void GridGameListView::addPlaceholder()
+{
+	// empty grid - add a placeholder
+	FileData* placeholder = new FileData(PLACEHOLDER, "<No Entries Found>", this->mRoot->getSystem()->getSystemEnvData(), this->mRoot->getSystem());
+	mGrid.add(placeholder->getName(), "", placeholder);
 }
 
 void GridGameListView::launch(FileData* game)
@@ -48,6 +65,15 @@ void GridGameListView::launch(FileData* game)
 	ViewController::get()->launch(game);
 }
 
+void GridGameListView::removeEntry(FileData* game)
+{
+	mGrid.remove(game);
+	if(mGrid.size() == 0)
+	{
+		addPlaceholder();
+	}
+}
+
 std::vector<HelpPrompt> GridGameListView::getHelpPrompts()
 {
 	std::vector<HelpPrompt> prompts;
@@ -24,6 +24,8 @@ public:
 
 protected:
 	virtual void populateList(const std::vector<FileData*>& files) override;
+	virtual void removeEntry(FileData* game) override;
+	virtual void addPlaceholder();
 
 	ImageGridComponent<FileData*> mGrid;
 };
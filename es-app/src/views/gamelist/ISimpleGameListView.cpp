@@ -6,6 +6,7 @@
 #include "Settings.h"
 #include "Sound.h"
 #include "SystemData.h"
+#include <boost/filesystem/operations.hpp>
 
 ISimpleGameListView::ISimpleGameListView(Window* window, FileData* root) : IGameListView(window, root),
 	mHeaderText(window), mHeaderImage(window), mBackground(window)
@@ -167,3 +168,28 @@ bool ISimpleGameListView::input(InputConfig* config, Input input)
 
 
 
+
+void ISimpleGameListView::remove(FileData *game, bool deleteFile)
+{
+	if (deleteFile)
+		boost::filesystem::remove(game->getPath());  // actually delete the file on the filesystem
+	FileData* parent = game->getParent();
+	if (getCursor() == game)                     // Select next element in list, or prev if none
+	{
+		std::vector<FileData*> siblings = parent->getChildrenListToDisplay();
+		auto gameIter = std::find(siblings.cbegin(), siblings.cend(), game);
+		int gamePos = (int)std::distance(siblings.cbegin(), gameIter);
+		if (gameIter != siblings.cend())
+		{
+			if ((gamePos + 1) < (int)siblings.size())
+			{
+				setCursor(siblings.at(gamePos + 1));
+			} else if ((gamePos - 1) >= 0) {
+				setCursor(siblings.at(gamePos - 1));
+			}
+		}
+	}
+	removeEntry(game);
+	delete game;                                 // remove before repopulating (removes from parent)
+	onFileChanged(parent, FILE_REMOVED);           // update the view, with game removed
+}
@@ -30,6 +30,11 @@ public:
 protected:
 	virtual void populateList(const std::vector<FileData*>& files) = 0;
 
+	// Moves the cursor off the game if needed, takes it out of the list (see removeEntry()) and deletes it.
+	virtual void remove(FileData* game, bool deleteFile) override;
+	// Takes the game out of the list component, leaving a placeholder if the list ends up empty.
+	virtual void removeEntry(FileData* game) = 0;
+
 	TextComponent mHeaderText;
 	ImageComponent mHeaderImage;
 	ImageComponent mBackground;
@@ -0,0 +1,104 @@
+// Times every FileSorts sort type on a generated tree of 100k games, spread over 100 folders.
+// Each type is sorted twice: the first run builds the sort keys, the second shows the cost with them cached.
+// Not a test, run it by hand: es-app-sort-benchmark [games]
+
+#include "FileData.h"
+#include "FileSorts.h"
+#include "Log.h"
+#include "platform.h"
+#include "SystemData.h"
+#include <boost/filesystem/operations.hpp>
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+
+static FileData* generateTree(SystemEnvironmentData* envData, SystemData* system, unsigned int gameCount)
+{
+	const unsigned int folderCount = 100;
+	const char* words[] = { "super", "mega", "kart", "fighter", "quest", "star", "dragon", "street", "world", "legend", "the", "of" };
+	const char* genres[] = { "Platform", "Racing", "Shooter", "Fighting", "RPG", "Puzzle", "Sports" };
+	const unsigned int wordCount = sizeof(words) / sizeof(words[0]);
+	const unsigned int genreCount = sizeof(genres) / sizeof(genres[0]);
+
+	// always the same tree, so runs can be compared
+	std::mt19937 engine(42);
+	std::uniform_int_distribution<unsigned int> word(0, wordCount - 1);
+	std::uniform_int_distribution<unsigned int> genre(0, genreCount - 1);
+	std::uniform_int_distribution<unsigned int> year(1980, 2005);
+	std::uniform_int_distribution<unsigned int> small(0, 10);
+
+	FileData* root = new FileData(FOLDER, envData->mStartPath, envData, system);
+	std::vector<FileData*> folders;
+	for(unsigned int i = 0; i < folderCount; i++)
+	{
+		folders.push_back(new FileData(FOLDER, envData->mStartPath + "/folder" + std::to_string(i), envData, system));
+		root->addChild(folders.back());
+	}
+
+	char date[32];
+	for(unsigned int i = 0; i < gameCount; i++)
+	{
+		std::string name = std::string(words[word(engine)]) + " " + words[word(engine)] + " " + words[word(engine)] + " " + std::to_string(i);
+		FileData* game = new FileData(GAME, folders[i % folderCount]->getPath().generic_string() + "/" + name + ".zip", envData, system);
+
+		game->metadata.set(MD_ID_NAME, name);
+		game->metadata.set(MD_ID_GENRE, genres[genre(engine)]);
+		game->metadata.set(MD_ID_DEVELOPER, words[word(engine)]);
+		game->metadata.set(MD_ID_PUBLISHER, words[word(engine)]);
+		game->metadata.set(MD_ID_RATING, std::to_string(small(engine) / 10.0f));
+		game->metadata.set(MD_ID_PLAYERS, std::to_string(1 + small(engine) % 4));
+		game->metadata.set(MD_ID_PLAYCOUNT, std::to_string(small(engine)));
+		snprintf(date, sizeof(date), "%u0%u1%uT000000", year(engine), 1 + small(engine) % 9, small(engine) % 3);
+		game->metadata.set(MD_ID_RELEASEDATE, date);
+		snprintf(date, sizeof(date), "2017%02u%02uT%02u0000", 1 + small(engine), 10 + small(engine), small(engine));
+		game->metadata.set(MD_ID_LASTPLAYED, date);
+
+		folders[i % folderCount]->addChild(game);
+	}
+
+	return root;
+}
+
+static double timeSort(FileData* root, const FileData::SortType& type)
+{
+	const auto start = std::chrono::steady_clock::now();
+	root->sort(type);
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[])
+{
+	const unsigned int gameCount = (argc > 1) ? atoi(argv[1]) : 100000;
+
+	// keep the settings and log away from the real ones, getHomePath() looks at $PWD first
+	char home[] = "/tmp/es-test-XXXXXX";
+	if(mkdtemp(home) == NULL)
+		return 1;
+	setenv("HOME", home, 1);
+	setenv("PWD", home, 1);
+	boost::filesystem::create_directories(getHomePath() + "/.emulationstation");
+	Log::open();
+
+	SystemEnvironmentData* envData = new SystemEnvironmentData;
+	envData->mStartPath = getHomePath() + "/roms";
+	SystemData* system = new SystemData("test", "Test", envData, "", true);
+
+	const auto start = std::chrono::steady_clock::now();
+	FileData* root = generateTree(envData, system, gameCount);
+	printf("generated %u games in %.1f ms\n\n", gameCount, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+	printf("%-40s %12s %12s\n", "sort", "first (ms)", "again (ms)");
+	for(auto it = FileSorts::SortTypes.cbegin(); it != FileSorts::SortTypes.cend(); it++)
+	{
+		const double first = timeSort(root, *it);
+		const double again = timeSort(root, *it);
+		printf("%-40s %12.1f %12.1f\n", it->description.c_str(), first, again);
+	}
+
+	// the tree, system and environment are left to the process exit, tearing down 100k games isn't what is measured
+	Log::close();
+	boost::system::error_code ec;
+	boost::filesystem::remove_all(home, ec);
+	return 0;
+}
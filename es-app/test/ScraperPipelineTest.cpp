@@ -0,0 +1,182 @@
+// Runs ScraperPipeline against canned TheGamesDB responses from a local stand-in server:
+// checks how many games are in flight, the per-host connection caps, that image downloads overlap the
+// searches of other games, and how scraped, skipped and failed games are counted.
+
+#include "scrapers/ScraperPipeline.h"
+#include "FileData.h"
+#include "HttpStandIn.h"
+#include "Log.h"
+#include "platform.h"
+#include "Settings.h"
+#include "SystemData.h"
+#include <boost/filesystem/operations.hpp>
+#include <stdio.h>
+#include <stdlib.h>
+#include <set>
+
+static int sFailures = 0;
+
+#define CHECK(condition) \
+	if(!(condition)) \
+	{ \
+		fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+		sFailures++; \
+	}
+
+#define GAMESDB_HOST "thegamesdb.net"
+#define ART_HOST     "art.gamesdb.test"
+
+static bool startsWith(const std::string& str, const std::string& prefix)
+{
+	return str.compare(0, prefix.length(), prefix) == 0;
+}
+
+// "Missing" has no search results, "Broken" drops its search connection, every other name is found
+static HttpStandIn::Response answerGamesDB(const std::string& host, const std::string& path)
+{
+	const std::string listPrefix = "/api/GetGamesList.php?name=";
+	const std::string gamePrefix = "/api/GetGame.php?id=";
+	const unsigned int delayMs = 50;
+
+	if(host == GAMESDB_HOST && startsWith(path, listPrefix))
+	{
+		const std::string name = path.substr(listPrefix.length());
+		if(name == "Missing")
+			return HttpStandIn::Response(200, "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n<Data></Data>", delayMs);
+		if(name == "Broken")
+			return HttpStandIn::Response(0);
+
+		return HttpStandIn::Response(200, "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n"
+			"<Data><Game><id>" + name + "</id><GameTitle>" + name + "</GameTitle><Platform>Test</Platform></Game></Data>", delayMs);
+	}
+
+	if(host == GAMESDB_HOST && startsWith(path, gamePrefix))
+	{
+		const std::string id = path.substr(gamePrefix.length());
+		return HttpStandIn::Response(200, "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n"
+			"<Data><baseImgUrl>http://" ART_HOST "/</baseImgUrl><Game><id>" + id + "</id><GameTitle>" + id + " Title</GameTitle>"
+			"<Overview>Canned</Overview><ReleaseDate>01/02/1995</ReleaseDate><Players>2</Players><Rating>8</Rating>"
+			"<Images><boxart side=\"front\" thumb=\"boxart/thumb/" + id + ".jpg\">boxart/" + id + ".jpg</boxart></Images></Game></Data>", delayMs);
+	}
+
+	if(host == ART_HOST && startsWith(path, "/boxart/"))
+		return HttpStandIn::Response(200, "image " + path, delayMs);
+
+	return HttpStandIn::Response(404, "unexpected request " + host + path);
+}
+
+static void testPipeline()
+{
+	const unsigned int concurrency = 3;
+	Settings::getInstance()->setInt("HttpMaxHostConnections", 2);
+	Settings::getInstance()->setInt("HttpMaxHostRequestRate", 0);
+
+	HttpStandIn server(&answerGamesDB);
+	CHECK(server.isListening());
+
+	// send every request through the stand-in, whatever host it is for
+	setenv("http_proxy", ("http://" + server.getHost()).c_str(), 1);
+	unsetenv("no_proxy");
+	unsetenv("NO_PROXY");
+
+	SystemEnvironmentData* envData = new SystemEnvironmentData;
+	envData->mStartPath = getHomePath() + "/roms";
+	SystemData* system = new SystemData("test", "Test", envData, "", true);
+
+	const char* names[] = { "Alpha", "Bravo", "Missing", "Charlie", "Delta", "Broken", "Echo", "Foxtrot", "Golf", "Hotel" };
+	const unsigned int found = 8;
+	std::vector<FileData*> games;
+	std::queue<ScraperSearchParams> searches;
+	for(size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+	{
+		games.push_back(new FileData(GAME, envData->mStartPath + "/" + names[i] + ".zip", envData, system));
+
+		ScraperSearchParams search;
+		search.system = system;
+		search.game = games.back();
+		searches.push(search);
+	}
+
+	ScraperPipeline pipeline(searches, concurrency);
+
+	std::set<std::string> scraped;
+	std::set<std::string> skipped;
+	std::set<std::string> failed;
+	pipeline.setResultCallback([&](const ScraperSearchParams& search, const ScraperSearchResult& result)
+	{
+		const std::string name = search.game->getCleanName();
+		scraped.insert(name);
+		CHECK(result.mdl.get("name") == name + " Title");
+		CHECK(result.mdl.get("players") == "2");
+		CHECK(boost::filesystem::exists(result.mdl.get("image")));
+	});
+	pipeline.setSkipCallback([&](const ScraperSearchParams& search, const std::string& error)
+	{
+		(error.empty() ? skipped : failed).insert(search.game->getCleanName());
+	});
+
+	unsigned int maxInFlight = 0;
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+	while(!pipeline.isDone() && std::chrono::steady_clock::now() < deadline)
+	{
+		pipeline.update();
+		maxInFlight = std::max(maxInFlight, pipeline.getInFlightCount());
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	CHECK(pipeline.isDone());
+
+	const ScraperPipelineStats& stats = pipeline.getStats();
+	CHECK(stats.scraped == found);
+	CHECK(stats.skipped == 1);
+	CHECK(stats.errors == 1);
+	CHECK(stats.getFinished() == games.size());
+	CHECK(stats.maxLatency > 0 && stats.getAverageLatency() <= stats.maxLatency);
+	CHECK(stats.elapsed > 0);
+
+	CHECK(scraped.size() == found);
+	CHECK(skipped.size() == 1 && skipped.count("Missing"));
+	CHECK(failed.size() == 1 && failed.count("Broken"));
+
+	// the pipeline keeps its games in flight, HttpReq keeps each host to its own cap
+	CHECK(maxInFlight == concurrency);
+	CHECK(server.getMaxConcurrent(GAMESDB_HOST) <= 2);
+	CHECK(server.getMaxConcurrent(ART_HOST) <= 2);
+	CHECK(server.getRequestCount(ART_HOST) == found);
+
+	// with both hosts at their cap at some point, images were downloading while other games were searched
+	CHECK(server.getMaxConcurrent("") > 2);
+
+	for(auto it = games.begin(); it != games.end(); it++)
+		delete *it;
+	delete system;
+	delete envData;
+	unsetenv("http_proxy");
+}
+
+int main(int argc, char* argv[])
+{
+	// keep the settings, log and downloaded images away from the real ones, getHomePath() looks at $PWD first
+	char home[] = "/tmp/es-test-XXXXXX";
+	if(mkdtemp(home) == NULL)
+		return 1;
+	setenv("HOME", home, 1);
+	setenv("PWD", home, 1);
+	boost::filesystem::create_directories(getHomePath() + "/.emulationstation");
+	Log::open();
+
+	// keep the canned "images" as they are, and ask the stand-in every time
+	Settings::getInstance()->setString("Scraper", "TheGamesDB");
+	Settings::getInstance()->setInt("ScraperResizeWidth", 0);
+	Settings::getInstance()->setInt("ScraperResizeHeight", 0);
+	Settings::getInstance()->setInt("HttpCacheSize", 0);
+
+	testPipeline();
+
+	Log::close();
+	boost::system::error_code ec;
+	boost::filesystem::remove_all(home, ec);
+
+	if(sFailures)
+		fprintf(stderr, "%d check(s) failed\n", sFailures);
+	return sFailures ? 1 : 0;
+}
@@ -42,7 +42,10 @@ bool GuiComponent::input(InputConfig* config, Input input)
 void GuiComponent::updateSelf(int deltaTime)
 {
 	for(unsigned char i = 0; i < MAX_ANIMATIONS; i++)
-		advanceAnimation(i, deltaTime);
+	{
+		if(advanceAnimation(i, deltaTime))
+			invalidate();
+	}
 }
 
 void GuiComponent::updateChildren(int deltaTime)
@@ -80,6 +83,9 @@ Vector3f GuiComponent::getPosition() const
 
 void GuiComponent::setPosition(float x, float y, float z)
 {
+	if(mPosition != Vector3f(x, y, z))
+		invalidate();
+
 	mPosition = Vector3f(x, y, z);
 	onPositionChanged();
 }
@@ -91,6 +97,9 @@ Vector2f GuiComponent::getOrigin() const
 
 void GuiComponent::setOrigin(float x, float y)
 {
+	if(mOrigin != Vector2f(x, y))
+		invalidate();
+
 	mOrigin = Vector2f(x, y);
 	onOriginChanged();
 }
@@ -102,6 +111,9 @@ Vector2f GuiComponent::getRotationOrigin() const
 
 void GuiComponent::setRotationOrigin(float x, float y)
 {
+	if(mRotationOrigin != Vector2f(x, y))
+		invalidate();
+
 	mRotationOrigin = Vector2f(x, y);
 }
 
@@ -112,6 +124,9 @@ Vector2f GuiComponent::getSize() const
 
 void GuiComponent::setSize(float w, float h)
 {
+	if(mSize != Vector2f(w, h))
+		invalidate();
+
 	mSize = Vector2f(w, h);
     onSizeChanged();
 }
@@ -123,6 +138,9 @@ float GuiComponent::getRotation() const
 
 void GuiComponent::setRotation(float rotation)
 {
+	if(mRotation != rotation)
+		invalidate();
+
 	mRotation = rotation;
 }
 
@@ -133,6 +151,9 @@ float GuiComponent::getScale() const
 
 void GuiComponent::setScale(float scale)
 {
+	if(mScale != scale)
+		invalidate();
+
 	mScale = scale;
 }
 
@@ -143,6 +164,9 @@ float GuiComponent::getZIndex() const
 
 void GuiComponent::setZIndex(float z)
 {
+	if(mZIndex != z)
+		invalidate();
+
 	mZIndex = z;
 }
 
@@ -165,6 +189,7 @@ Vector2f GuiComponent::getCenter() const
 //Children stuff.
 void GuiComponent::addChild(GuiComponent* cmp)
 {
+	invalidate();
 	mChildren.push_back(cmp);
 
 	if(cmp->getParent())
@@ -184,6 +209,7 @@ void GuiComponent::removeChild(GuiComponent* cmp)
 	}
 
 	cmp->setParent(NULL);
+	invalidate();
 
 	for(auto i = mChildren.cbegin(); i != mChildren.cend(); i++)
 	{
@@ -197,6 +223,7 @@ void GuiComponent::removeChild(GuiComponent* cmp)
 
 void GuiComponent::clearChildren()
 {
+	invalidate();
 	mChildren.clear();
 }
 
@@ -234,6 +261,9 @@ unsigned char GuiComponent::getOpacity() const
 
 void GuiComponent::setOpacity(unsigned char opacity)
 {
+	if(mOpacity != opacity)
+		invalidate();
+
 	mOpacity = opacity;
 	for(auto it = mChildren.cbegin(); it != mChildren.cend(); it++)
 	{
@@ -241,6 +271,11 @@ void GuiComponent::setOpacity(unsigned char opacity)
 	}
 }
 
+void GuiComponent::invalidate()
+{
+	mWindow->invalidate();
+}
+
 const Transform4x4f& GuiComponent::getTransform()
 {
 	mTransform = Transform4x4f::Identity();
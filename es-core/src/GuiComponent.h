@@ -132,6 +132,11 @@ public:
 	// Returns true if the component is busy doing background processing (e.g. HTTP downloads)
 	bool isProcessing() const;
 
+	// Tells the Window that what this component draws changed, so the next frame is rendered instead of skipped.
+	// The setters above and running animations do this already, anything that changes on its own over time
+	// (video, scrolling, blinking) has to call it from update() for as long as it does.
+	void invalidate();
+
 protected:
 	void renderChildren(const Transform4x4f& transform) const;
 	void updateSelf(int deltaTime); // updates animations
@@ -0,0 +1,143 @@
+#include "HttpCache.h"
+
+#include "utils/CacheStream.h"
+#include "Log.h"
+#include "platform.h"
+#include "Settings.h"
+#include <boost/filesystem/operations.hpp>
+#include <ctime>
+#include <fstream>
+
+// bump this whenever the layout below changes, old entries are then simply downloaded again
+#define HTTP_CACHE_MAGIC   "ESHC"
+#define HTTP_CACHE_VERSION 1
+
+// entry layout: magic, version, key, stored time, etag, last-modified, content
+// the file's modification time is its last use, for the LRU order
+
+HttpCache* HttpCache::getInstance()
+{
+	static HttpCache* sInstance = new HttpCache();
+	return sInstance;
+}
+
+HttpCache::HttpCache() : mIndex(getHomePath() + "/.emulationstation/cache/http", ".bin"), mHitCount(0), mRevalidatedCount(0), mMissCount(0)
+{
+}
+
+bool HttpCache::isEnabled()
+{
+	return Settings::getInstance()->getInt("HttpCacheSize") > 0;
+}
+
+size_t HttpCache::getMaxTotalSize()
+{
+	return (size_t)Settings::getInstance()->getInt("HttpCacheSize") * 1024 * 1024;
+}
+
+std::string HttpCache::getEntryName(const std::string& key)
+{
+	uint64_t hash = 14695981039346656037ULL; // FNV-1a
+	for(size_t i = 0; i < key.length(); i++)
+		hash = (hash ^ (unsigned char)key[i]) * 1099511628211ULL;
+
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)hash);
+	return name;
+}
+
+bool HttpCache::get(const std::string& key, Entry& entry)
+{
+	mIndex.scan(getMaxTotalSize());
+
+	const std::string name = getEntryName(key);
+	if(!mIndex.contains(name))
+		return false;
+
+	std::ifstream file(mIndex.getPath(name).c_str(), std::ios::in | std::ios::binary);
+	if(!file.is_open())
+		return false;
+
+	std::string buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	file.close();
+
+	// the key is stored as well, two keys sharing a hash just keep replacing each other
+	CacheReader reader(buffer);
+	if(reader.readString() != HTTP_CACHE_MAGIC || reader.readU32() != HTTP_CACHE_VERSION || reader.readString() != key)
+		return false;
+
+	entry.storedTime = reader.readI64();
+	entry.etag = reader.readString();
+	entry.lastModified = reader.readString();
+	entry.content = reader.readString();
+	if(!reader.ok())
+		return false;
+
+	mIndex.touch(name);
+	mIndex.markUsedOnDisk(name);
+	return true;
+}
+
+bool HttpCache::isFresh(const Entry& entry)
+{
+	const int64_t age = (int64_t)std::time(NULL) - entry.storedTime;
+	return age >= 0 && age < Settings::getInstance()->getInt("HttpCacheTTL");
+}
+
+void HttpCache::put(const std::string& key, const Entry& entry)
+{
+	CacheWriter writer;
+	writer.writeString(HTTP_CACHE_MAGIC);
+	writer.writeU32(HTTP_CACHE_VERSION);
+	writer.writeString(key);
+	writer.writeI64(entry.storedTime);
+	writer.writeString(entry.etag);
+	writer.writeString(entry.lastModified);
+	writer.writeString(entry.content);
+
+	const size_t maxTotalSize = getMaxTotalSize();
+	mIndex.scan(maxTotalSize);
+
+	// a previous entry for the key stays accounted for until the new file has replaced it
+	const std::string name = getEntryName(key);
+	if(!mIndex.beginWrite(name, writer.getBuffer().size(), maxTotalSize))
+		return;
+
+	// write through a temporary file so a partially written entry is never picked up
+	const std::string cachePath = mIndex.getPath(name);
+	const std::string tempPath = cachePath + ".tmp";
+	boost::system::error_code ec;
+	boost::filesystem::create_directories(mIndex.getDirectory(), ec);
+
+	bool written = false;
+	std::ofstream file(tempPath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if(file.is_open())
+	{
+		file.write(writer.getBuffer().data(), writer.getBuffer().size());
+		file.close();
+
+		if(file.fail())
+		{
+			LOG(LogWarning) << "Error writing http cache entry \"" << tempPath << "\"";
+		}else{
+			boost::filesystem::rename(tempPath, cachePath, ec);
+			if(ec)
+				LOG(LogWarning) << "Error writing http cache entry \"" << cachePath << "\": " << ec.message();
+			else
+				written = true;
+		}
+
+		if(!written)
+			boost::filesystem::remove(tempPath, ec);
+	}else{
+		LOG(LogWarning) << "Could not open \"" << tempPath << "\" for writing";
+	}
+
+	mIndex.endWrite(name, written);
+}
+
+float HttpCache::getHitRate() const
+{
+	const size_t total = mHitCount + mRevalidatedCount + mMissCount;
+	return total ? (float)(mHitCount + mRevalidatedCount) / total : 0.0f;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#ifndef ES_CORE_HTTP_CACHE_H
+#define ES_CORE_HTTP_CACHE_H
+
+#include "utils/DiskCacheIndex.h"
+#include <stdint.h>
+#include <string>
+
+// Responses of cacheable HttpReqs, one file per request in ~/.emulationstation/cache/http/.
+// An entry younger than Settings "HttpCacheTTL" seconds is served without touching the network,
+// an older one is revalidated with its ETag/Last-Modified and served again if the server answers 304.
+// The cache is kept below the "HttpCacheSize" setting (in MB) by evicting the least recently used entries.
+// Like HttpReq itself, this is only used from the main thread.
+class HttpCache
+{
+public:
+	struct Entry
+	{
+		Entry() : storedTime(0) {};
+
+		int64_t storedTime;
+		std::string etag;
+		std::string lastModified;
+		std::string content;
+	};
+
+	static HttpCache* getInstance();
+
+	bool isEnabled();
+
+	// Returns false if there is no entry for the key, stale entries are returned too, see isFresh().
+	bool get(const std::string& key, Entry& entry);
+	bool isFresh(const Entry& entry);
+	void put(const std::string& key, const Entry& entry);
+
+	// served from disk without a request / after a 304 / downloaded in full
+	inline void onHit() { mHitCount++; }
+	inline void onRevalidated() { mRevalidatedCount++; }
+	inline void onMiss() { mMissCount++; }
+
+	inline size_t getHitCount() const { return mHitCount; }
+	inline size_t getRevalidatedCount() const { return mRevalidatedCount; }
+	inline size_t getMissCount() const { return mMissCount; }
+	inline size_t getEvictionCount() const { return mIndex.getEvictionCount(); }
+	float getHitRate() const; // hits and revalidations over all cacheable requests
+
+private:
+	HttpCache();
+
+	std::string getEntryName(const std::string& key);
+	size_t getMaxTotalSize();
+
+	DiskCacheIndex mIndex;
+
+	size_t mHitCount;
+	size_t mRevalidatedCount;
+	size_t mMissCount;
+};
+
+#endif // ES_CORE_HTTP_CACHE_H
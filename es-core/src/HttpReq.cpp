@@ -1,12 +1,17 @@
 #include "HttpReq.h"
 
 #include "Log.h"
+#include "Settings.h"
 #include <boost/filesystem/operations.hpp>
+#include <ctime>
 
 CURLM* HttpReq::s_multi_handle = curl_multi_init();
 
 std::map<CURL*, HttpReq*> HttpReq::s_requests;
 
+std::list<HttpReq*> HttpReq::s_pending;
+std::map<std::string, HttpReq::HostState> HttpReq::s_hosts;
+
 std::string HttpReq::urlEncode(const std::string &s)
 {
     const std::string unreserved = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_.~";
@@ -36,9 +41,47 @@ bool HttpReq::isUrl(const std::string& str)
 		(str.find("http://") != std::string::npos || str.find("https://") != std::string::npos || str.find("www.") != std::string::npos));
 }
 
-HttpReq::HttpReq(const std::string& url)
-	: mStatus(REQ_IN_PROGRESS), mHandle(NULL)
+std::string HttpReq::getHost(const std::string& url)
 {
+	size_t start = url.find("://");
+	start = (start == std::string::npos) ? 0 : start + 3;
+
+	size_t end = url.find_first_of("/?#", start);
+	std::string host = url.substr(start, end == std::string::npos ? std::string::npos : end - start);
+
+	// drop any user info, it's still the same server
+	size_t at = host.find('@');
+	if(at != std::string::npos)
+		host = host.substr(at + 1);
+
+	for(size_t i = 0; i < host.length(); i++)
+		host[i] = (char)tolower(host[i]);
+
+	return host;
+}
+
+HttpReq::HttpReq(const std::string& url, bool useCache)
+	: mStatus(REQ_IN_PROGRESS), mHandle(NULL), mHost(getHost(url)), mStarted(false), mRunning(false),
+	mUseCache(useCache && HttpCache::getInstance()->isEnabled()), mUrl(url), mRevalidating(false), mHeaders(NULL)
+{
+	if(mUseCache && HttpCache::getInstance()->get(mUrl, mCacheEntry))
+	{
+		if(HttpCache::getInstance()->isFresh(mCacheEntry))
+		{
+			HttpCache::getInstance()->onHit();
+			mContent << mCacheEntry.content;
+			mStatus = REQ_SUCCESS;
+			return;
+		}
+
+		// ask the server whether our copy is still good
+		if(!mCacheEntry.etag.empty())
+			mHeaders = curl_slist_append(mHeaders, ("If-None-Match: " + mCacheEntry.etag).c_str());
+		if(!mCacheEntry.lastModified.empty())
+			mHeaders = curl_slist_append(mHeaders, ("If-Modified-Since: " + mCacheEntry.lastModified).c_str());
+		mRevalidating = (mHeaders != NULL);
+	}
+
 	mHandle = curl_easy_init();
 
 	if(mHandle == NULL)
@@ -75,41 +118,122 @@ HttpReq::HttpReq(const std::string& url)
 		return;
 	}
 
-	//add the handle to our multi
-	CURLMcode merr = curl_multi_add_handle(s_multi_handle, mHandle);
-	if(merr != CURLM_OK)
+	if(mUseCache)
 	{
-		mStatus = REQ_IO_ERROR;
-		onError(curl_multi_strerror(merr));
-		return;
+		//collect the validators of the response
+		err = curl_easy_setopt(mHandle, CURLOPT_HEADERFUNCTION, &HttpReq::write_header);
+		if(err == CURLE_OK)
+			err = curl_easy_setopt(mHandle, CURLOPT_HEADERDATA, this);
+		if(err == CURLE_OK && mHeaders)
+			err = curl_easy_setopt(mHandle, CURLOPT_HTTPHEADER, mHeaders);
+
+		if(err != CURLE_OK)
+		{
+			mStatus = REQ_IO_ERROR;
+			onError(curl_easy_strerror(err));
+			return;
+		}
 	}
 
-	s_requests[mHandle] = this;
+	//wait for our host to have room for another request
+	s_pending.push_back(this);
+	startPending();
 }
 
 HttpReq::~HttpReq()
 {
+	if(!mStarted)
+		s_pending.remove(this);
+
+	if(mRunning)
+		onDone();
+
 	if(mHandle)
 	{
-		s_requests.erase(mHandle);
+		if(mStarted)
+		{
+			s_requests.erase(mHandle);
 
-		CURLMcode merr = curl_multi_remove_handle(s_multi_handle, mHandle);
+			CURLMcode merr = curl_multi_remove_handle(s_multi_handle, mHandle);
 
-		if(merr != CURLM_OK)
-			LOG(LogError) << "Error removing curl_easy handle from curl_multi: " << curl_multi_strerror(merr);
+			if(merr != CURLM_OK)
+				LOG(LogError) << "Error removing curl_easy handle from curl_multi: " << curl_multi_strerror(merr);
+		}
 
 		curl_easy_cleanup(mHandle);
 	}
+
+	if(mHeaders)
+		curl_slist_free_all(mHeaders);
+}
+
+void HttpReq::startPending()
+{
+	const int maxConnections = Settings::getInstance()->getInt("HttpMaxHostConnections");
+	const int maxRate = Settings::getInstance()->getInt("HttpMaxHostRequestRate");
+	const auto now = std::chrono::steady_clock::now();
+
+	auto it = s_pending.begin();
+	while(it != s_pending.end())
+	{
+		HttpReq* req = *it;
+		HostState& host = s_hosts[req->mHost];
+
+		if((maxConnections > 0 && host.active >= maxConnections) || (maxRate > 0 && now < host.nextStart))
+		{
+			it++;
+			continue;
+		}
+
+		if(maxRate > 0)
+			host.nextStart = now + std::chrono::microseconds(1000000 / maxRate);
+
+		it = s_pending.erase(it);
+		req->start();
+	}
+}
+
+void HttpReq::start()
+{
+	mStarted = true;
+
+	//add the handle to our multi
+	CURLMcode merr = curl_multi_add_handle(s_multi_handle, mHandle);
+	if(merr != CURLM_OK)
+	{
+		mStarted = false;
+		mStatus = REQ_IO_ERROR;
+		onError(curl_multi_strerror(merr));
+		return;
+	}
+
+	s_requests[mHandle] = this;
+	s_hosts[mHost].active++;
+	mRunning = true;
+}
+
+void HttpReq::onDone()
+{
+	mRunning = false;
+
+	auto it = s_hosts.find(mHost);
+	if(it != s_hosts.end())
+		it->second.active--;
 }
 
 HttpReq::Status HttpReq::status()
 {
 	if(mStatus == REQ_IN_PROGRESS)
 	{
+		startPending();
+
 		int handle_count;
 		CURLMcode merr = curl_multi_perform(s_multi_handle, &handle_count);
 		if(merr != CURLM_OK && merr != CURLM_CALL_MULTI_PERFORM)
 		{
+			if(mRunning)
+				onDone();
+
 			mStatus = REQ_IO_ERROR;
 			onError(curl_multi_strerror(merr));
 			return mStatus;
@@ -129,9 +253,11 @@ HttpReq::Status HttpReq::status()
 					continue;
 				}
 
+				req->onDone();
+
 				if(msg->data.result == CURLE_OK)
 				{
-					req->mStatus = REQ_SUCCESS;
+					req->onSuccess();
 				}else{
 					req->mStatus = REQ_IO_ERROR;
 					req->onError(curl_easy_strerror(msg->data.result));
@@ -143,6 +269,45 @@ HttpReq::Status HttpReq::status()
 	return mStatus;
 }
 
+void HttpReq::onSuccess()
+{
+	mStatus = REQ_SUCCESS;
+
+	if(!mUseCache)
+		return;
+
+	long code = 0;
+	curl_easy_getinfo(mHandle, CURLINFO_RESPONSE_CODE, &code);
+
+	HttpCache* cache = HttpCache::getInstance();
+	if(code == 304 && mRevalidating)
+	{
+		// unchanged, serve our copy and restart its time to live
+		cache->onRevalidated();
+		mContent.str(mCacheEntry.content);
+		mCacheEntry.storedTime = (int64_t)std::time(NULL);
+		if(!mEtag.empty())
+			mCacheEntry.etag = mEtag;
+		if(!mLastModified.empty())
+			mCacheEntry.lastModified = mLastModified;
+		cache->put(mUrl, mCacheEntry);
+		return;
+	}
+
+	cache->onMiss();
+
+	// error pages are passed on as before, but never stored
+	if(code != 200)
+		return;
+
+	HttpCache::Entry entry;
+	entry.storedTime = (int64_t)std::time(NULL);
+	entry.etag = mEtag;
+	entry.lastModified = mLastModified;
+	entry.content = mContent.str();
+	cache->put(mUrl, entry);
+}
+
 std::string HttpReq::getContent() const
 {
 	assert(mStatus == REQ_SUCCESS);
@@ -170,6 +335,42 @@ size_t HttpReq::write_content(void* buff, size_t size, size_t nmemb, void* req_p
 	return nmemb;
 }
 
+//used as a curl callback, called once per header line (including the status line)
+size_t HttpReq::write_header(char* buff, size_t size, size_t nmemb, void* req_ptr)
+{
+	HttpReq* req = (HttpReq*)req_ptr;
+	std::string line(buff, size * nmemb);
+
+	size_t end = line.find_last_not_of("\r\n");
+	line = (end == std::string::npos) ? "" : line.substr(0, end + 1);
+
+	// a new response (after a redirect), forget the validators of the previous one
+	if(line.compare(0, 5, "HTTP/") == 0)
+	{
+		req->mEtag = "";
+		req->mLastModified = "";
+		return size * nmemb;
+	}
+
+	size_t colon = line.find(':');
+	if(colon == std::string::npos)
+		return size * nmemb;
+
+	std::string name = line.substr(0, colon);
+	for(size_t i = 0; i < name.length(); i++)
+		name[i] = (char)tolower(name[i]);
+
+	size_t valueStart = line.find_first_not_of(" \t", colon + 1);
+	std::string value = (valueStart == std::string::npos) ? "" : line.substr(valueStart);
+
+	if(name == "etag")
+		req->mEtag = value;
+	else if(name == "last-modified")
+		req->mLastModified = value;
+
+	return size * nmemb;
+}
+
 //used as a curl callback
 /*int HttpReq::update_progress(void* req_ptr, double dlTotal, double dlNow, double ulTotal, double ulNow)
 {
@@ -2,7 +2,10 @@
 #ifndef ES_CORE_HTTP_REQ_H
 #define ES_CORE_HTTP_REQ_H
 
+#include "HttpCache.h"
 #include <curl/curl.h>
+#include <chrono>
+#include <list>
 #include <map>
 #include <sstream>
 
@@ -21,12 +24,19 @@
  *
  * std::string content = myRequest.getContent();
  * //process contents...
+ *
+ * Requests to the same host are throttled: at most Settings "HttpMaxHostConnections" of them run at once
+ * and they are started no faster than Settings "HttpMaxHostRequestRate" per second (0 = no limit).
+ * Throttled requests simply stay REQ_IN_PROGRESS until there is room for them.
+ *
+ * Requests constructed with useCache = true go through HttpCache: a fresh entry completes the request
+ * immediately, a stale one is revalidated, and successful responses are stored for the next time.
 */
 
 class HttpReq
 {
 public:
-	HttpReq(const std::string& url);
+	HttpReq(const std::string& url, bool useCache = false);
 
 	~HttpReq();
 
@@ -51,6 +61,7 @@ public:
 
 private:
 	static size_t write_content(void* buff, size_t size, size_t nmemb, void* req_ptr);
+	static size_t write_header(char* buff, size_t size, size_t nmemb, void* req_ptr);
 	//static int update_progress(void* req_ptr, double dlTotal, double dlNow, double ulTotal, double ulNow);
 
 	//god dammit libcurl why can't you have some way to check the status of an individual handle
@@ -59,14 +70,44 @@ private:
 
 	static CURLM* s_multi_handle;
 
+	struct HostState
+	{
+		HostState() : active(0) {};
+
+		int active;
+		std::chrono::steady_clock::time_point nextStart;
+	};
+
+	// requests waiting for their host to allow another connection, oldest first
+	static std::list<HttpReq*> s_pending;
+	static std::map<std::string, HostState> s_hosts;
+
+	static void startPending();
+	static std::string getHost(const std::string& url);
+
+	void start();
+	void onDone();
+	void onSuccess();
 	void onError(const char* msg);
 
 	CURL* mHandle;
+	std::string mHost;
+	bool mStarted; // added to the multi handle
+	bool mRunning; // holding one of its host's connections
 
 	Status mStatus;
 
 	std::stringstream mContent;
 	std::string mErrorMsg;
+
+	// only used for cacheable requests
+	bool mUseCache;
+	std::string mUrl;
+	HttpCache::Entry mCacheEntry; // the stale entry being revalidated
+	bool mRevalidating;
+	std::string mEtag;
+	std::string mLastModified;
+	curl_slist* mHeaders;
 };
 
 #endif // ES_CORE_HTTP_REQ_H
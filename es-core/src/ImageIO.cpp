@@ -2,13 +2,207 @@
 
 #include "Log.h"
 #include <FreeImage.h>
+#include <stdint.h>
 #include <string.h>
 
-std::vector<unsigned char> ImageIO::loadFromMemoryRGBA32(const unsigned char * data, const size_t size, size_t & width, size_t & height)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define IMAGEIO_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define IMAGEIO_NEON
+#endif
+
+// Pixel kernels. FreeImage stores pixels as BGR(A) on little endian machines, textures want RGBA.
+// Each kernel has a scalar version and, where the compiler targets it, an SSE2 or NEON version;
+// the one to use is picked once at runtime.
+
+typedef void SwizzleFunction(unsigned char* dst, const unsigned char* src, size_t pixels);
+typedef void SwapRowsFunction(unsigned char* row1, unsigned char* row2, size_t bytes);
+
+static void swizzleBGRAScalar(unsigned char* dst, const unsigned char* src, size_t pixels)
 {
-	std::vector<unsigned char> rawData;
+	for(size_t i = 0; i < pixels; i++)
+	{
+		uint32_t p;
+		memcpy(&p, src + i * 4, 4);
+		p = (p & 0xFF00FF00) | ((p >> 16) & 0xFF) | ((p & 0xFF) << 16);
+		memcpy(dst + i * 4, &p, 4);
+	}
+}
+
+static void expandBGRScalar(unsigned char* dst, const unsigned char* src, size_t pixels)
+{
+	for(size_t i = 0; i < pixels; i++)
+	{
+		dst[i * 4 + 0] = src[i * 3 + 2];
+		dst[i * 4 + 1] = src[i * 3 + 1];
+		dst[i * 4 + 2] = src[i * 3 + 0];
+		dst[i * 4 + 3] = 255;
+	}
+}
+
+static void swapRowsScalar(unsigned char* row1, unsigned char* row2, size_t bytes)
+{
+	unsigned char temp[256];
+	while(bytes > 0)
+	{
+		const size_t chunk = bytes < sizeof(temp) ? bytes : sizeof(temp);
+		memcpy(temp, row1, chunk);
+		memcpy(row1, row2, chunk);
+		memcpy(row2, temp, chunk);
+		row1 += chunk;
+		row2 += chunk;
+		bytes -= chunk;
+	}
+}
+
+#if defined(IMAGEIO_SSE2)
+static void swizzleBGRASSE2(unsigned char* dst, const unsigned char* src, size_t pixels)
+{
+	const __m128i maskAG = _mm_set1_epi32((int)0xFF00FF00);
+	const __m128i maskB = _mm_set1_epi32(0x000000FF);
+	size_t i = 0;
+	for(; i + 4 <= pixels; i += 4)
+	{
+		const __m128i p = _mm_loadu_si128((const __m128i*)(src + i * 4));
+		const __m128i ag = _mm_and_si128(p, maskAG);
+		const __m128i r = _mm_and_si128(_mm_srli_epi32(p, 16), maskB);
+		const __m128i b = _mm_slli_epi32(_mm_and_si128(p, maskB), 16);
+		_mm_storeu_si128((__m128i*)(dst + i * 4), _mm_or_si128(ag, _mm_or_si128(r, b)));
+	}
+	swizzleBGRAScalar(dst + i * 4, src + i * 4, pixels - i);
+}
+
+static void expandBGRSSE2(unsigned char* dst, const unsigned char* src, size_t pixels)
+{
+	// no byte shuffle in SSE2, so move each of the 4 pixels in 12 bytes into its own lane and swizzle those
+	const __m128i maskG = _mm_set1_epi32(0x0000FF00);
+	const __m128i maskB = _mm_set1_epi32(0x000000FF);
+	const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+	size_t i = 0;
+	for(; i * 3 + 16 <= pixels * 3; i += 4)
+	{
+		const __m128i p = _mm_loadu_si128((const __m128i*)(src + i * 3));
+		const __m128i p01 = _mm_unpacklo_epi32(p, _mm_srli_si128(p, 3));
+		const __m128i p23 = _mm_unpacklo_epi32(_mm_srli_si128(p, 6), _mm_srli_si128(p, 9));
+		const __m128i bgr = _mm_unpacklo_epi64(p01, p23);
+		const __m128i g = _mm_and_si128(bgr, maskG);
+		const __m128i r = _mm_and_si128(_mm_srli_epi32(bgr, 16), maskB);
+		const __m128i b = _mm_slli_epi32(_mm_and_si128(bgr, maskB), 16);
+		_mm_storeu_si128((__m128i*)(dst + i * 4), _mm_or_si128(_mm_or_si128(g, alpha), _mm_or_si128(r, b)));
+	}
+	expandBGRScalar(dst + i * 4, src + i * 3, pixels - i);
+}
+
+static void swapRowsSSE2(unsigned char* row1, unsigned char* row2, size_t bytes)
+{
+	size_t i = 0;
+	for(; i + 16 <= bytes; i += 16)
+	{
+		const __m128i a = _mm_loadu_si128((const __m128i*)(row1 + i));
+		const __m128i b = _mm_loadu_si128((const __m128i*)(row2 + i));
+		_mm_storeu_si128((__m128i*)(row1 + i), b);
+		_mm_storeu_si128((__m128i*)(row2 + i), a);
+	}
+	swapRowsScalar(row1 + i, row2 + i, bytes - i);
+}
+#endif // IMAGEIO_SSE2
+
+#if defined(IMAGEIO_NEON)
+static void swizzleBGRANEON(unsigned char* dst, const unsigned char* src, size_t pixels)
+{
+	size_t i = 0;
+	for(; i + 16 <= pixels; i += 16)
+	{
+		uint8x16x4_t p = vld4q_u8(src + i * 4);
+		const uint8x16_t b = p.val[0];
+		p.val[0] = p.val[2];
+		p.val[2] = b;
+		vst4q_u8(dst + i * 4, p);
+	}
+	swizzleBGRAScalar(dst + i * 4, src + i * 4, pixels - i);
+}
+
+static void expandBGRNEON(unsigned char* dst, const unsigned char* src, size_t pixels)
+{
+	size_t i = 0;
+	for(; i + 16 <= pixels; i += 16)
+	{
+		const uint8x16x3_t p = vld3q_u8(src + i * 3);
+		uint8x16x4_t out;
+		out.val[0] = p.val[2];
+		out.val[1] = p.val[1];
+		out.val[2] = p.val[0];
+		out.val[3] = vdupq_n_u8(255);
+		vst4q_u8(dst + i * 4, out);
+	}
+	expandBGRScalar(dst + i * 4, src + i * 3, pixels - i);
+}
+
+static void swapRowsNEON(unsigned char* row1, unsigned char* row2, size_t bytes)
+{
+	size_t i = 0;
+	for(; i + 16 <= bytes; i += 16)
+	{
+		const uint8x16_t a = vld1q_u8(row1 + i);
+		const uint8x16_t b = vld1q_u8(row2 + i);
+		vst1q_u8(row1 + i, b);
+		vst1q_u8(row2 + i, a);
+	}
+	swapRowsScalar(row1 + i, row2 + i, bytes - i);
+}
+#endif // IMAGEIO_NEON
+
+struct PixelKernels
+{
+	SwizzleFunction* swizzleBGRA;
+	SwizzleFunction* expandBGR;
+	SwapRowsFunction* swapRows;
+};
+
+static bool cpuHasSIMD()
+{
+#if defined(IMAGEIO_SSE2) && defined(__GNUC__) && !defined(__x86_64__)
+	// 32-bit x86 builds may be run on CPUs without SSE2
+	return __builtin_cpu_supports("sse2");
+#elif defined(IMAGEIO_SSE2) || defined(IMAGEIO_NEON)
+	return true;
+#else
+	return false;
+#endif
+}
+
+static const PixelKernels& getPixelKernels()
+{
+	static const PixelKernels kernels = []
+	{
+		PixelKernels k = { &swizzleBGRAScalar, &expandBGRScalar, &swapRowsScalar };
+		if(cpuHasSIMD())
+		{
+#if defined(IMAGEIO_SSE2)
+			k.swizzleBGRA = &swizzleBGRASSE2;
+			k.expandBGR = &expandBGRSSE2;
+			k.swapRows = &swapRowsSSE2;
+#elif defined(IMAGEIO_NEON)
+			k.swizzleBGRA = &swizzleBGRANEON;
+			k.expandBGR = &expandBGRNEON;
+			k.swapRows = &swapRowsNEON;
+#endif
+		}
+		return k;
+	}();
+
+	return kernels;
+}
+
+unsigned char* ImageIO::decodeFromMemoryRGBA32(const unsigned char * data, const size_t size, size_t & width, size_t & height, size_t & sourceWidth, size_t & sourceHeight, const size_t maxSize)
+{
+	unsigned char* pixels = nullptr;
 	width = 0;
 	height = 0;
+	sourceWidth = 0;
+	sourceHeight = 0;
 	FIMEMORY * fiMemory = FreeImage_OpenMemory((BYTE *)data, (DWORD)size);
 	if (fiMemory != nullptr) {
 		//detect the filetype from data
@@ -19,44 +213,46 @@ std::vector<unsigned char> ImageIO::loadFromMemoryRGBA32(const unsigned char * d
 			FIBITMAP * fiBitmap = FreeImage_LoadFromMemory(format, fiMemory);
 			if (fiBitmap != nullptr)
 			{
-				//loaded. convert to 32bit if necessary
-				if (FreeImage_GetBPP(fiBitmap) != 32)
+				sourceWidth = FreeImage_GetWidth(fiBitmap);
+				sourceHeight = FreeImage_GetHeight(fiBitmap);
+
+				//scale down before converting, so the conversion only touches the pixels we keep
+				if (maxSize > 0 && (sourceWidth > maxSize || sourceHeight > maxSize))
 				{
-					FIBITMAP * fiConverted = FreeImage_ConvertTo32Bits(fiBitmap);
-					if (fiConverted != nullptr)
+					const double scale = (double)maxSize / (double)(sourceWidth > sourceHeight ? sourceWidth : sourceHeight);
+					const int scaledWidth = (int)(sourceWidth * scale + 0.5) > 0 ? (int)(sourceWidth * scale + 0.5) : 1;
+					const int scaledHeight = (int)(sourceHeight * scale + 0.5) > 0 ? (int)(sourceHeight * scale + 0.5) : 1;
+					FIBITMAP * fiScaled = FreeImage_Rescale(fiBitmap, scaledWidth, scaledHeight, FILTER_BILINEAR);
+					if (fiScaled != nullptr)
 					{
-						//free original bitmap data
 						FreeImage_Unload(fiBitmap);
-						fiBitmap = fiConverted;
+						fiBitmap = fiScaled;
 					}
 				}
+
+				//24 and 32bit images are converted straight into the destination, anything else goes through 32bit first
+				const unsigned int bpp = FreeImage_GetBPP(fiBitmap);
+				if (FreeImage_GetImageType(fiBitmap) != FIT_BITMAP || (bpp != 24 && bpp != 32))
+				{
+					FIBITMAP * fiConverted = FreeImage_ConvertTo32Bits(fiBitmap);
+					//free original bitmap data
+					FreeImage_Unload(fiBitmap);
+					fiBitmap = fiConverted;
+				}
 				if (fiBitmap != nullptr)
 				{
 					width = FreeImage_GetWidth(fiBitmap);
 					height = FreeImage_GetHeight(fiBitmap);
-					//loop through scanlines and add all pixel data to the return vector
-					//this is necessary, because width*height*bpp might not be == pitch
-					unsigned char * tempData = new unsigned char[width * height * 4];
+					pixels = new unsigned char[width * height * 4];
+
+					//convert scanline by scanline, width*bpp might not be == pitch
+					const PixelKernels& kernels = getPixelKernels();
+					SwizzleFunction* convert = (FreeImage_GetBPP(fiBitmap) == 32) ? kernels.swizzleBGRA : kernels.expandBGR;
 					for (size_t i = 0; i < height; i++)
-					{
-						const BYTE * scanLine = FreeImage_GetScanLine(fiBitmap, (int)i);
-						memcpy(tempData + (i * width * 4), scanLine, width * 4);
-					}
-					//convert from BGRA to RGBA
-					for(size_t i = 0; i < width*height; i++)
-					{
-						RGBQUAD bgra = ((RGBQUAD *)tempData)[i];
-						RGBQUAD rgba;
-						rgba.rgbBlue = bgra.rgbRed;
-						rgba.rgbGreen = bgra.rgbGreen;
-						rgba.rgbRed = bgra.rgbBlue;
-						rgba.rgbReserved = bgra.rgbReserved;
-						((RGBQUAD *)tempData)[i] = rgba;
-					}
-					rawData = std::vector<unsigned char>(tempData, tempData + width * height * 4);
+						convert(pixels + (i * width * 4), FreeImage_GetScanLine(fiBitmap, (int)i), width);
+
 					//free bitmap data
 					FreeImage_Unload(fiBitmap);
-					delete[] tempData;
 				}
 			}
 			else
@@ -71,20 +267,26 @@ std::vector<unsigned char> ImageIO::loadFromMemoryRGBA32(const unsigned char * d
 		//free FIMEMORY again
 		FreeImage_CloseMemory(fiMemory);
 	}
+	return pixels;
+}
+
+std::vector<unsigned char> ImageIO::loadFromMemoryRGBA32(const unsigned char * data, const size_t size, size_t & width, size_t & height)
+{
+	std::vector<unsigned char> rawData;
+	size_t sourceWidth, sourceHeight;
+	unsigned char* pixels = decodeFromMemoryRGBA32(data, size, width, height, sourceWidth, sourceHeight);
+	if (pixels != nullptr)
+	{
+		rawData.assign(pixels, pixels + width * height * 4);
+		delete[] pixels;
+	}
 	return rawData;
 }
 
 void ImageIO::flipPixelsVert(unsigned char* imagePx, const size_t& width, const size_t& height)
 {
-	unsigned int temp;
-	unsigned int* arr = (unsigned int*)imagePx;
+	SwapRowsFunction* swapRows = getPixelKernels().swapRows;
+	const size_t rowBytes = width * 4;
 	for(size_t y = 0; y < height / 2; y++)
-	{
-		for(size_t x = 0; x < width; x++)
-		{
-			temp = arr[x + (y * width)];
-			arr[x + (y * width)] = arr[x + (height * width) - ((y + 1) * width)];
-			arr[x + (height * width) - ((y + 1) * width)] = temp;
-		}
-	}
+		swapRows(imagePx + (y * rowBytes), imagePx + ((height - 1 - y) * rowBytes), rowBytes);
 }
@@ -9,6 +9,9 @@ class ImageIO
 {
 public:
 	static std::vector<unsigned char> loadFromMemoryRGBA32(const unsigned char * data, const size_t size, size_t & width, size_t & height);
+	// as above, but returns the pixels in a new[] allocated buffer owned by the caller (nullptr on failure)
+	// if maxSize is set, images larger than that on either side are scaled down (keeping their aspect ratio) while decoding
+	static unsigned char* decodeFromMemoryRGBA32(const unsigned char * data, const size_t size, size_t & width, size_t & height, size_t & sourceWidth, size_t & sourceHeight, const size_t maxSize = 0);
 	static void flipPixelsVert(unsigned char* imagePx, const size_t& width, const size_t& height);
 };
 
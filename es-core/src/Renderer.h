@@ -2,6 +2,7 @@
 #ifndef ES_CORE_RENDERER_H
 #define ES_CORE_RENDERER_H
 
+#include "math/Vector2f.h"
 #include "math/Vector2i.h"
 #include "platform.h"
 #include GLHEADER
@@ -30,6 +31,12 @@ namespace Renderer
 
 	void buildGLColorArray(GLubyte* ptr, unsigned int color, unsigned int vertCount);
 
+	struct Vertex
+	{
+		Vector2f pos;
+		Vector2f tex;
+	};
+
 	//graphics commands
 	void swapBuffers();
 
@@ -38,8 +45,39 @@ namespace Renderer
 
 	void setMatrix(const Transform4x4f& transform);
 
+	//textures, use these instead of glBindTexture/glDeleteTextures so the cached GL state stays right
+	void bindTexture(GLuint texture);
+	void deleteTexture(GLuint texture);
+
+	//geometry is queued in the space of the last setMatrix() with 4 color bytes per vertex (see buildGLColorArray),
+	//consecutive draws with the same texture (the bound one, if textured), blend function and clip rect become one glDrawArrays
+	void drawTriangles(const Vertex* vertices, const GLubyte* colors, unsigned int count, bool textured = true,
+		GLenum blend_sfactor = GL_SRC_ALPHA, GLenum blend_dfactor = GL_ONE_MINUS_SRC_ALPHA);
+	void drawLines(const Vertex* vertices, const GLubyte* colors, unsigned int count);
+
+	//geometry that stays the same over many frames can live in buffer objects instead, it is drawn with the bound texture
+	//and the last setMatrix() without being copied; buffers die with the GL context, which changes getContextGeneration()
+	bool hasBuffers();
+	unsigned int getContextGeneration();
+	GLuint createBuffer();
+	void deleteBuffer(GLuint buffer);
+	void uploadBuffer(GLuint buffer, const void* data, size_t size);
+	void drawBuffers(GLuint vertices, GLuint colors, unsigned int count);
+
 	void drawRect(int x, int y, int w, int h, unsigned int color, GLenum blend_sfactor = GL_SRC_ALPHA, GLenum blend_dfactor = GL_ONE_MINUS_SRC_ALPHA);
 	void drawRect(float x, float y, float w, float h, unsigned int color, GLenum blend_sfactor = GL_SRC_ALPHA, GLenum blend_dfactor = GL_ONE_MINUS_SRC_ALPHA);
+
+	//draw everything queued so far
+	void flush();
+
+	//statistics of the last finished frame
+	unsigned int getDrawCallCount();
+	unsigned int getStateChangeCount();
+
+	//for the platform specific Renderer_init_*.cpp, around the lifetime of the GL context and at the end of each frame
+	void initDrawState();
+	void deinitDrawState();
+	void finishFrame();
 }
 
 #endif // ES_CORE_RENDERER_H
@@ -2,8 +2,12 @@
 
 #include "Settings.h"
 #include "math/Misc.h"
+#include "math/Transform4x4f.h"
 #include "Log.h"
+#include <SDL.h>
+#include <stddef.h>
 #include <stack>
+#include <vector>
 #include <math.h>
 
 namespace Renderer {
@@ -18,6 +22,285 @@ namespace Renderer {
 
 	std::stack<ClipRect> clipStack;
 
+	// what actually goes to GL, already in screen space so every draw can share the identity modelview matrix
+	struct BatchVertex
+	{
+		GLfloat x, y;
+		GLfloat u, v;
+		GLuint color;
+	};
+
+	static std::vector<BatchVertex> batch;
+	static GLenum batchMode = GL_TRIANGLES;
+	static GLuint batchTexture = 0;
+	static GLenum batchBlendSrc = GL_SRC_ALPHA;
+	static GLenum batchBlendDst = GL_ONE_MINUS_SRC_ALPHA;
+
+	static Transform4x4f currentMatrix = Transform4x4f::Identity();
+
+	// shadow of the GL state, so redundant changes are never sent
+	static GLuint boundTexture = 0;
+	static bool textureEnabled = false;
+	static GLenum blendSrc = GL_SRC_ALPHA;
+	static GLenum blendDst = GL_ONE_MINUS_SRC_ALPHA;
+
+	static unsigned int drawCalls = 0;
+	static unsigned int stateChanges = 0;
+	static unsigned int lastDrawCalls = 0;
+	static unsigned int lastStateChanges = 0;
+
+	static GLuint vertexBuffer = 0;
+	static unsigned int contextGeneration = 0;
+
+	// drawBuffers() and uploadBuffer() leave their own buffer, pointers and matrix behind, the next flush puts the batch ones back
+	static bool batchStateLost = false;
+
+#ifdef USE_OPENGL_DESKTOP
+	// buffer objects are GL 1.5, which isn't exported directly everywhere (e.g. opengl32.dll)
+	typedef void (APIENTRY *GenBuffersFunction)(GLsizei, GLuint*);
+	typedef void (APIENTRY *DeleteBuffersFunction)(GLsizei, const GLuint*);
+	typedef void (APIENTRY *BindBufferFunction)(GLenum, GLuint);
+	typedef void (APIENTRY *BufferDataFunction)(GLenum, ptrdiff_t, const GLvoid*, GLenum);
+	static GenBuffersFunction sGenBuffers = NULL;
+	static DeleteBuffersFunction sDeleteBuffers = NULL;
+	static BindBufferFunction sBindBuffer = NULL;
+	static BufferDataFunction sBufferData = NULL;
+#else
+	#define sGenBuffers glGenBuffers
+	#define sDeleteBuffers glDeleteBuffers
+	#define sBindBuffer glBindBuffer
+	#define sBufferData glBufferData
+#endif
+
+	static void setVertexPointers(const BatchVertex* base)
+	{
+		glVertexPointer(2, GL_FLOAT, sizeof(BatchVertex), &base->x);
+		glTexCoordPointer(2, GL_FLOAT, sizeof(BatchVertex), &base->u);
+		glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(BatchVertex), &base->color);
+	}
+
+	void initDrawState()
+	{
+		batch.clear();
+		batch.reserve(4096);
+		currentMatrix = Transform4x4f::Identity();
+
+		glMatrixMode(GL_MODELVIEW);
+		glLoadIdentity();
+
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		blendSrc = GL_SRC_ALPHA;
+		blendDst = GL_ONE_MINUS_SRC_ALPHA;
+
+		glDisable(GL_TEXTURE_2D);
+		textureEnabled = false;
+		glBindTexture(GL_TEXTURE_2D, 0);
+		boundTexture = 0;
+
+		glEnableClientState(GL_VERTEX_ARRAY);
+		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+		glEnableClientState(GL_COLOR_ARRAY);
+
+#ifdef USE_OPENGL_DESKTOP
+		sGenBuffers = (GenBuffersFunction)SDL_GL_GetProcAddress("glGenBuffers");
+		sDeleteBuffers = (DeleteBuffersFunction)SDL_GL_GetProcAddress("glDeleteBuffers");
+		sBindBuffer = (BindBufferFunction)SDL_GL_GetProcAddress("glBindBuffer");
+		sBufferData = (BufferDataFunction)SDL_GL_GetProcAddress("glBufferData");
+		if(sGenBuffers == NULL || sDeleteBuffers == NULL || sBindBuffer == NULL || sBufferData == NULL)
+		{
+			LOG(LogWarning) << "Vertex buffer objects not supported, drawing from client memory";
+			return;
+		}
+#endif
+
+		// the buffer stays bound and the pointers are offsets into it, each flush only replaces its contents
+		sGenBuffers(1, &vertexBuffer);
+		sBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+		setVertexPointers(NULL);
+		batchStateLost = false;
+	}
+
+	void deinitDrawState()
+	{
+		batch.clear();
+
+		if(vertexBuffer != 0)
+		{
+			sBindBuffer(GL_ARRAY_BUFFER, 0);
+			sDeleteBuffers(1, &vertexBuffer);
+			vertexBuffer = 0;
+		}
+
+		boundTexture = 0;
+		contextGeneration++;
+	}
+
+	static void applyState(bool textured, GLenum blend_sfactor, GLenum blend_dfactor)
+	{
+		if(textured != textureEnabled)
+		{
+			if(textured)
+				glEnable(GL_TEXTURE_2D);
+			else
+				glDisable(GL_TEXTURE_2D);
+			textureEnabled = textured;
+			stateChanges++;
+		}
+
+		if(blend_sfactor != blendSrc || blend_dfactor != blendDst)
+		{
+			glBlendFunc(blend_sfactor, blend_dfactor);
+			blendSrc = blend_sfactor;
+			blendDst = blend_dfactor;
+			stateChanges++;
+		}
+	}
+
+	void flush()
+	{
+		if(batch.empty())
+			return;
+
+		applyState(batchTexture != 0, batchBlendSrc, batchBlendDst);
+
+		if(batchStateLost)
+		{
+			glLoadIdentity();
+			sBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+			setVertexPointers(NULL);
+			batchStateLost = false;
+			stateChanges++;
+		}
+
+		if(vertexBuffer != 0)
+			sBufferData(GL_ARRAY_BUFFER, batch.size() * sizeof(BatchVertex), batch.data(), GL_STREAM_DRAW);
+		else
+			setVertexPointers(batch.data());
+
+		glDrawArrays(batchMode, 0, (GLsizei)batch.size());
+		drawCalls++;
+
+		batch.clear();
+	}
+
+	void finishFrame()
+	{
+		flush();
+
+		lastDrawCalls = drawCalls;
+		lastStateChanges = stateChanges;
+		drawCalls = 0;
+		stateChanges = 0;
+	}
+
+	unsigned int getDrawCallCount() { return lastDrawCalls; }
+	unsigned int getStateChangeCount() { return lastStateChanges; }
+
+	void bindTexture(GLuint texture)
+	{
+		if(texture == boundTexture)
+			return;
+
+		// queued textured geometry needs the old texture bound when it gets drawn
+		if(!batch.empty() && batchTexture != 0)
+			flush();
+
+		glBindTexture(GL_TEXTURE_2D, texture);
+		boundTexture = texture;
+		stateChanges++;
+	}
+
+	void deleteTexture(GLuint texture)
+	{
+		if(!batch.empty() && batchTexture == texture)
+			flush();
+
+		glDeleteTextures(1, &texture);
+		if(texture == boundTexture)
+			boundTexture = 0;
+	}
+
+	static void queue(GLenum mode, const Vertex* vertices, const GLubyte* colors, unsigned int count, GLuint texture, GLenum blend_sfactor, GLenum blend_dfactor)
+	{
+		if(!batch.empty() && (mode != batchMode || texture != batchTexture || blend_sfactor != batchBlendSrc || blend_dfactor != batchBlendDst))
+			flush();
+
+		batchMode = mode;
+		batchTexture = texture;
+		batchBlendSrc = blend_sfactor;
+		batchBlendDst = blend_dfactor;
+
+		// 2D only, so z and w of the transform never matter
+		const float* tm = (const float*)&currentMatrix;
+		const GLuint* colors32 = (const GLuint*)colors;
+		const size_t start = batch.size();
+		batch.resize(start + count);
+
+		for(unsigned int i = 0; i < count; i++)
+		{
+			const Vector2f& pos = vertices[i].pos;
+			BatchVertex& out = batch[start + i];
+			out.x = tm[0] * pos.x() + tm[4] * pos.y() + tm[12];
+			out.y = tm[1] * pos.x() + tm[5] * pos.y() + tm[13];
+			out.u = vertices[i].tex.x();
+			out.v = vertices[i].tex.y();
+			out.color = colors32[i];
+		}
+	}
+
+	void drawTriangles(const Vertex* vertices, const GLubyte* colors, unsigned int count, bool textured, GLenum blend_sfactor, GLenum blend_dfactor)
+	{
+		queue(GL_TRIANGLES, vertices, colors, count, textured ? boundTexture : 0, blend_sfactor, blend_dfactor);
+	}
+
+	void drawLines(const Vertex* vertices, const GLubyte* colors, unsigned int count)
+	{
+		queue(GL_LINES, vertices, colors, count, 0, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	}
+
+	bool hasBuffers() { return vertexBuffer != 0; }
+	unsigned int getContextGeneration() { return contextGeneration; }
+
+	GLuint createBuffer()
+	{
+		GLuint buffer = 0;
+		sGenBuffers(1, &buffer);
+		return buffer;
+	}
+
+	void deleteBuffer(GLuint buffer)
+	{
+		sDeleteBuffers(1, &buffer);
+	}
+
+	void uploadBuffer(GLuint buffer, const void* data, size_t size)
+	{
+		sBindBuffer(GL_ARRAY_BUFFER, buffer);
+		sBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW);
+		batchStateLost = true;
+	}
+
+	void drawBuffers(GLuint vertices, GLuint colors, unsigned int count)
+	{
+		flush();
+		applyState(boundTexture != 0, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+		glLoadMatrixf((const GLfloat*)&currentMatrix);
+
+		sBindBuffer(GL_ARRAY_BUFFER, vertices);
+		glVertexPointer(2, GL_FLOAT, sizeof(Vertex), (const GLvoid*)offsetof(Vertex, pos));
+		glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), (const GLvoid*)offsetof(Vertex, tex));
+		sBindBuffer(GL_ARRAY_BUFFER, colors);
+		glColorPointer(4, GL_UNSIGNED_BYTE, 0, NULL);
+
+		glDrawArrays(GL_TRIANGLES, 0, (GLsizei)count);
+		drawCalls++;
+		stateChanges++;
+
+		batchStateLost = true;
+	}
+
 	void setColor4bArray(GLubyte* array, unsigned int color)
 	{
 		array[0] = ((color & 0xff000000) >> 24) & 255;
@@ -38,6 +321,8 @@ namespace Renderer {
 
 	void pushClipRect(Vector2i pos, Vector2i dim)
 	{
+		flush();
+
 		ClipRect box(pos.x(), pos.y(), dim.x(), dim.y());
 		if(box.w == 0)
 			box.w = Renderer::getScreenWidth() - box.x;
@@ -131,6 +416,7 @@ namespace Renderer {
 			return;
 		}
 
+		flush();
 		clipStack.pop();
 		if(clipStack.empty())
 		{
@@ -148,44 +434,27 @@ namespace Renderer {
 
 	void drawRect(int x, int y, int w, int h, unsigned int color, GLenum blend_sfactor, GLenum blend_dfactor)
 	{
-#ifdef USE_OPENGL_ES
-		GLshort points[12];
-#else
-		GLint points[12];
-#endif
+		Vertex vertices[6];
+		vertices[0].pos = Vector2f((float)x, (float)y);
+		vertices[1].pos = Vector2f((float)x, (float)(y + h));
+		vertices[2].pos = Vector2f((float)(x + w), (float)y);
 
-		points[0] = x; points [1] = y;
-		points[2] = x; points[3] = y + h;
-		points[4] = x + w; points[5] = y;
+		vertices[3].pos = Vector2f((float)(x + w), (float)y);
+		vertices[4].pos = Vector2f((float)x, (float)(y + h));
+		vertices[5].pos = Vector2f((float)(x + w), (float)(y + h));
 
-		points[6] = x + w; points[7] = y;
-		points[8] = x; points[9] = y + h;
-		points[10] = x + w; points[11] = y + h;
+		for(int i = 0; i < 6; i++)
+			vertices[i].tex = Vector2f::Zero();
 
 		GLubyte colors[6*4];
 		buildGLColorArray(colors, color, 6);
 
-		glEnable(GL_BLEND);
-		glBlendFunc(blend_sfactor, blend_dfactor);
-		glEnableClientState(GL_VERTEX_ARRAY);
-		glEnableClientState(GL_COLOR_ARRAY);
-
-#ifdef USE_OPENGL_ES
-		glVertexPointer(2, GL_SHORT, 0, points);
-#else
-		glVertexPointer(2, GL_INT, 0, points);
-#endif
-		glColorPointer(4, GL_UNSIGNED_BYTE, 0, colors);
-
-		glDrawArrays(GL_TRIANGLES, 0, 6);
-
-		glDisable(GL_BLEND);
-		glDisableClientState(GL_VERTEX_ARRAY);
-		glDisableClientState(GL_COLOR_ARRAY);
+		drawTriangles(vertices, colors, 6, false, blend_sfactor, blend_dfactor);
 	}
 
 	void setMatrix(const Transform4x4f& matrix)
 	{
-		glLoadMatrixf((GLfloat*)&matrix);
+		// vertices are transformed when they are queued, so this never has to break a batch
+		currentMatrix = matrix;
 	}
 };
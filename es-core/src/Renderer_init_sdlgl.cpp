@@ -1,6 +1,7 @@
 #include "Renderer.h"
 
 #include "../data/Resources.h"
+#include "resources/TextureCompression.h"
 #include "ImageIO.h"
 #include "Log.h"
 #include "Settings.h"
@@ -113,6 +114,7 @@ namespace Renderer
 		}
 
 		sdlContext = SDL_GL_CreateContext(sdlWindow);
+		TextureCompression::init();
 
 		// vsync
 		if(Settings::getInstance()->getBool("VSync"))
@@ -178,16 +180,20 @@ namespace Renderer
         glMatrixMode(GL_MODELVIEW);
 		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
 
+		initDrawState();
+
 		return true;
 	}
 
 	void deinit()
 	{
+		deinitDrawState();
 		destroySurface();
 	}
 
 	void swapBuffers()
 	{
+		finishFrame();
 		SDL_GL_SwapWindow(sdlWindow);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	}
@@ -19,6 +19,7 @@ std::vector<const char*> settings_dont_save {
 	{ "HideConsole" },
 	{ "ShowExit" },
 	{ "SplashScreen" },
+	{ "ThreadedLoading" },
 	{ "VSync" },
 	{ "Windowed" },
 	{ "WindowWidth" },
@@ -50,6 +51,9 @@ void Settings::setDefaults()
 
 	mBoolMap["BackgroundJoystickInput"] = false;
 	mBoolMap["ParseGamelistOnly"] = false;
+	mBoolMap["ThreadedLoading"] = true;
+	mBoolMap["SystemCache"] = true;
+	mBoolMap["ThemeCache"] = true;
 	mBoolMap["ShowHiddenFiles"] = false;
 	mBoolMap["DrawFramerate"] = false;
 	mBoolMap["ShowExit"] = true;
@@ -58,6 +62,9 @@ void Settings::setDefaults()
 	mStringMap["StartupSystem"] = "";
 
 	mBoolMap["VSync"] = true;
+	mBoolMap["MipmapTextures"] = false;
+	mBoolMap["CompressTextures"] = false; // S3TC or ETC1, if the GPU supports it
+	mBoolMap["SkipIdleFrames"] = true; // don't render or swap while nothing on screen changes
 
 	mBoolMap["EnableSounds"] = true;
 	mBoolMap["ShowHelpPrompts"] = true;
@@ -75,12 +82,19 @@ void Settings::setDefaults()
 	mIntMap["ScreenSaverTime"] = 5*60*1000; // 5 minutes
 	mIntMap["ScraperResizeWidth"] = 400;
 	mIntMap["ScraperResizeHeight"] = 0;
+	mIntMap["ScraperConcurrency"] = 4; // games scraped at once when results don't need approval
+	mIntMap["HttpMaxHostConnections"] = 4; // 0 = no limit
+	mIntMap["HttpMaxHostRequestRate"] = 10; // requests started per second and host, 0 = no limit
+	mIntMap["HttpCacheTTL"] = 30*24*60*60; // seconds before a cached response is revalidated, 30 days
+	mIntMap["HttpCacheSize"] = 100; // MB, 0 disables the http cache
 	#ifdef _RPI_
 		mIntMap["MaxVRAM"] = 80;
 	#else
 		mIntMap["MaxVRAM"] = 100;
 	#endif
         mIntMap["Rotate"] = 0;
+	mIntMap["TextureLoaderThreads"] = 0; // 0 = one per core, up to 4
+	mIntMap["ThumbnailCacheSize"] = 200; // MB, 0 disables the downscaled texture cache
 
 	mStringMap["TransitionStyle"] = "fade";
 	mStringMap["ThemeSet"] = "";
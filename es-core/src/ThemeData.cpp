@@ -2,13 +2,25 @@
 
 #include "components/ImageComponent.h"
 #include "components/TextComponent.h"
+#include "utils/CacheStream.h"
 #include "Log.h"
 #include "platform.h"
 #include "Settings.h"
 #include <boost/filesystem/operations.hpp>
 #include <pugixml/src/pugixml.hpp>
+#include <fstream>
 
-std::vector<std::string> ThemeData::sSupportedViews { { "system" }, { "basic" }, { "detailed" }, { "video" } };
+// bump this whenever the layout below or the way themes are parsed changes, old cache entries are then simply rebuilt
+#define THEME_CACHE_MAGIC   "ESTH"
+#define THEME_CACHE_VERSION 1
+
+// cache entry layout (native endianness):
+//   magic, version, theme path, system variables,
+//   every file the theme was built from with its mtime and size,
+//   format version, then the views with their element order and elements:
+//   key, type, extra flag and the properties, each stored as the type sElementMap gives it
+
+std::vector<std::string> ThemeData::sSupportedViews { { "system" }, { "basic" }, { "detailed" }, { "video" }, { "grid" } };
 std::vector<std::string> ThemeData::sSupportedFeatures { { "video" }, { "carousel" }, { "z-index" } };
 
 std::map<std::string, std::map<std::string, ThemeData::ElementPropertyType>> ThemeData::sElementMap {
@@ -193,6 +205,39 @@ std::string resolvePlaceholders(const char* in)
 	return prefix + mVariables[replace] + suffix;
 }
 
+// parsed include files, shared between the themes of all systems while an IncludeCacheScope is open,
+// since most themes pull the same large common file into every one of them
+static std::map<std::string, std::shared_ptr<pugi::xml_document> > sIncludeCache;
+static int sIncludeCacheScopes = 0;
+
+ThemeData::IncludeCacheScope::IncludeCacheScope()
+{
+	sIncludeCacheScopes++;
+}
+
+ThemeData::IncludeCacheScope::~IncludeCacheScope()
+{
+	if(--sIncludeCacheScopes == 0)
+		sIncludeCache.clear();
+}
+
+static std::shared_ptr<pugi::xml_document> loadInclude(const std::string& path, pugi::xml_parse_result& result)
+{
+	auto it = sIncludeCache.find(path);
+	if(it != sIncludeCache.cend())
+		return it->second;
+
+	std::shared_ptr<pugi::xml_document> doc = std::make_shared<pugi::xml_document>();
+	result = doc->load_file(path.c_str());
+	if(!result)
+		return nullptr;
+
+	if(sIncludeCacheScopes > 0)
+		sIncludeCache[path] = doc;
+
+	return doc;
+}
+
 ThemeData::ThemeData()
 {
 	mVersion = 0;
@@ -211,7 +256,12 @@ void ThemeData::loadFile(std::map<std::string, std::string> sysDataMap, const st
 	mVersion = 0;
 	mViews.clear();
 	mVariables.clear();
+	mFiles.clear();
+
+	if(loadCache(sysDataMap, path))
+		return;
 
+	mFiles.push_back(path);
 	mVariables.insert(sysDataMap.cbegin(), sysDataMap.cend());
 
 	pugi::xml_document doc;
@@ -235,6 +285,8 @@ void ThemeData::loadFile(std::map<std::string, std::string> sysDataMap, const st
 	parseIncludes(root);
 	parseViews(root);
 	parseFeatures(root);
+
+	saveCache(sysDataMap, path);
 }
 
 void ThemeData::parseIncludes(const pugi::xml_node& root)
@@ -252,13 +304,14 @@ void ThemeData::parseIncludes(const pugi::xml_node& root)
 		error << "    from included file \"" << relPath << "\":\n    ";
 
 		mPaths.push_back(path);
+		mFiles.push_back(path);
 
-		pugi::xml_document includeDoc;
-		pugi::xml_parse_result result = includeDoc.load_file(path.c_str());
-		if(!result)
+		pugi::xml_parse_result result;
+		std::shared_ptr<pugi::xml_document> includeDoc = loadInclude(path, result);
+		if(!includeDoc)
 			throw error << "Error parsing file: \n    " << result.description();
 
-		pugi::xml_node theme = includeDoc.child("theme");
+		pugi::xml_node theme = includeDoc->child("theme");
 		if(!theme)
 			throw error << "Missing <theme> tag!";
 
@@ -451,6 +504,237 @@ void ThemeData::parseElement(const pugi::xml_node& root, const std::map<std::str
 	}
 }
 
+static std::string getThemeCachePath(const std::map<std::string, std::string>& sysDataMap, const std::string& path)
+{
+	std::string key = path;
+	for(auto it = sysDataMap.cbegin(); it != sysDataMap.cend(); it++)
+		key += "|" + it->first + "=" + it->second;
+
+	char name[64];
+	snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)std::hash<std::string>()(key));
+	return getHomePath() + "/.emulationstation/cache/themes/" + name;
+}
+
+// everything that changes the parsed theme without touching its files
+static void writeThemeCacheHeader(CacheWriter& writer, const std::map<std::string, std::string>& sysDataMap, const std::string& path)
+{
+	writer.writeString(THEME_CACHE_MAGIC);
+	writer.writeU32(THEME_CACHE_VERSION);
+	writer.writeString(path);
+
+	writer.writeU32((uint32_t)sysDataMap.size());
+	for(auto it = sysDataMap.cbegin(); it != sysDataMap.cend(); it++)
+	{
+		writer.writeString(it->first);
+		writer.writeString(it->second);
+	}
+}
+
+bool ThemeData::loadCache(const std::map<std::string, std::string>& sysDataMap, const std::string& path)
+{
+	if(!Settings::getInstance()->getBool("ThemeCache"))
+		return false;
+
+	std::ifstream file(getThemeCachePath(sysDataMap, path).c_str(), std::ios::in | std::ios::binary);
+	if(!file.is_open())
+		return false;
+
+	std::string buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	file.close();
+
+	CacheWriter expectedHeader;
+	writeThemeCacheHeader(expectedHeader, sysDataMap, path);
+	if(buffer.compare(0, expectedHeader.getBuffer().size(), expectedHeader.getBuffer()) != 0)
+		return false;
+
+	const std::string body = buffer.substr(expectedHeader.getBuffer().size());
+	CacheReader reader(body);
+	boost::system::error_code ec;
+
+	// every file the theme was built from must be untouched since the entry was written
+	const unsigned int fileCount = reader.readU32();
+	for(unsigned int i = 0; i < fileCount && reader.ok(); i++)
+	{
+		std::string filePath = reader.readString();
+		int64_t fileTime = reader.readI64();
+		int64_t fileSize = reader.readI64();
+		if((int64_t)boost::filesystem::last_write_time(filePath, ec) != fileTime || (int64_t)boost::filesystem::file_size(filePath, ec) != fileSize || ec)
+		{
+			LOG(LogInfo) << "Theme cache for \"" << path << "\" is out of date (\"" << filePath << "\" changed)";
+			mFiles.clear();
+			return false;
+		}
+		mFiles.push_back(filePath);
+	}
+
+	mVersion = reader.readFloat();
+
+	const unsigned int viewCount = reader.readU32();
+	for(unsigned int i = 0; i < viewCount && reader.ok(); i++)
+	{
+		ThemeView& view = mViews[reader.readString()];
+
+		const unsigned int keyCount = reader.readU32();
+		for(unsigned int j = 0; j < keyCount && reader.ok(); j++)
+			view.orderedKeys.push_back(reader.readString());
+
+		const unsigned int elementCount = reader.readU32();
+		for(unsigned int j = 0; j < elementCount && reader.ok(); j++)
+		{
+			ThemeElement& element = view.elements[reader.readString()];
+			element.type = reader.readString();
+			element.extra = reader.readU8() != 0;
+
+			auto typeMapIt = sElementMap.find(element.type);
+			const unsigned int propertyCount = reader.readU32();
+			for(unsigned int k = 0; k < propertyCount && reader.ok(); k++)
+			{
+				const std::string name = reader.readString();
+				if(typeMapIt == sElementMap.cend() || typeMapIt->second.find(name) == typeMapIt->second.cend())
+				{
+					mVersion = 0;
+					mViews.clear();
+					mFiles.clear();
+					return false;
+				}
+
+				ThemeElement::Property& property = element.properties[name];
+				switch(typeMapIt->second.at(name))
+				{
+				case NORMALIZED_PAIR:
+				{
+					const float x = reader.readFloat();
+					const float y = reader.readFloat();
+					property = Vector2f(x, y);
+					break;
+				}
+				case PATH:
+				case STRING:
+					property = reader.readString();
+					break;
+				case COLOR:
+					property = (unsigned int)reader.readU32();
+					break;
+				case FLOAT:
+					property = reader.readFloat();
+					break;
+				case BOOLEAN:
+					property = reader.readU8() != 0;
+					break;
+				}
+			}
+		}
+	}
+
+	if(!reader.ok())
+	{
+		LOG(LogWarning) << "Theme cache for \"" << path << "\" is corrupt, rebuilding it";
+		mVersion = 0;
+		mViews.clear();
+		mFiles.clear();
+		return false;
+	}
+
+	return true;
+}
+
+void ThemeData::saveCache(const std::map<std::string, std::string>& sysDataMap, const std::string& path)
+{
+	if(!Settings::getInstance()->getBool("ThemeCache"))
+		return;
+
+	CacheWriter writer;
+	writeThemeCacheHeader(writer, sysDataMap, path);
+	boost::system::error_code ec;
+
+	writer.writeU32((uint32_t)mFiles.size());
+	for(auto it = mFiles.cbegin(); it != mFiles.cend(); it++)
+	{
+		const int64_t fileTime = (int64_t)boost::filesystem::last_write_time(*it, ec);
+		if(ec)
+			return;
+
+		const int64_t fileSize = (int64_t)boost::filesystem::file_size(*it, ec);
+		if(ec)
+			return;
+
+		writer.writeString(*it);
+		writer.writeI64(fileTime);
+		writer.writeI64(fileSize);
+	}
+
+	writer.writeFloat(mVersion);
+
+	writer.writeU32((uint32_t)mViews.size());
+	for(auto viewIt = mViews.cbegin(); viewIt != mViews.cend(); viewIt++)
+	{
+		writer.writeString(viewIt->first);
+
+		const ThemeView& view = viewIt->second;
+		writer.writeU32((uint32_t)view.orderedKeys.size());
+		for(auto it = view.orderedKeys.cbegin(); it != view.orderedKeys.cend(); it++)
+			writer.writeString(*it);
+
+		writer.writeU32((uint32_t)view.elements.size());
+		for(auto elemIt = view.elements.cbegin(); elemIt != view.elements.cend(); elemIt++)
+		{
+			const ThemeElement& element = elemIt->second;
+			writer.writeString(elemIt->first);
+			writer.writeString(element.type);
+			writer.writeU8(element.extra);
+
+			const std::map<std::string, ElementPropertyType>& typeMap = sElementMap.at(element.type);
+			writer.writeU32((uint32_t)element.properties.size());
+			for(auto it = element.properties.cbegin(); it != element.properties.cend(); it++)
+			{
+				writer.writeString(it->first);
+				switch(typeMap.at(it->first))
+				{
+				case NORMALIZED_PAIR:
+					writer.writeFloat(it->second.v.x());
+					writer.writeFloat(it->second.v.y());
+					break;
+				case PATH:
+				case STRING:
+					writer.writeString(it->second.s);
+					break;
+				case COLOR:
+					writer.writeU32(it->second.i);
+					break;
+				case FLOAT:
+					writer.writeFloat(it->second.f);
+					break;
+				case BOOLEAN:
+					writer.writeU8(it->second.b);
+					break;
+				}
+			}
+		}
+	}
+
+	// write through a temporary file so a partially written entry is never picked up
+	boost::filesystem::path cachePath(getThemeCachePath(sysDataMap, path));
+	boost::filesystem::path tempPath(cachePath.generic_string() + ".tmp");
+	boost::filesystem::create_directories(cachePath.parent_path(), ec);
+
+	std::ofstream file(tempPath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if(!file.is_open())
+		return;
+
+	file.write(writer.getBuffer().data(), writer.getBuffer().size());
+	file.close();
+
+	if(file.fail())
+	{
+		boost::filesystem::remove(tempPath, ec);
+		return;
+	}
+
+	boost::filesystem::rename(tempPath, cachePath, ec);
+	if(ec)
+		LOG(LogWarning) << "Error writing theme cache \"" << cachePath << "\": " << ec.message();
+}
+
 bool ThemeData::hasView(const std::string& view)
 {
 	auto viewIt = mViews.find(view);
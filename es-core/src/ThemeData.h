@@ -130,6 +130,15 @@ private:
 
 public:
 
+	// While one of these exists, included theme files are parsed only once and shared between all themes loaded;
+	// the parsed files are dropped when the last one goes away. Wrap batches of theme loads (all systems) in one.
+	class IncludeCacheScope
+	{
+	public:
+		IncludeCacheScope();
+		~IncludeCacheScope();
+	};
+
 	ThemeData();
 
 	// throws ThemeException
@@ -172,7 +181,12 @@ private:
 	void parseView(const pugi::xml_node& viewNode, ThemeView& view);
 	void parseElement(const pugi::xml_node& elementNode, const std::map<std::string, ElementPropertyType>& typeMap, ThemeElement& element);
 
+	// the compiled theme cache in ~/.emulationstation/cache/themes/, valid while none of mFiles changed
+	bool loadCache(const std::map<std::string, std::string>& sysDataMap, const std::string& path);
+	void saveCache(const std::map<std::string, std::string>& sysDataMap, const std::string& path);
+
 	std::map<std::string, ThemeView> mViews;
+	std::vector<std::string> mFiles; // the theme file and every file it included
 };
 
 #endif // ES_CORE_THEME_DATA_H
@@ -2,15 +2,18 @@
 
 #include "components/HelpComponent.h"
 #include "components/ImageComponent.h"
+#include "components/VideoVlcComponent.h"
 #include "resources/Font.h"
+#include "resources/SVGRasterCache.h"
 #include "resources/TextureResource.h"
+#include "resources/ThumbnailCache.h"
 #include "InputManager.h"
 #include "Log.h"
 #include "Renderer.h"
 #include <iomanip>
 
 Window::Window() : mNormalizeNextUpdate(false), mFrameTimeElapsed(0), mFrameCountElapsed(0), mAverageDeltaTime(10),
-	mAllowSleep(true), mSleeping(false), mTimeSinceLastInput(0), mScreenSaver(NULL), mRenderScreenSaver(false), mInfoPopup(NULL)
+	mDirty(true), mLastDecodeCount(0), mRenderedFrameCount(0), mSkippedFrameCount(0), mAllowSleep(true), mSleeping(false), mTimeSinceLastInput(0), mScreenSaver(NULL), mRenderScreenSaver(false), mInfoPopup(NULL)
 {
 	mHelp = new HelpComponent(this);
 	mBackgroundOverlay = new ImageComponent(this);
@@ -36,6 +39,7 @@ void Window::pushGui(GuiComponent* gui)
 	}
 	mGuiStack.push_back(gui);
 	gui->updateHelpPrompts();
+	invalidate();
 }
 
 void Window::removeGui(GuiComponent* gui)
@@ -45,6 +49,7 @@ void Window::removeGui(GuiComponent* gui)
 		if(*i == gui)
 		{
 			i = mGuiStack.erase(i);
+			invalidate();
 
 			if(i == mGuiStack.cend() && mGuiStack.size()) // we just popped the stack and the stack is not empty
 			{
@@ -92,6 +97,9 @@ bool Window::init()
 	if(peekGui())
 		peekGui()->updateHelpPrompts();
 
+	// the new context starts out with nothing on screen
+	invalidate();
+
 	return true;
 }
 
@@ -109,12 +117,16 @@ void Window::deinit()
 
 void Window::textInput(const char* text)
 {
+	invalidate();
+
 	if(peekGui())
 		peekGui()->textInput(text);
 }
 
 void Window::input(InputConfig* config, Input input)
 {
+	invalidate();
+
 	if (mScreenSaver) {
 		if(mScreenSaver->isScreenSaverActive() && Settings::getInstance()->getBool("ScreenSaverControls") &&
 		   (Settings::getInstance()->getString("ScreenSaverBehavior") == "random video"))
@@ -199,6 +211,10 @@ void Window::update(int deltaTime)
 			// fps
 			ss << std::fixed << std::setprecision(1) << (1000.0f * (float)mFrameCountElapsed / (float)mFrameTimeElapsed) << "fps, ";
 			ss << std::fixed << std::setprecision(2) << ((float)mFrameTimeElapsed / (float)mFrameCountElapsed) << "ms";
+			ss << " Rendered: " << mRenderedFrameCount << " Skipped: " << mSkippedFrameCount;
+
+			// renderer batching, of the last frame
+			ss << " Draw calls: " << Renderer::getDrawCallCount() << " State changes: " << Renderer::getStateChangeCount();
 
 			// vram
 			float textureVramUsageMb = TextureResource::getTotalMemUsage() / 1000.0f / 1000.0f;
@@ -207,11 +223,31 @@ void Window::update(int deltaTime)
 
 			ss << "\nFont VRAM: " << fontVramUsageMb << " Tex VRAM: " << textureVramUsageMb <<
 				  " Tex Max: " << textureTotalUsageMb;
+
+			// texture loader
+			TextureLoader* loader = TextureResource::getTextureLoader();
+			ss << "\nTex queue: " << loader->getQueueLength() << " Decoded: " << loader->getDecodeCount() <<
+				  " (" << loader->getAverageDecodeLatency() << "ms) Cancelled: " << loader->getCancelledCount() <<
+				  " Wasted: " << loader->getWastedDecodeCount();
+
+			// video frames
+			ss << "\nVideo frames uploaded: " << VideoVlcComponent::getUploadedFrameCount() <<
+				  " Duplicated: " << VideoVlcComponent::getDuplicatedFrameCount() <<
+				  " Dropped: " << VideoVlcComponent::getDroppedFrameCount();
+
+			// thumbnail cache
+			ThumbnailCache* thumbnails = ThumbnailCache::getInstance();
+			ss << "\nThumbnails hit: " << thumbnails->getHitCount() << " miss: " << thumbnails->getMissCount() <<
+				  " evicted: " << thumbnails->getEvictionCount() << " disk: " << (thumbnails->getTotalSize() / 1000.0f / 1000.0f) << "MB";
+			ss << " SVG hit: " << SVGRasterCache::getInstance()->getHitCount() << " miss: " << SVGRasterCache::getInstance()->getMissCount();
 			mFrameDataText = std::unique_ptr<TextCache>(mDefaultFonts.at(1)->buildTextCache(ss.str(), 50.f, 50.f, 0xFF00FFFF));
+			invalidate();
 		}
 
 		mFrameTimeElapsed = 0;
 		mFrameCountElapsed = 0;
+		mRenderedFrameCount = 0;
+		mSkippedFrameCount = 0;
 	}
 
 	mTimeSinceLastInput += deltaTime;
@@ -224,10 +260,37 @@ void Window::update(int deltaTime)
 		mScreenSaver->update(deltaTime);
 }
 
+bool Window::needsRender()
+{
+	bool dirty = mDirty || !Settings::getInstance()->getBool("SkipIdleFrames");
+
+	// something finished loading in the background, whoever waits for it draws it on the next frame
+	const size_t decodeCount = TextureResource::getTextureLoader()->getDecodeCount();
+	if(decodeCount != mLastDecodeCount)
+	{
+		mLastDecodeCount = decodeCount;
+		dirty = true;
+	}
+
+	// the screensaver (and starting it, or going to sleep) is handled by render(), and busy components show progress
+	const unsigned int screensaverTime = (unsigned int)Settings::getInstance()->getInt("ScreenSaverTime");
+	if(mRenderScreenSaver || (mScreenSaver && mScreenSaver->isScreenSaverActive()) || (mTimeSinceLastInput >= screensaverTime && screensaverTime != 0) || isProcessing())
+		dirty = true;
+
+	if(!dirty)
+		mSkippedFrameCount++;
+
+	return dirty;
+}
+
 void Window::render()
 {
 	Transform4x4f transform = Transform4x4f::Identity();
 
+	// anything invalidated while rendering (e.g. a fade that goes on) asks for the next frame
+	mDirty = false;
+	mRenderedFrameCount++;
+
 	mRenderedHelpPrompts = false;
 
 	// draw only bottom and top of GuiStack (if they are different)
@@ -292,7 +355,7 @@ void Window::setAllowSleep(bool sleep)
 	mAllowSleep = sleep;
 }
 
-void Window::renderLoadingScreen()
+void Window::renderLoadingScreen(const std::string& text)
 {
 	Transform4x4f trans = Transform4x4f::Identity();
 	Renderer::setMatrix(trans);
@@ -305,7 +368,7 @@ void Window::renderLoadingScreen()
 	splash.render(trans);
 
 	auto& font = mDefaultFonts.at(1);
-	TextCache* cache = font->buildTextCache("LOADING...", 0, 0, 0x656565FF);
+	TextCache* cache = font->buildTextCache(text, 0, 0, 0x656565FF);
 	trans = trans.translate(Vector3f(Math::round((Renderer::getScreenWidth() - cache->metrics.size.x()) / 2.0f),
 		Math::round(Renderer::getScreenHeight() * 0.835f), 0.0f));
 	Renderer::setMatrix(trans);
@@ -323,6 +386,8 @@ void Window::renderHelpPromptsEarly()
 
 void Window::setHelpPrompts(const std::vector<HelpPrompt>& prompts, const HelpStyle& style)
 {
+	invalidate();
+
 	mHelp->clearPrompts();
 	mHelp->setStyle(style);
 
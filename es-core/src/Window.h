@@ -54,6 +54,12 @@ public:
 	void update(int deltaTime);
 	void render();
 
+	// Marks the screen as changed, so the next frame gets rendered.
+	inline void invalidate() { mDirty = true; }
+	// Returns false if nothing on screen changed since the last render(), which (and the buffer swap) can then be skipped.
+	// Counts a skipped frame when it does.
+	bool needsRender();
+
 	bool init();
 	void deinit();
 
@@ -63,13 +69,13 @@ public:
 	bool getAllowSleep();
 	void setAllowSleep(bool sleep);
 
-	void renderLoadingScreen();
+	void renderLoadingScreen(const std::string& text = "LOADING...");
 
 	void renderHelpPromptsEarly(); // used to render HelpPrompts before a fade
 	void setHelpPrompts(const std::vector<HelpPrompt>& prompts, const HelpStyle& style);
 
 	void setScreenSaver(ScreenSaver* screenSaver) { mScreenSaver = screenSaver; }
-	void setInfoPopup(InfoPopup* infoPopup) { delete mInfoPopup; mInfoPopup = infoPopup; }
+	void setInfoPopup(InfoPopup* infoPopup) { delete mInfoPopup; mInfoPopup = infoPopup; invalidate(); }
 	inline void stopInfoPopup() { if (mInfoPopup) mInfoPopup->stop(); };
 
 	void startScreenSaver();
@@ -97,6 +103,11 @@ private:
 	int mFrameCountElapsed;
 	int mAverageDeltaTime;
 
+	bool mDirty;
+	size_t mLastDecodeCount; // of the texture loader, a finished load has to be shown
+	int mRenderedFrameCount;
+	int mSkippedFrameCount;
+
 	std::unique_ptr<TextCache> mFrameDataText;
 
 	bool mNormalizeNextUpdate;
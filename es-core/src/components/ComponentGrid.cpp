@@ -147,6 +147,14 @@ void ComponentGrid::updateCellComponent(const GridEntry& cell)
 	cell.component->setPosition(pos);
 }
 
+static Renderer::Vertex lineVertex(float x, float y)
+{
+	Renderer::Vertex vertex;
+	vertex.pos = Vector2f(x, y);
+	vertex.tex = Vector2f::Zero();
+	return vertex;
+}
+
 void ComponentGrid::updateSeparators()
 {
 	mLines.clear();
@@ -174,27 +182,27 @@ void ComponentGrid::updateSeparators()
 
 		if(it->border & BORDER_TOP || drawAll)
 		{
-			mLines.push_back(Vert(pos.x(), pos.y()));
-			mLines.push_back(Vert(pos.x() + size.x(), pos.y()));
+			mLines.push_back(lineVertex(pos.x(), pos.y()));
+			mLines.push_back(lineVertex(pos.x() + size.x(), pos.y()));
 		}
 		if(it->border & BORDER_BOTTOM || drawAll)
 		{
-			mLines.push_back(Vert(pos.x(), pos.y() + size.y()));
-			mLines.push_back(Vert(pos.x() + size.x(), mLines.back().y));
+			mLines.push_back(lineVertex(pos.x(), pos.y() + size.y()));
+			mLines.push_back(lineVertex(pos.x() + size.x(), mLines.back().pos.y()));
 		}
 		if(it->border & BORDER_LEFT || drawAll)
 		{
-			mLines.push_back(Vert(pos.x(), pos.y()));
-			mLines.push_back(Vert(pos.x(), pos.y() + size.y()));
+			mLines.push_back(lineVertex(pos.x(), pos.y()));
+			mLines.push_back(lineVertex(pos.x(), pos.y() + size.y()));
 		}
 		if(it->border & BORDER_RIGHT || drawAll)
 		{
-			mLines.push_back(Vert(pos.x() + size.x(), pos.y()));
-			mLines.push_back(Vert(mLines.back().x, pos.y() + size.y()));
+			mLines.push_back(lineVertex(pos.x() + size.x(), pos.y()));
+			mLines.push_back(lineVertex(mLines.back().pos.x(), pos.y() + size.y()));
 		}
 	}
 
-	mLineColors.reserve(mLines.size());
+	mLineColors.resize(mLines.size());
 	Renderer::buildGLColorArray((GLubyte*)mLineColors.data(), 0xC6C7C6FF, (unsigned int)mLines.size());
 }
 
@@ -365,20 +373,7 @@ void ComponentGrid::render(const Transform4x4f& parentTrans)
 	if(mLines.size())
 	{
 		Renderer::setMatrix(trans);
-
-		glEnable(GL_BLEND);
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-		glEnableClientState(GL_VERTEX_ARRAY);
-		glEnableClientState(GL_COLOR_ARRAY);
-
-		glVertexPointer(2, GL_FLOAT, 0, &mLines[0].x);
-		glColorPointer(4, GL_UNSIGNED_BYTE, 0, mLineColors.data());
-
-		glDrawArrays(GL_LINES, 0, (GLsizei)mLines.size());
-
-		glDisable(GL_BLEND);
-		glDisableClientState(GL_VERTEX_ARRAY);
-		glDisableClientState(GL_COLOR_ARRAY);
+		Renderer::drawLines(mLines.data(), (const GLubyte*)mLineColors.data(), (unsigned int)mLines.size());
 	}
 }
 
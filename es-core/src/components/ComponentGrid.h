@@ -4,6 +4,7 @@
 
 #include "math/Vector2i.h"
 #include "GuiComponent.h"
+#include "Renderer.h"
 
 namespace GridFlags
 {
@@ -96,14 +97,7 @@ private:
 	float* mRowHeights;
 	float* mColWidths;
 	
-	struct Vert
-	{
-		Vert(float xi = 0, float yi = 0) : x(xi), y(yi) {};
-		float x;
-		float y;
-	};
-
-	std::vector<Vert> mLines;
+	std::vector<Renderer::Vertex> mLines;
 	std::vector<unsigned int> mLineColors;
 
 	// Update position & size
@@ -132,6 +132,7 @@ void DateTimeComponent::update(int deltaTime)
 		{
 			mRelativeUpdateAccumulator = 0;
 			updateTextCache();
+			invalidate();
 		}
 	}
 
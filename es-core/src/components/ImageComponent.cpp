@@ -105,7 +105,14 @@ void ImageComponent::setImage(std::string path, bool tile)
 		else
 			mTexture = TextureResource::get(mDefaultPath, tile, mForceLoad, mDynamic);
 	} else {
-		mTexture = TextureResource::get(path, tile, mForceLoad, mDynamic);
+		// with setMaxSize() the image keeps its aspect ratio and is never drawn larger than the target on either side,
+		// so a big scan can be kept scaled down (rounded up so components of similar size share textures);
+		// setResize() may stretch it to another aspect ratio, so that keeps the full image
+		size_t maxSize = 0;
+		if(mTargetIsMax && mTargetSize.x() > 0 && mTargetSize.y() > 0)
+			maxSize = (((size_t)Math::max(mTargetSize.x(), mTargetSize.y()) + 63) / 64) * 64;
+
+		mTexture = TextureResource::get(path, tile, mForceLoad, mDynamic, maxSize);
 	}
 
 	resize();
@@ -237,26 +244,7 @@ void ImageComponent::render(const Transform4x4f& parentTrans)
 			// when it finally loads
 			fadeIn(mTexture->bind());
 
-			glEnable(GL_TEXTURE_2D);
-			glEnable(GL_BLEND);
-			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-			glEnableClientState(GL_VERTEX_ARRAY);
-			glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-			glEnableClientState(GL_COLOR_ARRAY);
-
-			glVertexPointer(2, GL_FLOAT, sizeof(Vertex), &mVertices[0].pos);
-			glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), &mVertices[0].tex);
-			glColorPointer(4, GL_UNSIGNED_BYTE, 0, mColors);
-
-			glDrawArrays(GL_TRIANGLES, 0, 6);
-
-			glDisableClientState(GL_VERTEX_ARRAY);
-			glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-			glDisableClientState(GL_COLOR_ARRAY);
-
-			glDisable(GL_TEXTURE_2D);
-			glDisable(GL_BLEND);
+			Renderer::drawTriangles(mVertices, mColors, 6);
 		}else{
 			LOG(LogError) << "Image texture is not initialized!";
 			mTexture.reset();
@@ -299,6 +287,9 @@ void ImageComponent::fadeIn(bool textureLoaded)
 			{
 				mFadeOpacity = (unsigned char)opacity;
 			}
+			// Keep the frames coming until the fade is done
+			invalidate();
+
 			// Apply the combination of the target opacity and current fade
 			float newOpacity = (float)mOpacity * ((float)mFadeOpacity / 255.0f);
 			mColorShift = (mColorShift >> 8 << 8) | (unsigned char)newOpacity;
@@ -4,8 +4,7 @@
 
 #include "math/Vector2i.h"
 #include "GuiComponent.h"
-#include "platform.h"
-#include GLHEADER
+#include "Renderer.h"
 
 class TextureResource;
 
@@ -65,11 +64,7 @@ private:
 	// Used internally whenever the resizing parameters or texture change.
 	void resize();
 
-	struct Vertex
-	{
-		Vector2f pos;
-		Vector2f tex;
-	} mVertices[6];
+	Renderer::Vertex mVertices[6];
 
 	GLubyte mColors[6*4];
 
@@ -3,13 +3,23 @@
 #define ES_CORE_COMPONENTS_IMAGE_GRID_COMPONENT_H
 
 #include "components/IList.h"
+#include "resources/TextureAtlas.h"
+#include "resources/TextureData.h"
+#include "resources/TextureDataManager.h"
 #include "resources/TextureResource.h"
+#include "Renderer.h"
+#include "Util.h"
+
+// rows above and below the visible ones whose images are loaded ahead of time
+#define GRID_PREFETCH_ROWS 2
 
 struct ImageGridData
 {
-	std::shared_ptr<TextureResource> texture;
+	std::string imagePath;
 };
 
+// Only the entries on screen, plus GRID_PREFETCH_ROWS rows on either side, hold an image. The images are
+// decoded on the texture loader threads into the cells of one TextureAtlas, so the whole page is a single draw call.
 template<typename T>
 class ImageGridComponent : public IList<ImageGridData, T>
 {
@@ -32,7 +42,7 @@ public:
 	ImageGridComponent(Window* window);
 
 	void add(const std::string& name, const std::string& imagePath, const T& obj);
-	
+
 	void onSizeChanged() override;
 
 	bool input(InputConfig* config, Input input) override;
@@ -40,72 +50,67 @@ public:
 	void render(const Transform4x4f& parentTrans) override;
 
 private:
-	Vector2f getSquareSize(std::shared_ptr<TextureResource> tex = nullptr) const
+	// an atlas cell and the entry whose image it holds
+	struct Tile
 	{
-		Vector2f aspect(1, 1);
-
-		if(tex)
-		{
-			const Vector2i& texSize = tex->getSize();
-
-			if(texSize.x() > texSize.y())
-				aspect[0] = (float)texSize.x() / texSize.y();
-			else
-				aspect[1] = (float)texSize.y() / texSize.x();
-		}
-
-		return Vector2f(156 * aspect.x(), 156 * aspect.y());
+		int entry; // -1 if the cell is free
+		std::shared_ptr<TextureData> loading; // until the image is in the atlas
+		size_t width;
+		size_t height; // of the image in the cell, 0 until it is there
 	};
 
-	Vector2f getMaxSquareSize() const
-	{
-		Vector2f squareSize(32, 32);
-
-		// calc biggest square size
-		for(auto it = mEntries.cbegin(); it != mEntries.cend(); it++)
-		{
-			Vector2f chkSize = getSquareSize(it->data.texture);
-			if(chkSize.x() > squareSize.x())
-				squareSize[0] = chkSize[0];
-			if(chkSize.y() > squareSize.y())
-				squareSize[1] = chkSize[1];
-		}
-
-		return squareSize;
-	};
+	// every image is fitted into a square of this size
+	Vector2f getSquareSize() const { return Vector2f(156, 156); }
 
 	Vector2i getGridSize() const
 	{
-		Vector2f squareSize = getMaxSquareSize();
+		Vector2f squareSize = getSquareSize();
 		Vector2i gridSize((int)(mSize.x() / (squareSize.x() + getPadding().x())), (int)(mSize.y() / (squareSize.y() + getPadding().y())));
 		return gridSize;
 	};
 
 	Vector2f getPadding() const { return Vector2f(24, 24); }
-	
-	void buildImages();
-	void updateImages();
+
+	int getFirstVisible() const;
+
+	void buildTiles();
+	void updateTiles();
+	void releaseTile(Tile& tile);
+	void uploadTiles();
+	void buildVertices();
 
 	virtual void onCursorChanged(const CursorState& state);
 
 	bool mEntriesDirty;
+	size_t mEntryCount;
 
-	std::vector<ImageComponent> mImages;
+	std::shared_ptr<TextureAtlas> mAtlas;
+	unsigned int mAtlasGeneration;
+	std::vector<Tile> mTiles; // one per atlas cell
+	std::vector<int> mEntryTiles; // tile of each entry, -1 if it has none
+
+	std::vector<Renderer::Vertex> mVertices;
+	std::vector<GLubyte> mColors;
+	bool mVerticesDirty;
 };
 
 template<typename T>
 ImageGridComponent<T>::ImageGridComponent(Window* window) : IList<ImageGridData, T>(window)
 {
 	mEntriesDirty = true;
+	mEntryCount = 0;
+	mAtlasGeneration = 0;
+	mVerticesDirty = true;
 }
 
 template<typename T>
 void ImageGridComponent<T>::add(const std::string& name, const std::string& imagePath, const T& obj)
 {
+	// nothing is loaded until the entry comes close to the screen
 	typename IList<ImageGridData, T>::Entry entry;
 	entry.name = name;
 	entry.object = obj;
-	entry.data.texture = ResourceManager::getInstance()->fileExists(imagePath) ? TextureResource::get(imagePath) : TextureResource::get(":/button.png");
+	entry.data.imagePath = imagePath;
 	static_cast<IList< ImageGridData, T >*>(this)->add(entry);
 	mEntriesDirty = true;
 }
@@ -149,18 +154,25 @@ void ImageGridComponent<T>::update(int deltaTime)
 template<typename T>
 void ImageGridComponent<T>::render(const Transform4x4f& parentTrans)
 {
-	Transform4x4f trans = getTransform() * parentTrans;
+	Transform4x4f trans = parentTrans * getTransform();
 
-	if(mEntriesDirty)
-	{
-		buildImages();
-		updateImages();
-		mEntriesDirty = false;
-	}
+	if(!mAtlas)
+		buildTiles();
+
+	if(mEntriesDirty || mEntryCount != mEntries.size() || (mAtlas && mAtlas->getGeneration() != mAtlasGeneration))
+		updateTiles();
+
+	uploadTiles();
 
-	for(auto it = mImages.begin(); it != mImages.end(); it++)
+	if(mVerticesDirty)
+		buildVertices();
+
+	if(!mVertices.empty())
 	{
-		it->render(trans);
+		Renderer::setMatrix(trans);
+		mAtlas->bind();
+
+		Renderer::drawTriangles(mVertices.data(), mColors.data(), (unsigned int)mVertices.size());
 	}
 
 	GuiComponent::renderChildren(trans);
@@ -169,87 +181,239 @@ void ImageGridComponent<T>::render(const Transform4x4f& parentTrans)
 template<typename T>
 void ImageGridComponent<T>::onCursorChanged(const CursorState& /*state*/)
 {
-	updateImages();
+	updateTiles();
 }
 
 template<typename T>
 void ImageGridComponent<T>::onSizeChanged()
 {
-	buildImages();
-	updateImages();
+	buildTiles();
+	updateTiles();
 }
 
-// create and position imagecomponents (mImages)
 template<typename T>
-void ImageGridComponent<T>::buildImages()
+int ImageGridComponent<T>::getFirstVisible() const
 {
-	mImages.clear();
-
 	Vector2i gridSize = getGridSize();
-	Vector2f squareSize = getMaxSquareSize();
-	Vector2f padding = getPadding();
+	if(gridSize.x() <= 0 || gridSize.y() <= 0)
+		return 0;
 
-	// attempt to center within our size
-	Vector2f totalSize(gridSize.x() * (squareSize.x() + padding.x()), gridSize.y() * (squareSize.y() + padding.y()));
-	Vector2f offset(mSize.x() - totalSize.x(), mSize.y() - totalSize.y());
-	offset /= 2;
+	int cursorRow = mCursor / gridSize.x();
 
-	for(int y = 0; y < gridSize.y(); y++)
-	{
-		for(int x = 0; x < gridSize.x(); x++)
-		{
-			mImages.push_back(ImageComponent(mWindow));
-			ImageComponent& image = mImages.at(y * gridSize.x() + x);
+	int start = (cursorRow - (gridSize.y() / 2)) * gridSize.x();
 
-			image.setPosition((squareSize.x() + padding.x()) * (x + 0.5f) + offset.x(), (squareSize.y() + padding.y()) * (y + 0.5f) + offset.y());
-			image.setOrigin(0.5f, 0.5f);
-			image.setResize(squareSize.x(), squareSize.y());
-			image.setImage("");
-		}
-	}
+	//if we're at the end put the row as close as we can and no higher
+	if(start + (gridSize.x() * gridSize.y()) >= (int)mEntries.size())
+		start = gridSize.x() * ((int)mEntries.size()/gridSize.x() - gridSize.y() + 1);
+
+	if(start < 0)
+		start = 0;
+
+	return start;
 }
 
+// create an atlas with room for the visible entries and the prefetched rows
 template<typename T>
-void ImageGridComponent<T>::updateImages()
+void ImageGridComponent<T>::buildTiles()
 {
-	if(mImages.empty())
-		buildImages();
+	for(auto it = mTiles.begin(); it != mTiles.end(); it++)
+		releaseTile(*it);
+	mTiles.clear();
+	mEntryTiles.assign(mEntries.size(), -1);
+	mEntryCount = mEntries.size();
+	mVerticesDirty = true;
 
 	Vector2i gridSize = getGridSize();
+	if(gridSize.x() <= 0 || gridSize.y() <= 0)
+	{
+		mAtlas.reset();
+		return;
+	}
 
-	int cursorRow = mCursor / gridSize.x();
+	// the selected entry is drawn a bit larger
+	const Vector2f squareSize = getSquareSize() + getPadding();
+	const size_t visibleCount = (size_t)(gridSize.x() * gridSize.y());
+	mAtlas = TextureAtlas::get((size_t)Math::round(squareSize.x()), (size_t)Math::round(squareSize.y()), visibleCount + 2 * GRID_PREFETCH_ROWS * gridSize.x());
+	mAtlasGeneration = mAtlas->getGeneration();
 
-	int start = (cursorRow - (gridSize.y() / 2)) * gridSize.x();
+	Tile tile = { -1, nullptr, 0, 0 };
+	mTiles.assign(mAtlas->getCellCount(), tile);
+}
 
-	//if we're at the end put the row as close as we can and no higher
-	if(start + (gridSize.x() * gridSize.y()) >= (int)mEntries.size())
-		start = gridSize.x() * ((int)mEntries.size()/gridSize.x() - gridSize.y() + 1);
+template<typename T>
+void ImageGridComponent<T>::releaseTile(Tile& tile)
+{
+	// dropping the last reference also takes it off the loader queue
+	if(tile.entry >= 0 && tile.entry < (int)mEntryTiles.size())
+		mEntryTiles[tile.entry] = -1;
+	tile.entry = -1;
+	tile.loading.reset();
+	tile.width = 0;
+	tile.height = 0;
+}
 
-	if(start < 0)
-		start = 0;
+// hand out the atlas cells to the entries around the cursor, and start loading the ones that are new
+template<typename T>
+void ImageGridComponent<T>::updateTiles()
+{
+	mVerticesDirty = true;
+	if(!mAtlas)
+		return;
+
+	// entries moved around, or the atlas lost its contents
+	if(mEntriesDirty || mEntryCount != mEntries.size() || mAtlas->getGeneration() != mAtlasGeneration)
+	{
+		for(auto it = mTiles.begin(); it != mTiles.end(); it++)
+			releaseTile(*it);
+		mEntryTiles.assign(mEntries.size(), -1);
+		mEntryCount = mEntries.size();
+		mEntriesDirty = false;
+		mAtlasGeneration = mAtlas->getGeneration();
+	}
+
+	const Vector2i gridSize = getGridSize();
+	const int tileCount = (int)mTiles.size();
+	const int visibleStart = getFirstVisible();
+	const int visibleEnd = std::min((int)mEntries.size(), visibleStart + std::min(gridSize.x() * gridSize.y(), tileCount));
+
+	// whole rows on either side, as many as there are cells left for
+	const int margin = ((tileCount - (visibleEnd - visibleStart)) / 2 / gridSize.x()) * gridSize.x();
+	const int windowStart = std::max(0, visibleStart - margin);
+	const int windowEnd = std::min((int)mEntries.size(), visibleEnd + margin);
+
+	std::vector<int> freeTiles;
+	for(int t = tileCount - 1; t >= 0; t--)
+	{
+		Tile& tile = mTiles.at(t);
+		if(tile.entry >= 0 && (tile.entry < windowStart || tile.entry >= windowEnd))
+			releaseTile(tile);
+		if(tile.entry < 0)
+			freeTiles.push_back(t);
+	}
+
+	std::shared_ptr<ResourceManager>& rm = ResourceManager::getInstance();
+	TextureLoader* loader = TextureResource::getTextureLoader();
 
-	unsigned int i = (unsigned int)start;
-	for(unsigned int img = 0; img < mImages.size(); img++)
+	// visible entries first, then the rows below and above
+	for(int pass = 0; pass < 3; pass++)
 	{
-		ImageComponent& image = mImages.at(img);
-		if(i >= (unsigned int)size())
+		const int start = pass == 0 ? visibleStart : (pass == 1 ? visibleEnd : windowStart);
+		const int end = pass == 0 ? visibleEnd : (pass == 1 ? windowEnd : visibleStart);
+		const TextureLoadPriority priority = pass == 0 ? LOAD_PRIORITY_VISIBLE : LOAD_PRIORITY_PREFETCH;
+
+		for(int i = start; i < end; i++)
 		{
-			image.setImage("");
-			continue;
+			if(mEntryTiles.at(i) >= 0)
+			{
+				// it may have been queued as a prefetch, and be on screen now
+				Tile& tile = mTiles.at(mEntryTiles.at(i));
+				if(tile.loading && pass == 0)
+					loader->load(tile.loading, priority);
+				continue;
+			}
+
+			if(freeTiles.empty())
+				break;
+
+			const int t = freeTiles.back();
+			freeTiles.pop_back();
+
+			std::string path = mEntries.at(i).data.imagePath;
+			if(path.empty() || !rm->fileExists(path))
+				path = ":/button.png";
+
+			Tile& tile = mTiles.at(t);
+			tile.entry = i;
+			tile.loading = std::make_shared<TextureData>(false);
+			tile.loading->initFromPath(getCanonicalPath(path));
+			tile.loading->setMaxSize(std::max(mAtlas->getCellWidth(), mAtlas->getCellHeight()));
+			tile.loading->setAllowCompression(false);
+			mEntryTiles.at(i) = t;
+
+			loader->load(tile.loading, priority);
 		}
+	}
+}
 
-		Vector2f squareSize = getSquareSize(mEntries.at(i).data.texture);
-		if(i == (unsigned int)mCursor)
+// copy the images that finished loading into their cells
+template<typename T>
+void ImageGridComponent<T>::uploadTiles()
+{
+	for(size_t t = 0; t < mTiles.size(); t++)
+	{
+		Tile& tile = mTiles.at(t);
+		if(!tile.loading || !tile.loading->isLoaded())
+			continue;
+
+		// anything that doesn't fit (only unscaled SVGs) stays empty
+		if(mAtlas->upload(t, *tile.loading))
 		{
-			image.setColorShift(0xFFFFFFFF);
-			image.setResize(squareSize.x() + getPadding().x() * 0.95f, squareSize.y() + getPadding().y() * 0.95f);
-		}else{
-			image.setColorShift(0xAAAAAABB);
-			image.setResize(squareSize.x(), squareSize.y());
+			tile.width = tile.loading->width();
+			tile.height = tile.loading->height();
+			mVerticesDirty = true;
 		}
+		tile.loading.reset();
+	}
+}
+
+// one quad per visible entry whose image is in the atlas
+template<typename T>
+void ImageGridComponent<T>::buildVertices()
+{
+	mVertices.clear();
+	mColors.clear();
+	mVerticesDirty = false;
+
+	if(!mAtlas)
+		return;
+
+	Vector2i gridSize = getGridSize();
+	Vector2f squareSize = getSquareSize();
+	Vector2f padding = getPadding();
+
+	// attempt to center within our size
+	Vector2f totalSize(gridSize.x() * (squareSize.x() + padding.x()), gridSize.y() * (squareSize.y() + padding.y()));
+	Vector2f offset(mSize.x() - totalSize.x(), mSize.y() - totalSize.y());
+	offset /= 2;
+
+	const int start = getFirstVisible();
+	for(int slot = 0; slot < gridSize.x() * gridSize.y(); slot++)
+	{
+		const int i = start + slot;
+		if(i >= (int)mEntries.size())
+			break;
+
+		if(i >= (int)mEntryTiles.size() || mEntryTiles.at(i) < 0 || mTiles.at(mEntryTiles.at(i)).width == 0)
+			continue;
 
-		image.setImage(mEntries.at(i).data.texture);
-		i++;
+		const Tile& tile = mTiles.at(mEntryTiles.at(i));
+		const int x = slot % gridSize.x();
+		const int y = slot / gridSize.x();
+		const Vector2f center((squareSize.x() + padding.x()) * (x + 0.5f) + offset.x(), (squareSize.y() + padding.y()) * (y + 0.5f) + offset.y());
+
+		// fit the image into its square, keeping the aspect ratio
+		const Vector2f box = (i == mCursor) ? squareSize + padding * 0.95f : squareSize;
+		const float scale = std::min(box.x() / tile.width, box.y() / tile.height);
+		const Vector2f size(tile.width * scale, tile.height * scale);
+
+		const Vector2f topLeft(Math::round(center.x() - size.x() / 2), Math::round(center.y() - size.y() / 2));
+		const Vector2f bottomRight(Math::round(topLeft.x() + size.x()), Math::round(topLeft.y() + size.y()));
+
+		// left, bottom, right, top; the pixels are stored bottom row first
+		const Vector4f tex = mAtlas->getTexCoords(mEntryTiles.at(i), tile.width, tile.height);
+
+		const Renderer::Vertex vertices[6] = {
+			{ Vector2f(topLeft.x(), topLeft.y()), Vector2f(tex.x(), tex.w()) },
+			{ Vector2f(topLeft.x(), bottomRight.y()), Vector2f(tex.x(), tex.y()) },
+			{ Vector2f(bottomRight.x(), topLeft.y()), Vector2f(tex.z(), tex.w()) },
+			{ Vector2f(bottomRight.x(), topLeft.y()), Vector2f(tex.z(), tex.w()) },
+			{ Vector2f(topLeft.x(), bottomRight.y()), Vector2f(tex.x(), tex.y()) },
+			{ Vector2f(bottomRight.x(), bottomRight.y()), Vector2f(tex.z(), tex.y()) }
+		};
+		mVertices.insert(mVertices.end(), vertices, vertices + 6);
+
+		mColors.resize(mVertices.size() * 4);
+		Renderer::buildGLColorArray(&mColors[(mVertices.size() - 6) * 4], i == mCursor ? 0xFFFFFFFF : 0xAAAAAABB, 6);
 	}
 }
 
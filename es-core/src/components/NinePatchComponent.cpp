@@ -47,7 +47,7 @@ void NinePatchComponent::buildVertices()
 		return;
 	}
 
-	mVertices = new Vertex[6 * 9];
+	mVertices = new Renderer::Vertex[6 * 9];
 	mColors = new GLubyte[6 * 9 * 4];
 	updateColors();
 
@@ -150,26 +150,7 @@ void NinePatchComponent::render(const Transform4x4f& parentTrans)
 
 		mTexture->bind();
 
-		glEnable(GL_TEXTURE_2D);
-		glEnable(GL_BLEND);
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-		glEnableClientState(GL_VERTEX_ARRAY);
-		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-		glEnableClientState(GL_COLOR_ARRAY);
-
-		glVertexPointer(2, GL_FLOAT, sizeof(Vertex), &mVertices[0].pos);
-		glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), &mVertices[0].tex);
-		glColorPointer(4, GL_UNSIGNED_BYTE, 0, mColors);
-
-		glDrawArrays(GL_TRIANGLES, 0, 6 * 9);
-
-		glDisableClientState(GL_VERTEX_ARRAY);
-		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-		glDisableClientState(GL_COLOR_ARRAY);
-
-		glDisable(GL_TEXTURE_2D);
-		glDisable(GL_BLEND);
+		Renderer::drawTriangles(mVertices, mColors, 6 * 9);
 	}
 
 	renderChildren(trans);
@@ -3,8 +3,7 @@
 #define ES_CORE_COMPONENTS_NINE_PATCH_COMPONENT_H
 
 #include "GuiComponent.h"
-#include "platform.h"
-#include GLHEADER
+#include "Renderer.h"
 
 class TextureResource;
 
@@ -43,13 +42,7 @@ private:
 	void buildVertices();
 	void updateColors();
 
-	struct Vertex
-	{
-		Vector2f pos;
-		Vector2f tex;
-	};
-
-	Vertex* mVertices;
+	Renderer::Vertex* mVertices;
 	GLubyte* mColors;
 
 	std::string mPath;
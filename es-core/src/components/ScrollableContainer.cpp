@@ -58,6 +58,8 @@ void ScrollableContainer::setScrollPos(const Vector2f& pos)
 
 void ScrollableContainer::update(int deltaTime)
 {
+	const Vector2f prevScrollPos = mScrollPos;
+
 	if(mAutoScrollSpeed != 0)
 	{
 		mAutoScrollAccumulator += deltaTime;
@@ -100,6 +102,9 @@ void ScrollableContainer::update(int deltaTime)
 			reset();
 	}
 
+	if(mScrollPos != prevScrollPos)
+		invalidate();
+
 	GuiComponent::update(deltaTime);
 }
 
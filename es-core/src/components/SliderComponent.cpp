@@ -53,6 +53,7 @@ void SliderComponent::update(int deltaTime)
 		{
 			setValue(mValue + mMoveRate);
 			mMoveAccumulator -= MOVE_REPEAT_RATE;
+			invalidate();
 		}
 	}
 	
@@ -1,6 +1,5 @@
 #include "components/TextComponent.h"
 
-#include "utils/StringUtil.h"
 #include "Log.h"
 #include "Renderer.h"
 #include "Settings.h"
@@ -189,21 +188,9 @@ void TextComponent::onTextChanged()
 		addAbbrev = newline != std::string::npos;
 	}
 
-	Vector2f size = f->sizeText(text);
-	if(!isMultiline && mSize.x() && text.size() && (size.x() > mSize.x() || addAbbrev))
+	if(!isMultiline && mSize.x() && text.size() && (addAbbrev || f->sizeText(text).x() > mSize.x()))
 	{
-		// abbreviate text
-		const std::string abbrev = "...";
-		Vector2f abbrevSize = f->sizeText(abbrev);
-
-		while(text.size() && size.x() + abbrevSize.x() > mSize.x())
-		{
-			size_t newSize = Utils::String::prevCursor(text, text.size());
-			text.erase(newSize, text.size() - newSize);
-			size = f->sizeText(text);
-		}
-
-		text.append(abbrev);
+		text = f->abbreviateText(text, mSize.x());
 
 		mTextCache = std::shared_ptr<TextCache>(f->buildTextCache(text, Vector2f(0, 0), (mColor >> 8 << 8) | mOpacity, mSize.x(), mHorizontalAlignment, mLineSpacing));
 	}else{
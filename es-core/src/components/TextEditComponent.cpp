@@ -186,6 +186,7 @@ void TextEditComponent::updateCursorRepeat(int deltaTime)
 	{
 		moveCursor(mCursorRepeatDir);
 		mCursorRepeatTimer -= CURSOR_REPEAT_SPEED;
+		invalidate();
 	}
 }
 
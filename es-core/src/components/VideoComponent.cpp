@@ -285,6 +285,10 @@ void VideoComponent::update(int deltaTime)
 {
 	manageState();
 
+	// redraw for every new frame of a playing video and during its fade
+	if((mIsPlaying && hasNewFrame()) || mStartDelayed || mFadeIn < 1.0f)
+		invalidate();
+
 	// If the video start is delayed and there is less than the fade time then set the image fade
 	// accordingly
 	if (mStartDelayed)
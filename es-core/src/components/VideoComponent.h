@@ -88,6 +88,9 @@ private:
 	// Manage the playing state of the component
 	void manageState();
 
+	// Whether the playing video has a frame that hasn't been shown yet
+	virtual bool hasNewFrame() { return true; }
+
 protected:
 	unsigned						mVideoWidth;
 	unsigned						mVideoHeight;
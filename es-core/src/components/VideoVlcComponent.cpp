@@ -1,11 +1,15 @@
 #include "components/VideoVlcComponent.h"
 
-#include "resources/TextureResource.h"
+#include "resources/VideoInfoCache.h"
 #include "PowerSaver.h"
-#include "Renderer.h"
 #include "Settings.h"
 #include <vlc/vlc.h>
 #include <SDL_mutex.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 #ifdef WIN32
 #include <codecvt>
@@ -13,19 +17,37 @@
 
 libvlc_instance_t* VideoVlcComponent::mVLC = NULL;
 
+static std::atomic<unsigned int> sUploadedFrames(0);
+static std::atomic<unsigned int> sDuplicatedFrames(0);
+static std::atomic<unsigned int> sDroppedFrames(0);
+
 // VLC prepares to render a video frame.
 static void *lock(void *data, void **p_pixels) {
 	struct VideoContext *c = (struct VideoContext *)data;
+
+	// any buffer that is neither waiting for nor being uploaded, with three of them there always is one
 	SDL_LockMutex(c->mutex);
-	SDL_LockSurface(c->surface);
-	*p_pixels = c->surface->pixels;
+	int index = 0;
+	while(index == c->ready || index == c->uploading)
+		index++;
+	c->decoding = index;
+	SDL_UnlockMutex(c->mutex);
+
+	*p_pixels = c->buffers[index];
 	return NULL; // Picture identifier, not needed here.
 }
 
 // VLC just rendered a video frame.
 static void unlock(void *data, void* /*id*/, void *const* /*p_pixels*/) {
 	struct VideoContext *c = (struct VideoContext *)data;
-	SDL_UnlockSurface(c->surface);
+	SDL_LockMutex(c->mutex);
+
+	// the previous frame was never shown, the render thread is falling behind the video
+	if(c->ready != -1)
+		sDroppedFrames++;
+
+	c->ready = c->decoding;
+	c->decoding = -1;
 	SDL_UnlockMutex(c->mutex);
 }
 
@@ -34,15 +56,163 @@ static void display(void* /*data*/, void* /*id*/) {
 	//Data to be displayed
 }
 
+// libvlc_media_parse() reads the file and can block for a long time on slow storage, so media is
+// opened on a background thread instead; the video dimensions come from the VideoInfoCache when possible
+struct VideoMediaRequest
+{
+	libvlc_instance_t* vlc;
+	std::string path;
+	libvlc_media_t* media;
+	unsigned int width;
+	unsigned int height;
+	bool done;
+	bool cancelled;
+};
+
+class VideoMediaParser
+{
+public:
+	static VideoMediaParser* getInstance()
+	{
+		static VideoMediaParser* sInstance = new VideoMediaParser();
+		return sInstance;
+	}
+
+	std::shared_ptr<VideoMediaRequest> parse(libvlc_instance_t* vlc, const std::string& path)
+	{
+		std::shared_ptr<VideoMediaRequest> request = std::make_shared<VideoMediaRequest>();
+		request->vlc = vlc;
+		request->path = path;
+		request->media = NULL;
+		request->width = 0;
+		request->height = 0;
+		request->done = false;
+		request->cancelled = false;
+
+		std::unique_lock<std::mutex> lock(mMutex);
+		if (!mThread.joinable())
+			mThread = std::thread(&VideoMediaParser::threadProc, this);
+		mQueue.push_back(request);
+		mEvent.notify_one();
+		return request;
+	}
+
+	// Once this returns true the media belongs to the caller
+	bool isDone(const std::shared_ptr<VideoMediaRequest>& request)
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		return request->done;
+	}
+
+	// Drops a request whatever state it is in, releasing its media if that was already opened
+	void cancel(const std::shared_ptr<VideoMediaRequest>& request)
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		for (auto it = mQueue.begin(); it != mQueue.end(); it++)
+		{
+			if (*it == request)
+			{
+				mQueue.erase(it);
+				break;
+			}
+		}
+
+		if (request->done && request->media)
+			libvlc_media_release(request->media);
+		request->media = NULL;
+		request->cancelled = true;
+	}
+
+	// Lets the thread finish the media it is opening and joins it, queued requests are answered without media.
+	// A later parse() starts a new thread.
+	void stop()
+	{
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mExit = true;
+		}
+		mEvent.notify_one();
+		if (mThread.joinable())
+			mThread.join();
+
+		std::unique_lock<std::mutex> lock(mMutex);
+		for (auto it = mQueue.begin(); it != mQueue.end(); it++)
+			(*it)->done = true;
+		mQueue.clear();
+		mExit = false;
+	}
+
+private:
+	VideoMediaParser() : mExit(false) {}
+
+	void threadProc()
+	{
+		while (true)
+		{
+			std::shared_ptr<VideoMediaRequest> request;
+			{
+				std::unique_lock<std::mutex> lock(mMutex);
+				mEvent.wait(lock, [this] { return mExit || !mQueue.empty(); });
+				if (mExit)
+					return;
+				request = mQueue.front();
+				mQueue.pop_front();
+			}
+
+			unsigned int width = 0;
+			unsigned int height = 0;
+			libvlc_media_t* media = libvlc_media_new_path(request->vlc, request->path.c_str());
+			if (media && !VideoInfoCache::getInstance()->get(request->path, width, height))
+			{
+				// Get the media metadata so we can find the aspect ratio
+				libvlc_media_parse(media);
+				libvlc_media_track_t** tracks;
+				unsigned track_count = libvlc_media_tracks_get(media, &tracks);
+				for (unsigned track = 0; track < track_count; ++track)
+				{
+					if (tracks[track]->i_type == libvlc_track_video)
+					{
+						width = tracks[track]->video->i_width;
+						height = tracks[track]->video->i_height;
+						break;
+					}
+				}
+				libvlc_media_tracks_release(tracks, track_count);
+
+				if ((width > 0) && (height > 0))
+					VideoInfoCache::getInstance()->put(request->path, width, height);
+			}
+
+			std::unique_lock<std::mutex> lock(mMutex);
+			if (request->cancelled)
+			{
+				if (media)
+					libvlc_media_release(media);
+				continue;
+			}
+
+			request->media = media;
+			request->width = width;
+			request->height = height;
+			request->done = true;
+		}
+	}
+
+	std::thread mThread;
+	bool mExit;
+	std::mutex mMutex;
+	std::condition_variable mEvent;
+	std::deque<std::shared_ptr<VideoMediaRequest> > mQueue;
+};
+
 VideoVlcComponent::VideoVlcComponent(Window* window, std::string subtitles) :
 	VideoComponent(window),
-	mMediaPlayer(nullptr)
+	mMedia(nullptr),
+	mMediaPlayer(nullptr),
+	mFrameTexture(0)
 {
 	memset(&mContext, 0, sizeof(mContext));
 
-	// Get an empty texture for rendering the video
-	mTexture = TextureResource::get("");
-
 	// Make sure VLC has been initialised
 	setupVLC(subtitles);
 }
@@ -70,9 +240,6 @@ void VideoVlcComponent::setMaxSize(float width, float height)
 
 void VideoVlcComponent::resize()
 {
-	if(!mTexture)
-		return;
-
 	const Vector2f textureSize((float)mVideoWidth, (float)mVideoHeight);
 
 	if(textureSize == Vector2f::Zero())
@@ -122,9 +289,6 @@ void VideoVlcComponent::resize()
 			}
 		}
 
-	// mSize.y() should already be rounded
-	mTexture->rasterizeAt((size_t)Math::round(mSize.x()), (size_t)Math::round(mSize.y()));
-
 	onSizeChanged();
 }
 
@@ -138,7 +302,8 @@ void VideoVlcComponent::render(const Transform4x4f& parentTrans)
 
 	Renderer::setMatrix(trans);
 
-	if (mIsPlaying && mContext.valid)
+	// until the first frame arrives there is nothing to show but the snapshot
+	if (mIsPlaying && mContext.valid && (uploadFrame() || mFrameTexture != 0))
 	{
 		float tex_offs_x = 0.0f;
 		float tex_offs_y = 0.0f;
@@ -150,13 +315,8 @@ void VideoVlcComponent::render(const Transform4x4f& parentTrans)
 		x2 = mSize.x();
 		y2 = mSize.y();
 
-		// Define a structure to contain the data for each vertex
-		struct Vertex
-		{
-			Vector2f pos;
-			Vector2f tex;
-			Vector4f colour;
-		} vertices[6];
+		Renderer::Vertex vertices[6];
+		GLubyte colors[6 * 4];
 
 		// We need two triangles to cover the rectangular area
 		vertices[0].pos[0] = x; 			vertices[0].pos[1] = y;
@@ -179,45 +339,85 @@ void VideoVlcComponent::render(const Transform4x4f& parentTrans)
 		// Colours - use this to fade the video in and out
 		for (int i = 0; i < (4 * 6); ++i) {
 			if ((i%4) < 3)
-				vertices[i / 4].colour[i % 4] = mFadeIn;
+				colors[i] = (GLubyte)(mFadeIn * 255.0f);
 			else
-				vertices[i / 4].colour[i % 4] = 1.0f;
+				colors[i] = 255;
 		}
 
-		glEnable(GL_TEXTURE_2D);
+		Renderer::bindTexture(mFrameTexture);
+
+		// Render it, the video frame is opaque so it simply replaces what is behind it
+		Renderer::drawTriangles(vertices, colors, 6, true, GL_ONE, GL_ZERO);
+	} else {
+		VideoComponent::renderSnapshot(parentTrans);
+	}
+}
+
+bool VideoVlcComponent::hasNewFrame()
+{
+	if (!mContext.valid)
+		return false;
 
-		// Build a texture for the video frame
-		mTexture->initFromPixels((unsigned char*)mContext.surface->pixels, mContext.surface->w, mContext.surface->h);
-		mTexture->bind();
+	SDL_LockMutex(mContext.mutex);
+	bool ready = mContext.ready != -1;
+	SDL_UnlockMutex(mContext.mutex);
+	return ready;
+}
 
-		// Render it
-		glEnableClientState(GL_COLOR_ARRAY);
-		glEnableClientState(GL_VERTEX_ARRAY);
-		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+bool VideoVlcComponent::uploadFrame()
+{
+	// take the newest frame, VLC won't touch it until a newer one has been taken
+	SDL_LockMutex(mContext.mutex);
+	int frame = mContext.ready;
+	if (frame != -1)
+	{
+		mContext.uploading = frame;
+		mContext.ready = -1;
+	}
+	SDL_UnlockMutex(mContext.mutex);
 
-		glColorPointer(4, GL_FLOAT, sizeof(Vertex), &vertices[0].colour);
-		glVertexPointer(2, GL_FLOAT, sizeof(Vertex), &vertices[0].pos);
-		glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), &vertices[0].tex);
+	if (frame == -1)
+	{
+		// nothing new since the last render, draw the same frame again
+		if (mFrameTexture != 0)
+			sDuplicatedFrames++;
+		return false;
+	}
 
-		glDrawArrays(GL_TRIANGLES, 0, 6);
+	// the texture storage is allocated once, every frame after that only replaces its contents
+	if (mFrameTexture == 0)
+	{
+		glGenTextures(1, &mFrameTexture);
+		Renderer::bindTexture(mFrameTexture);
 
-		glDisableClientState(GL_VERTEX_ARRAY);
-		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-		glDisableClientState(GL_COLOR_ARRAY);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-		glDisable(GL_TEXTURE_2D);
-	} else {
-		VideoComponent::renderSnapshot(parentTrans);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, (GLsizei)mVideoWidth, (GLsizei)mVideoHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
 	}
+	else
+	{
+		Renderer::bindTexture(mFrameTexture);
+	}
+
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, (GLsizei)mVideoWidth, (GLsizei)mVideoHeight, GL_RGBA, GL_UNSIGNED_BYTE, mContext.buffers[frame]);
+	sUploadedFrames++;
+	return true;
 }
 
 void VideoVlcComponent::setupContext()
 {
 	if (!mContext.valid)
 	{
-		// Create an RGBA surface to render the video into
-		mContext.surface = SDL_CreateRGBSurface(SDL_SWSURFACE, (int)mVideoWidth, (int)mVideoHeight, 32, 0xff000000, 0x00ff0000, 0x0000ff00, 0x000000ff);
+		// Create the RGBA buffers to render the video into
+		for (int i = 0; i < VIDEO_FRAME_BUFFERS; ++i)
+			mContext.buffers[i] = new unsigned char[mVideoWidth * mVideoHeight * 4];
 		mContext.mutex = SDL_CreateMutex();
+		mContext.decoding = -1;
+		mContext.ready = -1;
+		mContext.uploading = -1;
 		mContext.valid = true;
 		resize();
 	}
@@ -227,10 +427,35 @@ void VideoVlcComponent::freeContext()
 {
 	if (mContext.valid)
 	{
-		SDL_FreeSurface(mContext.surface);
+		for (int i = 0; i < VIDEO_FRAME_BUFFERS; ++i)
+		{
+			delete[] mContext.buffers[i];
+			mContext.buffers[i] = NULL;
+		}
 		SDL_DestroyMutex(mContext.mutex);
 		mContext.valid = false;
 	}
+
+	if (mFrameTexture != 0)
+	{
+		Renderer::deleteTexture(mFrameTexture);
+		mFrameTexture = 0;
+	}
+}
+
+unsigned int VideoVlcComponent::getUploadedFrameCount()
+{
+	return sUploadedFrames;
+}
+
+unsigned int VideoVlcComponent::getDuplicatedFrameCount()
+{
+	return sDuplicatedFrames;
+}
+
+unsigned int VideoVlcComponent::getDroppedFrameCount()
+{
+	return sDroppedFrames;
 }
 
 void VideoVlcComponent::setupVLC(std::string subtitles)
@@ -257,6 +482,11 @@ void VideoVlcComponent::setupVLC(std::string subtitles)
 	}
 }
 
+void VideoVlcComponent::stopMediaParser()
+{
+	VideoMediaParser::getInstance()->stop();
+}
+
 void VideoVlcComponent::handleLooping()
 {
 	if (mIsPlaying && mMediaPlayer)
@@ -293,75 +523,91 @@ void VideoVlcComponent::startVideo()
 			// Set the video that we are going to be playing so we don't attempt to restart it
 			mPlayingVideoPath = mVideoPath;
 
-			// Open the media
-			mMedia = libvlc_media_new_path(mVLC, path.c_str());
-			if (mMedia)
-			{
-				unsigned track_count;
-				// Get the media metadata so we can find the aspect ratio
-				libvlc_media_parse(mMedia);
-				libvlc_media_track_t** tracks;
-				track_count = libvlc_media_tracks_get(mMedia, &tracks);
-				for (unsigned track = 0; track < track_count; ++track)
-				{
-					if (tracks[track]->i_type == libvlc_track_video)
-					{
-						mVideoWidth = tracks[track]->video->i_width;
-						mVideoHeight = tracks[track]->video->i_height;
-						break;
-					}
-				}
-				libvlc_media_tracks_release(tracks, track_count);
+			// Open the media in the background, update() starts the player once it is ready
+			mMediaRequest = VideoMediaParser::getInstance()->parse(mVLC, path);
 
-				// Make sure we found a valid video track
-				if ((mVideoWidth > 0) && (mVideoHeight > 0))
-				{
-#ifndef _RPI_
-					if (mScreensaverMode)
-					{
-						if(!Settings::getInstance()->getBool("CaptionsCompatibility")) {
-
-							Vector2f resizeScale((Renderer::getScreenWidth() / (float)mVideoWidth), (Renderer::getScreenHeight() / (float)mVideoHeight));
-
-							if(resizeScale.x() < resizeScale.y())
-							{
-								mVideoWidth = (unsigned int) (mVideoWidth * resizeScale.x());
-								mVideoHeight = (unsigned int) (mVideoHeight * resizeScale.x());
-							}else{
-								mVideoWidth = (unsigned int) (mVideoWidth * resizeScale.y());
-								mVideoHeight = (unsigned int) (mVideoHeight * resizeScale.y());
-							}
-						}
-					}
-#endif
-					PowerSaver::pause();
-					setupContext();
+			// Update the playing state, the snapshot stays up until the first frame arrives
+			mIsPlaying = true;
+		}
+	}
+}
 
-					// Setup the media player
-					mMediaPlayer = libvlc_media_player_new_from_media(mMedia);
+void VideoVlcComponent::update(int deltaTime)
+{
+	VideoComponent::update(deltaTime);
 
-					if (!Settings::getInstance()->getBool("VideoAudio"))
-					{
-						libvlc_audio_set_mute(mMediaPlayer, 1);
-					}
+	if (mMediaRequest && VideoMediaParser::getInstance()->isDone(mMediaRequest))
+	{
+		std::shared_ptr<VideoMediaRequest> request = mMediaRequest;
+		mMediaRequest.reset();
+		startPlayer(*request);
+	}
+}
 
-					libvlc_media_player_play(mMediaPlayer);
-					libvlc_video_set_callbacks(mMediaPlayer, lock, unlock, display, (void*)&mContext);
-					libvlc_video_set_format(mMediaPlayer, "RGBA", (int)mVideoWidth, (int)mVideoHeight, (int)mVideoWidth * 4);
+void VideoVlcComponent::startPlayer(const VideoMediaRequest& request)
+{
+	mMedia = request.media;
+	mVideoWidth = request.width;
+	mVideoHeight = request.height;
 
-					// Update the playing state
-					mIsPlaying = true;
-					mFadeIn = 0.0f;
-				}
+	if (!mMedia)
+		return;
+
+	// Make sure we found a valid video track
+	if ((mVideoWidth == 0) || (mVideoHeight == 0))
+	{
+		libvlc_media_release(mMedia);
+		mMedia = NULL;
+		return;
+	}
+
+#ifndef _RPI_
+	if (mScreensaverMode)
+	{
+		if(!Settings::getInstance()->getBool("CaptionsCompatibility")) {
+
+			Vector2f resizeScale((Renderer::getScreenWidth() / (float)mVideoWidth), (Renderer::getScreenHeight() / (float)mVideoHeight));
+
+			if(resizeScale.x() < resizeScale.y())
+			{
+				mVideoWidth = (unsigned int) (mVideoWidth * resizeScale.x());
+				mVideoHeight = (unsigned int) (mVideoHeight * resizeScale.x());
+			}else{
+				mVideoWidth = (unsigned int) (mVideoWidth * resizeScale.y());
+				mVideoHeight = (unsigned int) (mVideoHeight * resizeScale.y());
 			}
 		}
 	}
+#endif
+	PowerSaver::pause();
+	setupContext();
+
+	// Setup the media player
+	mMediaPlayer = libvlc_media_player_new_from_media(mMedia);
+
+	if (!Settings::getInstance()->getBool("VideoAudio"))
+	{
+		libvlc_audio_set_mute(mMediaPlayer, 1);
+	}
+
+	// the callbacks must be in place before playback starts, or VLC opens a window of its own
+	libvlc_video_set_callbacks(mMediaPlayer, lock, unlock, display, (void*)&mContext);
+	libvlc_video_set_format(mMediaPlayer, "RGBA", (int)mVideoWidth, (int)mVideoHeight, (int)mVideoWidth * 4);
+	libvlc_media_player_play(mMediaPlayer);
+
+	mFadeIn = 0.0f;
 }
 
 void VideoVlcComponent::stopVideo()
 {
 	mIsPlaying = false;
 	mStartDelayed = false;
+	// Drop the media that is still being opened, the cursor has moved on
+	if (mMediaRequest)
+	{
+		VideoMediaParser::getInstance()->cancel(mMediaRequest);
+		mMediaRequest.reset();
+	}
 	// Release the media player so it stops calling back to us
 	if (mMediaPlayer)
 	{
@@ -369,6 +615,7 @@ void VideoVlcComponent::stopVideo()
 		libvlc_media_player_release(mMediaPlayer);
 		libvlc_media_release(mMedia);
 		mMediaPlayer = NULL;
+		mMedia = NULL;
 		freeContext();
 		PowerSaver::resume();
 	}
@@ -2,17 +2,25 @@
 #ifndef ES_CORE_COMPONENTS_VIDEO_VLC_COMPONENT_H
 #define ES_CORE_COMPONENTS_VIDEO_VLC_COMPONENT_H
 
+#include "Renderer.h"
 #include "VideoComponent.h"
 
 struct SDL_mutex;
-struct SDL_Surface;
+struct VideoMediaRequest;
 struct libvlc_instance_t;
 struct libvlc_media_t;
 struct libvlc_media_player_t;
 
+#define VIDEO_FRAME_BUFFERS 3
+
+// VLC decodes straight into one of the frame buffers while the newest finished frame waits
+// for the render thread and the one before it may still be uploading; the indices are guarded by mutex
 struct VideoContext {
-	SDL_Surface*		surface;
+	unsigned char*		buffers[VIDEO_FRAME_BUFFERS];
 	SDL_mutex*			mutex;
+	int					decoding;	// buffer VLC is writing, -1 if none
+	int					ready;		// newest finished frame that wasn't uploaded yet, -1 if none
+	int					uploading;	// buffer last taken by the render thread, -1 if none
 	bool				valid;
 };
 
@@ -29,12 +37,19 @@ class VideoVlcComponent : public VideoComponent
 
 public:
 	static void setupVLC(std::string subtitles);
+	// Joins the thread that opens videos in the background, call it before exiting.
+	static void stopMediaParser();
 
 	VideoVlcComponent(Window* window, std::string subtitles);
 	virtual ~VideoVlcComponent();
 
 	void render(const Transform4x4f& parentTrans) override;
+	void update(int deltaTime) override;
 
+	// frame statistics of all VLC videos, for the framerate overlay
+	static unsigned int getUploadedFrameCount();
+	static unsigned int getDuplicatedFrameCount();
+	static unsigned int getDroppedFrameCount();
 
 	// Resize the video to fit this size. If one axis is zero, scale that axis to maintain aspect ratio.
 	// If both are non-zero, potentially break the aspect ratio.  If both are zero, no resizing.
@@ -53,20 +68,27 @@ private:
 	void resize();
 	// Start the video Immediately
 	virtual void startVideo();
+	// Create the media player once the media has been opened
+	void startPlayer(const VideoMediaRequest& request);
 	// Stop the video
 	virtual void stopVideo();
 	// Handle looping the video. Must be called periodically
 	virtual void handleLooping();
 
+	virtual bool hasNewFrame() override;
+
 	void setupContext();
 	void freeContext();
+	// Upload the newest decoded frame to mFrameTexture, returns false if there was none
+	bool uploadFrame();
 
 private:
 	static libvlc_instance_t*		mVLC;
 	libvlc_media_t*					mMedia;
 	libvlc_media_player_t*			mMediaPlayer;
+	std::shared_ptr<VideoMediaRequest> mMediaRequest;
 	VideoContext					mContext;
-	std::shared_ptr<TextureResource> mTexture;
+	GLuint							mFrameTexture;
 };
 
 #endif // ES_CORE_COMPONENTS_VIDEO_VLC_COMPONENT_H
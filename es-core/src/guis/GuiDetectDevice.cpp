@@ -115,6 +115,7 @@ void GuiDetectDevice::update(int deltaTime)
 			const float t = (float)mHoldTime / HOLD_TIME;
 			unsigned int c = (unsigned char)(t * 255);
 			mDeviceHeld->setColor((c << 24) | (c << 16) | (c << 8) | 0xFF);
+			invalidate();
 			if(mHoldTime <= 0)
 			{
 				// picked one!
@@ -338,6 +338,7 @@ void GuiInputConfig::update(int deltaTime)
 				ss << "HOLD FOR " << HOLD_TO_SKIP_MS/1000 - curSec << "S TO SKIP";
 				text->setText(ss.str());
 				text->setColor(0x777777FF);
+				invalidate();
 			}
 		}
 	}
@@ -4,6 +4,9 @@
 #include <SDL_events.h>
 #ifdef WIN32
 #include <codecvt>
+#include <io.h>
+#else
+#include <unistd.h>
 #endif
 #include <fcntl.h>
 
@@ -100,3 +103,15 @@ void touch(const std::string& filename)
 		close(fd);
 #endif
 }
+
+bool syncFile(FILE* file)
+{
+	if(fflush(file) != 0)
+		return false;
+
+#ifdef WIN32
+	return _commit(_fileno(file)) == 0;
+#else
+	return fsync(fileno(file)) == 0;
+#endif
+}
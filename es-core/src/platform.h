@@ -2,6 +2,7 @@
 #ifndef ES_CORE_PLATFORM_H
 #define ES_CORE_PLATFORM_H
 
+#include <stdio.h>
 #include <string>
 
 //the Makefile defines one of these:
@@ -29,5 +30,6 @@ int runRestartCommand(); // restart the system (returns 0 if successful)
 int runSystemCommand(const std::string& cmd_utf8); // run a utf-8 encoded in the shell (requires wstring conversion on Windows)
 int quitES(const std::string& filename);
 void touch(const std::string& filename);
+bool syncFile(FILE* file); // flush a file all the way to the disk, so a following rename can't leave it empty after a power loss (returns true if successful)
 
 #endif // ES_CORE_PLATFORM_H
@@ -2,8 +2,49 @@
 
 #include "utils/StringUtil.h"
 #include "Log.h"
+#include "platform.h"
 #include "Renderer.h"
 #include "Util.h"
+#include <boost/filesystem/operations.hpp>
+#include <stdint.h>
+#include <string.h>
+#include <fstream>
+
+// bump this whenever the layout below changes, old entries are then simply missed
+#define GLYPH_CACHE_MAGIC   "ESGC"
+#define GLYPH_CACHE_VERSION 1
+
+// every font rasterizes these up front, so they are what the glyph cache holds
+#define GLYPH_CACHE_FIRST 32
+#define GLYPH_CACHE_LAST  127
+
+// cache entry layout (native endianness), named after a hash of the font file, the pixel size and the glyph range:
+//   header, one entry per glyph, then the used rows of the first texture's alpha bitmap
+struct Font::GlyphCacheHeader
+{
+	char magic[4];
+	uint32_t version;
+	int32_t textureWidth;
+	int32_t textureHeight;
+	int32_t usedHeight;
+	int32_t writePosX;
+	int32_t writePosY;
+	int32_t rowHeight;
+	uint32_t glyphCount;
+};
+
+struct Font::GlyphCacheEntry
+{
+	uint32_t id;
+	int32_t x;
+	int32_t y;
+	int32_t width;
+	int32_t height;
+	float advanceX;
+	float advanceY;
+	float bearingX;
+	float bearingY;
+};
 
 FT_Library Font::sLibrary = NULL;
 
@@ -68,7 +109,7 @@ size_t Font::getTotalMemUsage()
 	return total;
 }
 
-Font::Font(int size, const std::string& path) : mSize(size), mPath(path)
+Font::Font(int size, const std::string& path) : mSize(size), mPath(path), mGlyphCacheValid(false)
 {
 	assert(mSize > 0);
 	
@@ -77,9 +118,19 @@ Font::Font(int size, const std::string& path) : mSize(size), mPath(path)
 	if(!sLibrary)
 		initLibrary();
 
-	// always initialize ASCII characters
-	for(unsigned int i = 32; i < 128; i++)
-		getGlyph(i);
+	// always initialize ASCII characters, from the glyph cache if possible
+	if(!loadGlyphCache())
+	{
+		FontTexture texture;
+		mGlyphCacheBitmap.assign(texture.textureSize.x() * texture.textureSize.y(), 0);
+
+		for(unsigned int i = GLYPH_CACHE_FIRST; i <= GLYPH_CACHE_LAST; i++)
+			getGlyph(i);
+
+		saveGlyphCache();
+		mGlyphCacheBitmap.clear();
+		mGlyphCacheBitmap.shrink_to_fit();
+	}
 
 	clearFaceCache();
 }
@@ -173,7 +224,7 @@ void Font::FontTexture::initTexture()
 	assert(textureId == 0);
 
 	glGenTextures(1, &textureId);
-	glBindTexture(GL_TEXTURE_2D, textureId);
+	Renderer::bindTexture(textureId);
 
 	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -191,7 +242,7 @@ void Font::FontTexture::deinitTexture()
 {
 	if(textureId != 0)
 	{
-		glDeleteTextures(1, &textureId);
+		Renderer::deleteTexture(textureId);
 		textureId = 0;
 	}
 }
@@ -355,9 +406,15 @@ Font::Glyph* Font::getGlyph(unsigned int id)
 	glyph.bearing = Vector2f((float)g->metrics.horiBearingX / 64.0f, (float)g->metrics.horiBearingY / 64.0f);
 
 	// upload glyph bitmap to texture
-	glBindTexture(GL_TEXTURE_2D, tex->textureId);
+	Renderer::bindTexture(tex->textureId);
 	glTexSubImage2D(GL_TEXTURE_2D, 0, cursor.x(), cursor.y(), glyphSize.x(), glyphSize.y(), GL_ALPHA, GL_UNSIGNED_BYTE, g->bitmap.buffer);
-	glBindTexture(GL_TEXTURE_2D, 0);
+
+	// keep a copy for the glyph cache, textures can't be read back on GLES
+	if(!mGlyphCacheBitmap.empty() && tex == &mTextures.front())
+	{
+		for(int y = 0; y < glyphSize.y(); y++)
+			memcpy(&mGlyphCacheBitmap[(cursor.y() + y) * tex->textureSize.x() + cursor.x()], g->bitmap.buffer + y * glyphSize.x(), glyphSize.x());
+	}
 
 	// update max glyph height
 	if(glyphSize.y() > mMaxGlyphHeight)
@@ -367,6 +424,25 @@ Font::Glyph* Font::getGlyph(unsigned int id)
 	return &glyph;
 }
 
+float Font::getAdvance(unsigned int id)
+{
+	if(id < mAdvances.size() && mAdvances[id] >= 0.0f)
+		return mAdvances[id];
+
+	Glyph* glyph = getGlyph(id);
+	const float advance = glyph ? glyph->advance.x() : 0.0f;
+
+	// everything up to CJK is kept flat, anything above is rare enough to go through the glyph map
+	if(id < 0x3000)
+	{
+		if(id >= mAdvances.size())
+			mAdvances.resize(id + 1, -1.0f);
+		mAdvances[id] = advance;
+	}
+
+	return advance;
+}
+
 // completely recreate the texture data for all textures based on mGlyphs information
 void Font::rebuildTextures()
 {
@@ -376,9 +452,15 @@ void Font::rebuildTextures()
 		it->initTexture();
 	}
 
+	// the cached glyphs come back with a single upload, only the others need FreeType
+	const bool restored = restoreGlyphCache();
+
 	// reupload the texture data
 	for(auto it = mGlyphMap.cbegin(); it != mGlyphMap.cend(); it++)
 	{
+		if(restored && it->first >= GLYPH_CACHE_FIRST && it->first <= GLYPH_CACHE_LAST)
+			continue;
+
 		FT_Face face = getFaceForChar(it->first);
 		FT_GlyphSlot glyphSlot = face->glyph;
 
@@ -392,11 +474,163 @@ void Font::rebuildTextures()
 		Vector2i glyphSize((int)(it->second.texSize.x() * tex->textureSize.x()), (int)(it->second.texSize.y() * tex->textureSize.y()));
 		
 		// upload to texture
-		glBindTexture(GL_TEXTURE_2D, tex->textureId);
+		Renderer::bindTexture(tex->textureId);
 		glTexSubImage2D(GL_TEXTURE_2D, 0, cursor.x(), cursor.y(), glyphSize.x(), glyphSize.y(), GL_ALPHA, GL_UNSIGNED_BYTE, glyphSlot->bitmap.buffer);
 	}
+}
+
+bool Font::readGlyphCache(GlyphCacheHeader& header, std::vector<GlyphCacheEntry>& entries, std::vector<unsigned char>& bitmap)
+{
+	std::ifstream file(mGlyphCachePath.c_str(), std::ios::in | std::ios::binary);
+	if(!file.is_open())
+		return false;
+
+	FontTexture texture;
+	file.read((char*)&header, sizeof(header));
+	if(!file.good() || memcmp(header.magic, GLYPH_CACHE_MAGIC, 4) != 0 || header.version != GLYPH_CACHE_VERSION ||
+		header.textureWidth != texture.textureSize.x() || header.textureHeight != texture.textureSize.y() ||
+		header.usedHeight <= 0 || header.usedHeight > header.textureHeight || header.glyphCount > GLYPH_CACHE_LAST - GLYPH_CACHE_FIRST + 1)
+		return false;
+
+	entries.resize(header.glyphCount);
+	bitmap.resize(header.textureWidth * header.usedHeight);
+	file.read((char*)entries.data(), entries.size() * sizeof(GlyphCacheEntry));
+	file.read((char*)bitmap.data(), bitmap.size());
+	return file.good();
+}
+
+bool Font::loadGlyphCache()
+{
+	// the key covers the font itself, so a theme shipping a changed font with the same name never picks up old glyphs
+	ResourceData data = ResourceManager::getInstance()->getFileData(mPath);
+	if(!data.ptr)
+		return false;
+
+	uint64_t hash = 14695981039346656037ULL; // FNV-1a
+	for(size_t i = 0; i < data.length; i++)
+		hash = (hash ^ data.ptr.get()[i]) * 1099511628211ULL;
+
+	char name[96];
+	snprintf(name, sizeof(name), "%016llx-%d-%d-%d.bin", (unsigned long long)hash, mSize, GLYPH_CACHE_FIRST, GLYPH_CACHE_LAST);
+	mGlyphCachePath = getHomePath() + "/.emulationstation/cache/fonts/" + name;
+
+	GlyphCacheHeader header;
+	std::vector<GlyphCacheEntry> entries;
+	std::vector<unsigned char> bitmap;
+	if(!readGlyphCache(header, entries, bitmap))
+		return false;
+
+	for(auto it = entries.cbegin(); it != entries.cend(); it++)
+	{
+		if(it->id < GLYPH_CACHE_FIRST || it->id > GLYPH_CACHE_LAST || it->x < 0 || it->y < 0 || it->width < 0 || it->height < 0 ||
+			it->x + it->width > header.textureWidth || it->y + it->height > header.usedHeight)
+		{
+			LOG(LogWarning) << "Glyph cache \"" << mGlyphCachePath << "\" is corrupt, rebuilding it";
+			return false;
+		}
+	}
+
+	mTextures.push_back(FontTexture());
+	FontTexture* tex = &mTextures.back();
+	tex->initTexture();
+	tex->writePos = Vector2i(header.writePosX, header.writePosY);
+	tex->rowHeight = header.rowHeight;
+
+	Renderer::bindTexture(tex->textureId);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, header.textureWidth, header.usedHeight, GL_ALPHA, GL_UNSIGNED_BYTE, bitmap.data());
+
+	for(auto it = entries.cbegin(); it != entries.cend(); it++)
+	{
+		Glyph& glyph = mGlyphMap[it->id];
+
+		glyph.texture = tex;
+		glyph.texPos = Vector2f(it->x / (float)tex->textureSize.x(), it->y / (float)tex->textureSize.y());
+		glyph.texSize = Vector2f(it->width / (float)tex->textureSize.x(), it->height / (float)tex->textureSize.y());
+		glyph.advance = Vector2f(it->advanceX, it->advanceY);
+		glyph.bearing = Vector2f(it->bearingX, it->bearingY);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+		if(it->height > mMaxGlyphHeight)
+			mMaxGlyphHeight = it->height;
+	}
+
+	mGlyphCacheValid = true;
+	return true;
+}
+
+void Font::saveGlyphCache()
+{
+	// glyphs that spilled over into a second texture would need more than one upload, don't bother
+	if(mGlyphCachePath.empty() || mTextures.size() != 1)
+		return;
+
+	const FontTexture& tex = mTextures.front();
+
+	GlyphCacheHeader header;
+	memcpy(header.magic, GLYPH_CACHE_MAGIC, 4);
+	header.version = GLYPH_CACHE_VERSION;
+	header.textureWidth = tex.textureSize.x();
+	header.textureHeight = tex.textureSize.y();
+	header.usedHeight = std::min(tex.writePos.y() + tex.rowHeight + 1, tex.textureSize.y());
+	header.writePosX = tex.writePos.x();
+	header.writePosY = tex.writePos.y();
+	header.rowHeight = tex.rowHeight;
+
+	std::vector<GlyphCacheEntry> entries;
+	for(auto it = mGlyphMap.cbegin(); it != mGlyphMap.cend(); it++)
+	{
+		GlyphCacheEntry entry;
+		entry.id = it->first;
+		entry.x = (int32_t)Math::round(it->second.texPos.x() * tex.textureSize.x());
+		entry.y = (int32_t)Math::round(it->second.texPos.y() * tex.textureSize.y());
+		entry.width = (int32_t)Math::round(it->second.texSize.x() * tex.textureSize.x());
+		entry.height = (int32_t)Math::round(it->second.texSize.y() * tex.textureSize.y());
+		entry.advanceX = it->second.advance.x();
+		entry.advanceY = it->second.advance.y();
+		entry.bearingX = it->second.bearing.x();
+		entry.bearingY = it->second.bearing.y();
+		entries.push_back(entry);
+	}
+	header.glyphCount = (uint32_t)entries.size();
+
+	// write through a temporary file so a partially written entry is never picked up
+	boost::system::error_code ec;
+	const std::string tempPath = mGlyphCachePath + ".tmp";
+	boost::filesystem::create_directories(boost::filesystem::path(mGlyphCachePath).parent_path(), ec);
+
+	std::ofstream file(tempPath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if(!file.is_open())
+		return;
+
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)entries.data(), entries.size() * sizeof(GlyphCacheEntry));
+	file.write((const char*)mGlyphCacheBitmap.data(), header.textureWidth * header.usedHeight);
+	file.close();
+
+	if(file.fail())
+	{
+		boost::filesystem::remove(tempPath, ec);
+		return;
+	}
+
+	boost::filesystem::rename(tempPath, mGlyphCachePath, ec);
+	mGlyphCacheValid = !ec;
+}
+
+bool Font::restoreGlyphCache()
+{
+	if(!mGlyphCacheValid || mTextures.empty())
+		return false;
+
+	GlyphCacheHeader header;
+	std::vector<GlyphCacheEntry> entries;
+	std::vector<unsigned char> bitmap;
+	if(!readGlyphCache(header, entries, bitmap))
+		return false;
+
+	// this also clears the glyphs added next to the cached ones since, rebuildTextures() uploads those afterwards
+	Renderer::bindTexture(mTextures.front().textureId);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, header.textureWidth, header.usedHeight, GL_ALPHA, GL_UNSIGNED_BYTE, bitmap.data());
+	return true;
 }
 
 void Font::renderTextCache(TextCache* cache)
@@ -407,33 +641,34 @@ void Font::renderTextCache(TextCache* cache)
 		return;
 	}
 
-	for(auto it = cache->vertexLists.cbegin(); it != cache->vertexLists.cend(); it++)
+	for(auto it = cache->vertexLists.begin(); it != cache->vertexLists.end(); it++)
 	{
 		assert(*it->textureIdPtr != 0);
 
-		auto vertexList = *it;
-
-		glBindTexture(GL_TEXTURE_2D, *it->textureIdPtr);
-		glEnable(GL_TEXTURE_2D);
-		glEnable(GL_BLEND);
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		Renderer::bindTexture(*it->textureIdPtr);
 
-		glEnableClientState(GL_VERTEX_ARRAY);
-		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-		glEnableClientState(GL_COLOR_ARRAY);
-
-		glVertexPointer(2, GL_FLOAT, sizeof(TextCache::Vertex), &it->verts[0].pos);
-		glTexCoordPointer(2, GL_FLOAT, sizeof(TextCache::Vertex), &it->verts[0].tex);
-		glColorPointer(4, GL_UNSIGNED_BYTE, 0, it->colors.data());
+		if(!Renderer::hasBuffers())
+		{
+			Renderer::drawTriangles(it->verts.data(), it->colors.data(), (unsigned int)it->verts.size());
+			continue;
+		}
 
-		glDrawArrays(GL_TRIANGLES, 0, (GLsizei)(it->verts.size()));
+		if(it->vertexBuffer == 0 || it->bufferGeneration != Renderer::getContextGeneration())
+		{
+			it->vertexBuffer = Renderer::createBuffer();
+			it->colorBuffer = Renderer::createBuffer();
+			it->bufferGeneration = Renderer::getContextGeneration();
+			Renderer::uploadBuffer(it->vertexBuffer, it->verts.data(), it->verts.size() * sizeof(TextCache::Vertex));
+			it->colorsDirty = true;
+		}
 
-		glDisableClientState(GL_VERTEX_ARRAY);
-		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-		glDisableClientState(GL_COLOR_ARRAY);
+		if(it->colorsDirty)
+		{
+			Renderer::uploadBuffer(it->colorBuffer, it->colors.data(), it->colors.size());
+			it->colorsDirty = false;
+		}
 
-		glDisable(GL_TEXTURE_2D);
-		glDisable(GL_BLEND);
+		Renderer::drawBuffers(it->vertexBuffer, it->colorBuffer, (unsigned int)it->verts.size());
 	}
 }
 
@@ -460,9 +695,7 @@ Vector2f Font::sizeText(std::string text, float lineSpacing)
 			y += lineHeight;
 		}
 
-		Glyph* glyph = getGlyph(character);
-		if(glyph)
-			lineWidth += glyph->advance.x();
+		lineWidth += getAdvance(character);
 	}
 
 	if(lineWidth > highestWidth)
@@ -483,48 +716,95 @@ float Font::getLetterHeight()
 	return glyph->texSize.y() * glyph->texture->textureSize.y();
 }
 
-//the worst algorithm ever written
 //breaks up a normal string with newlines to make it fit xLen
+//a word (including the whitespace that ends it) goes on the current line if the line would still fit, otherwise it starts a new one
 std::string Font::wrapText(std::string text, float xLen)
 {
 	std::string out;
+	out.reserve(text.length() + text.length() / 16);
 
-	std::string line, word, temp;
-	size_t space;
-
-	Vector2f textSize;
+	size_t lineStart = 0;
+	float lineWidth = 0.0f; // widest part of the current line before a newline inside it
+	float partWidth = 0.0f; // width of the current line after its last newline
 
-	while(text.length() > 0) //while there's text or we still have text to render
+	size_t wordStart = 0;
+	while(wordStart < text.length())
 	{
-		space = text.find_first_of(" \t\n");
-		if(space == std::string::npos)
-			space = text.length() - 1;
-
-		word = text.substr(0, space + 1);
-		text.erase(0, space + 1);
-
-		temp = line + word;
-
-		textSize = sizeText(temp);
+		size_t wordEnd = text.find_first_of(" \t\n", wordStart);
+		wordEnd = (wordEnd == std::string::npos) ? text.length() : wordEnd + 1;
+
+		// measure the line with the word appended, summing in the same order sizeText() would
+		float width = lineWidth;
+		float part = partWidth;
+		size_t cursor = wordStart;
+		while(cursor < wordEnd)
+		{
+			unsigned int character = Utils::String::chars2Unicode(text, cursor); // advances cursor
+			if(character == '\n')
+			{
+				if(part > width)
+					width = part;
+				part = 0.0f;
+			}
+			part += getAdvance(character);
+		}
 
-		// if the word will fit on the line, add it to our line, and continue
-		if(textSize.x() <= xLen)
+		if((part > width ? part : width) <= xLen)
 		{
-			line = temp;
-			continue;
+			// the word fits, add it to our line
+			lineWidth = width;
+			partWidth = part;
 		}else{
-			// the next word won't fit, so break here
-			out += line + '\n';
-			line = word;
+			// the word won't fit, so break before it and start the next line with it
+			out.append(text, lineStart, wordStart - lineStart);
+			out += '\n';
+			lineStart = wordStart;
+
+			lineWidth = 0.0f;
+			partWidth = 0.0f;
+			cursor = wordStart;
+			while(cursor < wordEnd)
+			{
+				unsigned int character = Utils::String::chars2Unicode(text, cursor); // advances cursor
+				if(character == '\n')
+				{
+					if(partWidth > lineWidth)
+						lineWidth = partWidth;
+					partWidth = 0.0f;
+				}
+				partWidth += getAdvance(character);
+			}
 		}
+
+		wordStart = wordEnd;
 	}
 
 	// whatever's left should fit
-	out += line;
+	out.append(text, lineStart, std::string::npos);
 
 	return out;
 }
 
+std::string Font::abbreviateText(const std::string& text, float xLen)
+{
+	const std::string abbrev = "...";
+	const float abbrevWidth = sizeText(abbrev).x();
+
+	// keep the longest prefix that still leaves room for the abbreviation
+	size_t keep = 0;
+	float width = 0.0f;
+	size_t cursor = 0;
+	while(cursor < text.length())
+	{
+		width += getAdvance(Utils::String::chars2Unicode(text, cursor)); // advances cursor
+		if(width + abbrevWidth > xLen)
+			break;
+		keep = cursor;
+	}
+
+	return text.substr(0, keep) + abbrev;
+}
+
 Vector2f Font::sizeWrappedText(std::string text, float xLen, float lineSpacing)
 {
 	text = wrapText(text, xLen);
@@ -563,9 +843,7 @@ Vector2f Font::getWrappedTextCursorOffset(std::string text, float xLen, size_t s
 			continue;
 		}
 
-		Glyph* glyph = getGlyph(character);
-		if(glyph)
-			lineWidth += glyph->advance.x();
+		lineWidth += getAdvance(character);
 	}
 
 	return Vector2f(lineWidth, y);
@@ -669,9 +947,10 @@ TextCache* Font::buildTextCache(const std::string& text, Vector2f offset, unsign
 	TextCache* cache = new TextCache();
 	cache->vertexLists.resize(vertMap.size());
 	cache->metrics = { sizeText(text, lineSpacing) };
+	cache->mColor = color;
 
 	unsigned int i = 0;
-	for(auto it = vertMap.cbegin(); it != vertMap.cend(); it++)
+	for(auto it = vertMap.cbegin(); it != vertMap.cend(); it++, i++)
 	{
 		TextCache::VertexList& vertList = cache->vertexLists.at(i);
 
@@ -692,10 +971,30 @@ TextCache* Font::buildTextCache(const std::string& text, float offsetX, float of
 	return buildTextCache(text, Vector2f(offsetX, offsetY), color, 0.0f);
 }
 
-void TextCache::setColor(unsigned int color)
+TextCache::~TextCache()
 {
 	for(auto it = vertexLists.cbegin(); it != vertexLists.cend(); it++)
-		Renderer::buildGLColorArray((GLubyte*)(it->colors.data()), color, (unsigned int)(it->verts.size()));
+	{
+		if(it->vertexBuffer != 0 && it->bufferGeneration == Renderer::getContextGeneration())
+		{
+			Renderer::deleteBuffer(it->vertexBuffer);
+			Renderer::deleteBuffer(it->colorBuffer);
+		}
+	}
+}
+
+void TextCache::setColor(unsigned int color)
+{
+	// many callers set the color every frame, only a real change touches the color buffers
+	if(color == mColor)
+		return;
+
+	mColor = color;
+	for(auto it = vertexLists.begin(); it != vertexLists.end(); it++)
+	{
+		Renderer::buildGLColorArray(it->colors.data(), color, (unsigned int)(it->verts.size()));
+		it->colorsDirty = true;
+	}
 }
 
 std::shared_ptr<Font> Font::getFromTheme(const ThemeData::ThemeElement* elem, unsigned int properties, const std::shared_ptr<Font>& orig)
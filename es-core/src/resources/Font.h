@@ -47,6 +47,7 @@ public:
 	void renderTextCache(TextCache* cache);
 	
 	std::string wrapText(std::string text, float xLen); // Inserts newlines into text to make it wrap properly.
+	std::string abbreviateText(const std::string& text, float xLen); // Cuts a single line of text short and appends "..." so it fits xLen.
 	Vector2f sizeWrappedText(std::string text, float xLen, float lineSpacing = 1.5f); // Returns the expected size of a string after wrapping is applied.
 	Vector2f getWrappedTextCursorOffset(std::string text, float xLen, size_t cursor, float lineSpacing = 1.5f); // Returns the position of of the cursor after moving "cursor" characters.
 
@@ -101,6 +102,19 @@ private:
 	void rebuildTextures();
 	void unloadTextures();
 
+	// the atlas of the glyphs every font needs is cached on disk, with the metrics of each glyph
+	struct GlyphCacheHeader;
+	struct GlyphCacheEntry;
+
+	bool loadGlyphCache();
+	void saveGlyphCache();
+	bool restoreGlyphCache(); // uploads the cached atlas again after the textures were rebuilt
+	bool readGlyphCache(GlyphCacheHeader& header, std::vector<GlyphCacheEntry>& entries, std::vector<unsigned char>& bitmap);
+
+	std::string mGlyphCachePath;
+	bool mGlyphCacheValid; // the cached atlas matches the first texture
+	std::vector<unsigned char> mGlyphCacheBitmap; // copy of the first texture while the cached glyphs are rasterized
+
 	std::vector<FontTexture> mTextures;
 
 	void getTextureForNewGlyph(const Vector2i& glyphSize, FontTexture*& tex_out, Vector2i& cursor_out);
@@ -124,6 +138,10 @@ private:
 
 	Glyph* getGlyph(unsigned int id);
 
+	// horizontal advances of the low codepoints (negative until looked up) so measuring text skips the glyph map
+	std::vector<float> mAdvances;
+	float getAdvance(unsigned int id);
+
 	int mMaxGlyphHeight;
 	
 	const int mSize;
@@ -141,22 +159,30 @@ private:
 class TextCache
 {
 protected:
-	struct Vertex
-	{
-		Vector2f pos;
-		Vector2f tex;
-	};
+	typedef Renderer::Vertex Vertex;
 
 	struct VertexList
 	{
+		VertexList() : textureIdPtr(NULL), vertexBuffer(0), colorBuffer(0), bufferGeneration(0), colorsDirty(false) {}
+
 		GLuint* textureIdPtr; // this is a pointer because the texture ID can change during deinit/reinit (when launching a game)
 		std::vector<Vertex> verts;
 		std::vector<GLubyte> colors;
+
+		// verts and colors are uploaded on the first draw, and again only when they change or the GL context was recreated
+		GLuint vertexBuffer;
+		GLuint colorBuffer;
+		unsigned int bufferGeneration;
+		bool colorsDirty;
 	};
 
 	std::vector<VertexList> vertexLists;
+	unsigned int mColor;
 
 public:
+	TextCache() : mColor(0) {}
+	~TextCache();
+
 	struct CacheMetrics
 	{
 		Vector2f size;
@@ -0,0 +1,108 @@
+#include "resources/SVGRasterCache.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// carousel logos and help icons of a theme fit several times over
+#define SVG_RASTER_CACHE_MEMORY (32 * 1024 * 1024)
+
+SVGRasterCache* SVGRasterCache::getInstance()
+{
+	static SVGRasterCache* sInstance = new SVGRasterCache();
+	return sInstance;
+}
+
+SVGRasterCache::SVGRasterCache() : mMemorySize(0), mHitCount(0), mMissCount(0)
+{
+}
+
+std::string SVGRasterCache::getKey(const unsigned char* fileData, size_t length, float width, float height)
+{
+	// two independent 64-bit hashes plus the length, the disk cache trusts the key
+	uint64_t fnv = 14695981039346656037ULL;
+	for(size_t i = 0; i < length; i++)
+		fnv = (fnv ^ fileData[i]) * 1099511628211ULL;
+	const size_t hash = std::hash<std::string>()(std::string((const char*)fileData, length));
+
+	char key[128];
+	snprintf(key, sizeof(key), "svg:%016llx%016llx:%llu@%gx%g", (unsigned long long)fnv, (unsigned long long)hash, (unsigned long long)length, width, height);
+	return key;
+}
+
+unsigned char* SVGRasterCache::load(const std::string& key, ThumbnailCache::Info& info)
+{
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		auto it = mIndex.find(key);
+		if(it != mIndex.cend())
+		{
+			mRasters.splice(mRasters.begin(), mRasters, it->second);
+			info = it->second->info;
+
+			unsigned char* pixels = new unsigned char[info.dataSize];
+			memcpy(pixels, it->second->pixels.get(), info.dataSize);
+			mHitCount++;
+			return pixels;
+		}
+	}
+
+	ThumbnailCache* disk = ThumbnailCache::getInstance();
+	unsigned char* pixels = disk->isEnabled() ? disk->loadRaster(key, info) : nullptr;
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	if(pixels == nullptr)
+	{
+		mMissCount++;
+		return nullptr;
+	}
+
+	mHitCount++;
+	addLocked(key, pixels, info);
+	return pixels;
+}
+
+void SVGRasterCache::save(const std::string& key, const unsigned char* pixels, const ThumbnailCache::Info& info)
+{
+	ThumbnailCache* disk = ThumbnailCache::getInstance();
+	if(disk->isEnabled())
+		disk->saveRaster(key, pixels, info);
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	addLocked(key, pixels, info);
+}
+
+void SVGRasterCache::addLocked(const std::string& key, const unsigned char* pixels, const ThumbnailCache::Info& info)
+{
+	if(info.dataSize > SVG_RASTER_CACHE_MEMORY || mIndex.find(key) != mIndex.cend())
+		return;
+
+	while(mMemorySize + info.dataSize > SVG_RASTER_CACHE_MEMORY)
+	{
+		mMemorySize -= mRasters.back().info.dataSize;
+		mIndex.erase(mRasters.back().key);
+		mRasters.pop_back();
+	}
+
+	mRasters.push_front(Raster());
+	Raster& raster = mRasters.front();
+	raster.key = key;
+	raster.info = info;
+	raster.pixels.reset(new unsigned char[info.dataSize]);
+	memcpy(raster.pixels.get(), pixels, info.dataSize);
+
+	mIndex[key] = mRasters.begin();
+	mMemorySize += info.dataSize;
+}
+
+size_t SVGRasterCache::getHitCount()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	return mHitCount;
+}
+
+size_t SVGRasterCache::getMissCount()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	return mMissCount;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#ifndef ES_CORE_RESOURCES_SVG_RASTER_CACHE_H
+#define ES_CORE_RESOURCES_SVG_RASTER_CACHE_H
+
+#include "resources/ThumbnailCache.h"
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Rasterized (and already flipped) SVG images, keyed by the SVG content and the size they were rasterized at,
+// so theme reloads and rasterizeAt() never run nanosvg twice for the same result.
+// Recently used rasters are kept in memory, everything also goes to the ThumbnailCache on disk.
+class SVGRasterCache
+{
+public:
+	static SVGRasterCache* getInstance();
+
+	// width/height are the requested size (0 for either means keep the aspect ratio, 0 for both the SVG's own size)
+	static std::string getKey(const unsigned char* fileData, size_t length, float width, float height);
+
+	// Returns the cached pixels (allocated with new[], owned by the caller) or nullptr on a miss.
+	// info.sourceWidth/sourceHeight hold the size of the SVG itself.
+	unsigned char* load(const std::string& key, ThumbnailCache::Info& info);
+	void save(const std::string& key, const unsigned char* pixels, const ThumbnailCache::Info& info);
+
+	size_t getHitCount();
+	size_t getMissCount();
+
+private:
+	SVGRasterCache();
+
+	struct Raster
+	{
+		std::string key;
+		ThumbnailCache::Info info;
+		std::unique_ptr<unsigned char[]> pixels;
+	};
+
+	void addLocked(const std::string& key, const unsigned char* pixels, const ThumbnailCache::Info& info);
+
+	std::mutex mMutex;
+	std::list<Raster> mRasters; // most recently used first
+	std::map<std::string, std::list<Raster>::iterator> mIndex;
+	size_t mMemorySize;
+
+	size_t mHitCount;
+	size_t mMissCount;
+};
+
+#endif // ES_CORE_RESOURCES_SVG_RASTER_CACHE_H
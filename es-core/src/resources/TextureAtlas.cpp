@@ -0,0 +1,97 @@
+#include "resources/TextureAtlas.h"
+
+#include "resources/TextureData.h"
+#include "Log.h"
+#include "Renderer.h"
+#include <math.h>
+
+std::shared_ptr<TextureAtlas> TextureAtlas::get(size_t cellWidth, size_t cellHeight, size_t cellCount)
+{
+	std::shared_ptr<TextureAtlas> atlas(new TextureAtlas(cellWidth, cellHeight, cellCount));
+	ResourceManager::getInstance()->addReloadable(atlas);
+	return atlas;
+}
+
+TextureAtlas::TextureAtlas(size_t cellWidth, size_t cellHeight, size_t cellCount) : mCellWidth(cellWidth > 0 ? cellWidth : 1),
+	mCellHeight(cellHeight > 0 ? cellHeight : 1), mTextureID(0), mGeneration(0)
+{
+	// roughly square, and within what every GL implementation we run on can do
+	const size_t maxSize = 2048;
+	mColumns = (size_t)ceil(sqrt((double)(cellCount > 0 ? cellCount : 1) * mCellHeight / mCellWidth));
+	if(mColumns * mCellWidth > maxSize)
+		mColumns = maxSize / mCellWidth > 0 ? maxSize / mCellWidth : 1;
+
+	size_t rows = (cellCount + mColumns - 1) / mColumns;
+	if(rows * mCellHeight > maxSize)
+		rows = maxSize / mCellHeight > 0 ? maxSize / mCellHeight : 1;
+
+	mCellCount = mColumns * rows < cellCount ? mColumns * rows : cellCount;
+	mWidth = mColumns * mCellWidth;
+	mHeight = rows * mCellHeight;
+}
+
+TextureAtlas::~TextureAtlas()
+{
+	if(mTextureID != 0)
+		Renderer::deleteTexture(mTextureID);
+}
+
+void TextureAtlas::createTexture()
+{
+	glGenTextures(1, &mTextureID);
+	Renderer::bindTexture(mTextureID);
+
+	// cells are filled one by one with glTexSubImage2D
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, (GLsizei)mWidth, (GLsizei)mHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+bool TextureAtlas::upload(size_t cell, TextureData& data)
+{
+	if(cell >= mCellCount || data.width() > mCellWidth || data.height() > mCellHeight)
+		return false;
+
+	bind();
+	if(!data.uploadSubImage((GLint)((cell % mColumns) * mCellWidth), (GLint)((cell / mColumns) * mCellHeight)))
+	{
+		LOG(LogWarning) << "Could not add a texture to the atlas";
+		return false;
+	}
+
+	return true;
+}
+
+Vector4f TextureAtlas::getTexCoords(size_t cell, size_t width, size_t height) const
+{
+	// stay half a texel inside the image, so linear filtering never picks up the neighbouring cell
+	const float x = (float)((cell % mColumns) * mCellWidth);
+	const float y = (float)((cell / mColumns) * mCellHeight);
+	return Vector4f((x + 0.5f) / mWidth, (y + 0.5f) / mHeight, (x + width - 0.5f) / mWidth, (y + height - 0.5f) / mHeight);
+}
+
+void TextureAtlas::bind()
+{
+	if(mTextureID == 0)
+		createTexture();
+	else
+		Renderer::bindTexture(mTextureID);
+}
+
+void TextureAtlas::unload(std::shared_ptr<ResourceManager>& /*rm*/)
+{
+	if(mTextureID != 0)
+	{
+		Renderer::deleteTexture(mTextureID);
+		mTextureID = 0;
+	}
+	mGeneration++;
+}
+
+void TextureAtlas::reload(std::shared_ptr<ResourceManager>& /*rm*/)
+{
+	// the texture is created again on the next bind(), its owner uploads the cells again
+}
@@ -0,0 +1,55 @@
+#pragma once
+#ifndef ES_CORE_RESOURCES_TEXTURE_ATLAS_H
+#define ES_CORE_RESOURCES_TEXTURE_ATLAS_H
+
+#include "math/Vector4f.h"
+#include "resources/ResourceManager.h"
+#include "platform.h"
+#include GLHEADER
+#include <memory>
+
+class TextureData;
+
+// One GL texture divided into equally sized cells, each holding one small image (uploaded from a loaded TextureData),
+// so a component can draw many images with a single bind and draw call.
+// Cells are handed out by the owner, the atlas only knows where they are.
+// The GL texture is dropped on unload; getGeneration() then changes and every cell has to be uploaded again.
+class TextureAtlas : public IReloadable
+{
+public:
+	// the atlas may hold fewer cells than asked for if the texture would get too large, see getCellCount()
+	static std::shared_ptr<TextureAtlas> get(size_t cellWidth, size_t cellHeight, size_t cellCount);
+	virtual ~TextureAtlas();
+
+	size_t getCellCount() const { return mCellCount; }
+	size_t getCellWidth() const { return mCellWidth; }
+	size_t getCellHeight() const { return mCellHeight; }
+	unsigned int getGeneration() const { return mGeneration; }
+
+	// Copies the pixels of a loaded, uncompressed texture no larger than a cell into it. Render thread only.
+	bool upload(size_t cell, TextureData& data);
+
+	// Texture coordinates (left, bottom, right, top) of an image of the given size uploaded to cell.
+	Vector4f getTexCoords(size_t cell, size_t width, size_t height) const;
+
+	void bind();
+
+	void unload(std::shared_ptr<ResourceManager>& rm) override;
+	void reload(std::shared_ptr<ResourceManager>& rm) override;
+
+private:
+	TextureAtlas(size_t cellWidth, size_t cellHeight, size_t cellCount);
+
+	void createTexture();
+
+	size_t mCellWidth;
+	size_t mCellHeight;
+	size_t mCellCount;
+	size_t mColumns;
+	size_t mWidth;
+	size_t mHeight;
+	GLuint mTextureID;
+	unsigned int mGeneration;
+};
+
+#endif // ES_CORE_RESOURCES_TEXTURE_ATLAS_H
@@ -0,0 +1,476 @@
+#include "resources/TextureCompression.h"
+
+#include "Log.h"
+#include "platform.h"
+#include "Settings.h"
+#include GLHEADER
+#include <SDL.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <vector>
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_ETC1_RGB8_OES
+#define GL_ETC1_RGB8_OES 0x8D64
+#endif
+
+namespace TextureCompression
+{
+	static std::atomic<bool> sHasS3TC(false);
+	static std::atomic<bool> sHasETC1(false);
+	static std::atomic<bool> sHasNPOTMipmaps(false);
+
+#ifdef USE_OPENGL_DESKTOP
+	// glCompressedTexImage2D is GL 1.3, which isn't exported directly everywhere (e.g. opengl32.dll)
+	typedef void (APIENTRY *CompressedTexImage2DFunction)(GLenum, GLint, GLenum, GLsizei, GLsizei, GLint, GLsizei, const GLvoid*);
+	static CompressedTexImage2DFunction sCompressedTexImage2D = NULL;
+#endif
+
+	void init()
+	{
+#ifdef USE_OPENGL_DESKTOP
+		sCompressedTexImage2D = (CompressedTexImage2DFunction)SDL_GL_GetProcAddress("glCompressedTexImage2D");
+		sHasS3TC = (sCompressedTexImage2D != NULL) && SDL_GL_ExtensionSupported("GL_EXT_texture_compression_s3tc");
+		sHasNPOTMipmaps = true;
+#else
+		sHasETC1 = SDL_GL_ExtensionSupported("GL_OES_compressed_ETC1_RGB8_texture") == SDL_TRUE;
+		sHasNPOTMipmaps = SDL_GL_ExtensionSupported("GL_OES_texture_npot") == SDL_TRUE;
+#endif
+
+		LOG(LogInfo) << "Texture compression: S3TC " << (sHasS3TC ? "yes" : "no") << ", ETC1 " << (sHasETC1 ? "yes" : "no") <<
+			", NPOT mipmaps " << (sHasNPOTMipmaps ? "yes" : "no");
+	}
+
+	Format getPreferredFormat()
+	{
+		if(!Settings::getInstance()->getBool("CompressTextures"))
+			return FORMAT_NONE;
+
+		if(sHasS3TC)
+			return FORMAT_DXT5;
+		if(sHasETC1)
+			return FORMAT_ETC1;
+
+		return FORMAT_NONE;
+	}
+
+	Format chooseFormat(Format preferred, const unsigned char* rgba, size_t width, size_t height)
+	{
+		if(preferred == FORMAT_NONE)
+			return FORMAT_NONE;
+
+		bool opaque = true;
+		for(size_t i = 0; i < width * height && opaque; i++)
+			opaque = rgba[i * 4 + 3] == 255;
+
+		if(preferred == FORMAT_ETC1)
+			return opaque ? FORMAT_ETC1 : FORMAT_NONE;
+
+		return opaque ? FORMAT_DXT1 : FORMAT_DXT5;
+	}
+
+	static bool isPowerOfTwo(size_t value)
+	{
+		return value > 0 && (value & (value - 1)) == 0;
+	}
+
+	bool canMipmap(size_t width, size_t height)
+	{
+		return sHasNPOTMipmaps || (isPowerOfTwo(width) && isPowerOfTwo(height));
+	}
+
+	size_t getLevelSize(Format format, size_t width, size_t height)
+	{
+		const size_t blocks = ((width + 3) / 4) * ((height + 3) / 4);
+		switch(format)
+		{
+			case FORMAT_DXT1:
+			case FORMAT_ETC1: return blocks * 8;
+			case FORMAT_DXT5: return blocks * 16;
+			default:          return width * height * 4;
+		}
+	}
+
+	size_t getDataSize(Format format, size_t width, size_t height, unsigned int levels)
+	{
+		size_t size = 0;
+		for(unsigned int i = 0; i < levels; i++)
+		{
+			size += getLevelSize(format, width, height);
+			width = width > 1 ? width / 2 : 1;
+			height = height > 1 ? height / 2 : 1;
+		}
+		return size;
+	}
+
+	// reads a 4x4 block, repeating the last row/column for blocks that hang over the edge
+	static void readBlock(const unsigned char* rgba, size_t width, size_t height, size_t bx, size_t by, unsigned char block[16][4])
+	{
+		for(size_t y = 0; y < 4; y++)
+		{
+			const size_t sy = (by + y < height) ? by + y : height - 1;
+			for(size_t x = 0; x < 4; x++)
+			{
+				const size_t sx = (bx + x < width) ? bx + x : width - 1;
+				memcpy(block[y * 4 + x], rgba + (sy * width + sx) * 4, 4);
+			}
+		}
+	}
+
+	static inline int colorDistance(const unsigned char* a, const int* b)
+	{
+		const int dr = a[0] - b[0], dg = a[1] - b[1], db = a[2] - b[2];
+		return dr * dr + dg * dg + db * db;
+	}
+
+	static inline uint16_t to565(const int* c)
+	{
+		return (uint16_t)(((c[0] * 31 + 127) / 255) << 11 | ((c[1] * 63 + 127) / 255) << 5 | ((c[2] * 31 + 127) / 255));
+	}
+
+	static inline void from565(uint16_t c, int* out)
+	{
+		out[0] = ((c >> 11) & 31) * 255 / 31;
+		out[1] = ((c >> 5) & 63) * 255 / 63;
+		out[2] = (c & 31) * 255 / 31;
+	}
+
+	// S3TC colour block, always in four colour mode: endpoints from the (slightly inset) bounding box of the colours
+	static void compressDXTColor(const unsigned char block[16][4], unsigned char* out)
+	{
+		int minColor[3] = { 255, 255, 255 };
+		int maxColor[3] = { 0, 0, 0 };
+		for(int i = 0; i < 16; i++)
+		{
+			for(int c = 0; c < 3; c++)
+			{
+				if(block[i][c] < minColor[c]) minColor[c] = block[i][c];
+				if(block[i][c] > maxColor[c]) maxColor[c] = block[i][c];
+			}
+		}
+
+		for(int c = 0; c < 3; c++)
+		{
+			const int inset = (maxColor[c] - minColor[c]) / 16;
+			minColor[c] += inset;
+			maxColor[c] -= inset;
+		}
+
+		uint16_t color0 = to565(maxColor);
+		uint16_t color1 = to565(minColor);
+		uint32_t indices = 0;
+
+		if(color0 < color1)
+		{
+			uint16_t swap = color0;
+			color0 = color1;
+			color1 = swap;
+		}
+
+		if(color0 != color1)
+		{
+			int palette[4][3];
+			from565(color0, palette[0]);
+			from565(color1, palette[1]);
+			for(int c = 0; c < 3; c++)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+
+			for(int i = 0; i < 16; i++)
+			{
+				int best = 0;
+				int bestDistance = colorDistance(block[i], palette[0]);
+				for(int p = 1; p < 4; p++)
+				{
+					const int distance = colorDistance(block[i], palette[p]);
+					if(distance < bestDistance)
+					{
+						best = p;
+						bestDistance = distance;
+					}
+				}
+				indices |= (uint32_t)best << (i * 2);
+			}
+		}
+
+		out[0] = color0 & 0xFF; out[1] = color0 >> 8;
+		out[2] = color1 & 0xFF; out[3] = color1 >> 8;
+		out[4] = indices & 0xFF; out[5] = (indices >> 8) & 0xFF; out[6] = (indices >> 16) & 0xFF; out[7] = indices >> 24;
+	}
+
+	// DXT5 alpha block in eight value mode
+	static void compressDXTAlpha(const unsigned char block[16][4], unsigned char* out)
+	{
+		int minAlpha = 255;
+		int maxAlpha = 0;
+		for(int i = 0; i < 16; i++)
+		{
+			if(block[i][3] < minAlpha) minAlpha = block[i][3];
+			if(block[i][3] > maxAlpha) maxAlpha = block[i][3];
+		}
+
+		out[0] = (unsigned char)maxAlpha;
+		out[1] = (unsigned char)minAlpha;
+
+		uint64_t indices = 0;
+		if(maxAlpha != minAlpha)
+		{
+			int palette[8];
+			palette[0] = maxAlpha;
+			palette[1] = minAlpha;
+			for(int p = 1; p < 7; p++)
+				palette[p + 1] = ((7 - p) * maxAlpha + p * minAlpha) / 7;
+
+			for(int i = 0; i < 16; i++)
+			{
+				int best = 0;
+				int bestDistance = 256;
+				for(int p = 0; p < 8; p++)
+				{
+					const int distance = abs(block[i][3] - palette[p]);
+					if(distance < bestDistance)
+					{
+						best = p;
+						bestDistance = distance;
+					}
+				}
+				indices |= (uint64_t)best << (i * 3);
+			}
+		}
+
+		for(int b = 0; b < 6; b++)
+			out[2 + b] = (unsigned char)(indices >> (b * 8));
+	}
+
+	static const int sETC1Modifiers[8][2] = { { 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 }, { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 } };
+
+	static inline int clampByte(int value)
+	{
+		return value < 0 ? 0 : (value > 255 ? 255 : value);
+	}
+
+	// one ETC1 sub-block in individual mode: average colour quantized to 4 bits, best of the 8 modifier tables
+	// returns the error, and writes the base colour, table and the 2-bit pixel indices (msb << 1 | lsb)
+	static int compressETC1SubBlock(const unsigned char block[16][4], const int* pixels, int* base, int& table, int* pixelIndices)
+	{
+		int sum[3] = { 0, 0, 0 };
+		for(int i = 0; i < 8; i++)
+		{
+			for(int c = 0; c < 3; c++)
+				sum[c] += block[pixels[i]][c];
+		}
+
+		int color[3];
+		for(int c = 0; c < 3; c++)
+		{
+			base[c] = (sum[c] / 8 * 15 + 127) / 255;
+			color[c] = base[c] << 4 | base[c];
+		}
+
+		int bestError = -1;
+		for(int t = 0; t < 8; t++)
+		{
+			// index values: 0 = +small, 1 = +large, 2 = -small, 3 = -large
+			const int modifiers[4] = { sETC1Modifiers[t][0], sETC1Modifiers[t][1], -sETC1Modifiers[t][0], -sETC1Modifiers[t][1] };
+			int error = 0;
+			int indices[8];
+			for(int i = 0; i < 8; i++)
+			{
+				int bestDistance = -1;
+				for(int m = 0; m < 4; m++)
+				{
+					const int candidate[3] = { clampByte(color[0] + modifiers[m]), clampByte(color[1] + modifiers[m]), clampByte(color[2] + modifiers[m]) };
+					const int distance = colorDistance(block[pixels[i]], candidate);
+					if(bestDistance < 0 || distance < bestDistance)
+					{
+						bestDistance = distance;
+						indices[i] = m;
+					}
+				}
+				error += bestDistance;
+			}
+
+			if(bestError < 0 || error < bestError)
+			{
+				bestError = error;
+				table = t;
+				memcpy(pixelIndices, indices, sizeof(indices));
+			}
+		}
+
+		return bestError;
+	}
+
+	static void compressETC1(const unsigned char block[16][4], unsigned char* out)
+	{
+		// block[] is row major (y * 4 + x), try both sub-block layouts and keep the better one
+		uint64_t bestBits = 0;
+		int bestError = -1;
+		for(int flip = 0; flip < 2; flip++)
+		{
+			int pixels[2][8];
+			for(int i = 0; i < 8; i++)
+			{
+				if(flip)
+				{
+					// 4x2 blocks on top of each other
+					pixels[0][i] = (i / 4) * 4 + (i % 4);
+					pixels[1][i] = (i / 4 + 2) * 4 + (i % 4);
+				}
+				else
+				{
+					// 2x4 blocks side by side
+					pixels[0][i] = (i / 2) * 4 + (i % 2);
+					pixels[1][i] = (i / 2) * 4 + (i % 2) + 2;
+				}
+			}
+
+			int base[2][3];
+			int table[2];
+			int indices[2][8];
+			const int error = compressETC1SubBlock(block, pixels[0], base[0], table[0], indices[0]) +
+			                  compressETC1SubBlock(block, pixels[1], base[1], table[1], indices[1]);
+
+			if(bestError >= 0 && error >= bestError)
+				continue;
+
+			bestError = error;
+			uint64_t bits = 0;
+			bits |= (uint64_t)base[0][0] << 60 | (uint64_t)base[1][0] << 56;
+			bits |= (uint64_t)base[0][1] << 52 | (uint64_t)base[1][1] << 48;
+			bits |= (uint64_t)base[0][2] << 44 | (uint64_t)base[1][2] << 40;
+			bits |= (uint64_t)table[0] << 37 | (uint64_t)table[1] << 34;
+			bits |= (uint64_t)flip << 32; // diff bit (33) stays 0, individual mode
+
+			for(int s = 0; s < 2; s++)
+			{
+				for(int i = 0; i < 8; i++)
+				{
+					// pixel indices are stored column major (x * 4 + y)
+					const int p = pixels[s][i];
+					const int bit = (p % 4) * 4 + (p / 4);
+					bits |= (uint64_t)(indices[s][i] >> 1) << (16 + bit);
+					bits |= (uint64_t)(indices[s][i] & 1) << bit;
+				}
+			}
+			bestBits = bits;
+		}
+
+		for(int b = 0; b < 8; b++)
+			out[b] = (unsigned char)(bestBits >> (56 - b * 8));
+	}
+
+	static void compressLevel(Format format, const unsigned char* rgba, size_t width, size_t height, unsigned char* out)
+	{
+		unsigned char block[16][4];
+		for(size_t by = 0; by < height; by += 4)
+		{
+			for(size_t bx = 0; bx < width; bx += 4)
+			{
+				readBlock(rgba, width, height, bx, by, block);
+				switch(format)
+				{
+					case FORMAT_DXT1: compressDXTColor(block, out); out += 8; break;
+					case FORMAT_DXT5: compressDXTAlpha(block, out); compressDXTColor(block, out + 8); out += 16; break;
+					case FORMAT_ETC1: compressETC1(block, out); out += 8; break;
+					default: break;
+				}
+			}
+		}
+	}
+
+	// 2x2 box filter, odd sizes drop their last row/column
+	static void downsample(const unsigned char* src, size_t width, size_t height, std::vector<unsigned char>& dst)
+	{
+		const size_t dstWidth = width > 1 ? width / 2 : 1;
+		const size_t dstHeight = height > 1 ? height / 2 : 1;
+		dst.resize(dstWidth * dstHeight * 4);
+		for(size_t y = 0; y < dstHeight; y++)
+		{
+			const size_t y0 = y * 2;
+			const size_t y1 = (height > 1) ? y0 + 1 : y0;
+			for(size_t x = 0; x < dstWidth; x++)
+			{
+				const size_t x0 = x * 2;
+				const size_t x1 = (width > 1) ? x0 + 1 : x0;
+				for(int c = 0; c < 4; c++)
+				{
+					dst[(y * dstWidth + x) * 4 + c] = (unsigned char)((src[(y0 * width + x0) * 4 + c] + src[(y0 * width + x1) * 4 + c] +
+						src[(y1 * width + x0) * 4 + c] + src[(y1 * width + x1) * 4 + c] + 2) / 4);
+				}
+			}
+		}
+	}
+
+	unsigned char* compress(Format format, const unsigned char* rgba, size_t width, size_t height, bool mipmaps, unsigned int& levels)
+	{
+		levels = 1;
+		if(mipmaps)
+		{
+			for(size_t size = width > height ? width : height; size > 1; size /= 2)
+				levels++;
+		}
+
+		unsigned char* out = new unsigned char[getDataSize(format, width, height, levels)];
+
+		std::vector<unsigned char> level;
+		std::vector<unsigned char> nextLevel;
+		const unsigned char* levelData = rgba;
+		size_t offset = 0;
+		for(unsigned int i = 0; i < levels; i++)
+		{
+			compressLevel(format, levelData, width, height, out + offset);
+			offset += getLevelSize(format, width, height);
+
+			if(i + 1 < levels)
+			{
+				downsample(levelData, width, height, nextLevel);
+				level.swap(nextLevel);
+				levelData = level.data();
+				width = width > 1 ? width / 2 : 1;
+				height = height > 1 ? height / 2 : 1;
+			}
+		}
+
+		return out;
+	}
+
+	bool upload(Format format, size_t width, size_t height, unsigned int levels, const unsigned char* data)
+	{
+		GLenum glFormat;
+		switch(format)
+		{
+			case FORMAT_DXT1: glFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT; break;
+			case FORMAT_DXT5: glFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT; break;
+			case FORMAT_ETC1: glFormat = GL_ETC1_RGB8_OES; break;
+			default: return false;
+		}
+
+		glGetError();
+		for(unsigned int i = 0; i < levels; i++)
+		{
+			const size_t size = getLevelSize(format, width, height);
+#ifdef USE_OPENGL_DESKTOP
+			if(sCompressedTexImage2D == NULL)
+				return false;
+			sCompressedTexImage2D(GL_TEXTURE_2D, (GLint)i, glFormat, (GLsizei)width, (GLsizei)height, 0, (GLsizei)size, data);
+#else
+			glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)i, glFormat, (GLsizei)width, (GLsizei)height, 0, (GLsizei)size, data);
+#endif
+			data += size;
+			width = width > 1 ? width / 2 : 1;
+			height = height > 1 ? height / 2 : 1;
+		}
+
+		return glGetError() == GL_NO_ERROR;
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+#ifndef ES_CORE_RESOURCES_TEXTURE_COMPRESSION_H
+#define ES_CORE_RESOURCES_TEXTURE_COMPRESSION_H
+
+#include <stddef.h>
+
+// CPU side mipmap generation and block compression for textures, and their upload.
+// Which formats can be used depends on the GL implementation, see init().
+namespace TextureCompression
+{
+	enum Format
+	{
+		FORMAT_NONE, // uncompressed RGBA
+		FORMAT_DXT1, // S3TC, opaque
+		FORMAT_DXT5, // S3TC, with alpha
+		FORMAT_ETC1  // OpenGL ES, opaque only
+	};
+
+	// Looks up what the current GL context supports, must be called on the render thread after the context is created.
+	void init();
+
+	// The format textures should be compressed to (following the "CompressTextures" setting), FORMAT_NONE if there is none.
+	// Images with alpha may still end up uncompressed if the format can't store it, see chooseFormat().
+	Format getPreferredFormat();
+	Format chooseFormat(Format preferred, const unsigned char* rgba, size_t width, size_t height);
+
+	// Whether mipmaps can be used for a texture of this size.
+	bool canMipmap(size_t width, size_t height);
+
+	size_t getLevelSize(Format format, size_t width, size_t height);
+	size_t getDataSize(Format format, size_t width, size_t height, unsigned int levels);
+
+	// Compresses rgba, and if mipmaps is set every mipmap level below it, levels one after the other.
+	// Returns the data (allocated with new[], owned by the caller, getDataSize() bytes).
+	unsigned char* compress(Format format, const unsigned char* rgba, size_t width, size_t height, bool mipmaps, unsigned int& levels);
+
+	// Uploads all levels to the bound texture, returns false if the GL implementation refused them.
+	bool upload(Format format, size_t width, size_t height, unsigned int levels, const unsigned char* data);
+}
+
+#endif // ES_CORE_RESOURCES_TEXTURE_COMPRESSION_H
@@ -2,19 +2,28 @@
 
 #include "math/Misc.h"
 #include "resources/ResourceManager.h"
+#include "resources/SVGRasterCache.h"
+#include "resources/ThumbnailCache.h"
 #include "ImageIO.h"
 #include "Log.h"
-#include "platform.h"
-#include GLHEADER
+#include "Renderer.h"
+#include "Settings.h"
 #include <nanosvg/nanosvg.h>
 #include <nanosvg/nanosvgrast.h>
 #include <assert.h>
 #include <string.h>
+#include <algorithm>
 
 #define DPI 96
 
+#ifndef GL_GENERATE_MIPMAP
+#define GL_GENERATE_MIPMAP 0x8191
+#endif
+
 TextureData::TextureData(bool tile) : mTile(tile), mTextureID(0), mDataRGBA(nullptr), mScalable(false),
-									  mWidth(0), mHeight(0), mSourceWidth(0.0f), mSourceHeight(0.0f)
+									  mWidth(0), mHeight(0), mSourceWidth(0.0f), mSourceHeight(0.0f), mMaxSize(0),
+									  mMipmaps(false), mAllowCompression(true), mFormat(TextureCompression::FORMAT_NONE), mLevels(1),
+									  mCompressionDeferred(false), mDeferredSaveToCache(false), mReupload(false)
 {
 }
 
@@ -41,6 +50,34 @@ bool TextureData::initSVGFromMemory(const unsigned char* fileData, size_t length
 			return true;
 	}
 
+	// the same SVG at the same size rasterizes to the same pixels, no matter which theme or component asks
+	const std::string key = SVGRasterCache::getKey(fileData, length, mSourceWidth, mSourceHeight);
+	ThumbnailCache::Info info;
+	unsigned char* cached = SVGRasterCache::getInstance()->load(key, info);
+	if (cached != nullptr)
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		if (mDataRGBA)
+		{
+			// someone else got there first
+			delete[] cached;
+			return true;
+		}
+
+		// the sizes are nanosvg's own floats, just like on a miss
+		if ((mSourceWidth == 0.0f) && (mSourceHeight == 0.0f))
+		{
+			mSourceWidth = info.sourceWidth;
+			mSourceHeight = info.sourceHeight;
+		}
+		mWidth = info.width;
+		mHeight = info.height;
+		mDataRGBA = cached;
+		mFormat = TextureCompression::FORMAT_NONE;
+		mLevels = 1;
+		return true;
+	}
+
 	// nsvgParse excepts a modifiable, null-terminated string
 	char* copy = (char*)malloc(length + 1);
 	assert(copy != NULL);
@@ -84,13 +121,30 @@ bool TextureData::initSVGFromMemory(const unsigned char* fileData, size_t length
 
 	ImageIO::flipPixelsVert(dataRGBA, mWidth, mHeight);
 
+	ThumbnailCache::Info rasterInfo = { mWidth, mHeight, svgImage->width, svgImage->height,
+		TextureCompression::FORMAT_NONE, 1, mWidth * mHeight * 4 };
+	SVGRasterCache::getInstance()->save(key, dataRGBA, rasterInfo);
+	nsvgDelete(svgImage);
+
 	std::unique_lock<std::mutex> lock(mMutex);
+	if (mDataRGBA)
+	{
+		delete[] dataRGBA;
+		return true;
+	}
 	mDataRGBA = dataRGBA;
+	mFormat = TextureCompression::FORMAT_NONE;
+	mLevels = 1;
 
 	return true;
 }
 
 bool TextureData::initImageFromMemory(const unsigned char* fileData, size_t length)
+{
+	return decodeImageFromMemory(fileData, length, false);
+}
+
+bool TextureData::decodeImageFromMemory(const unsigned char* fileData, size_t length, bool deferCompression)
 {
 	size_t width, height;
 
@@ -101,18 +155,136 @@ bool TextureData::initImageFromMemory(const unsigned char* fileData, size_t leng
 			return true;
 	}
 
-	std::vector<unsigned char> imageRGBA = ImageIO::loadFromMemoryRGBA32((const unsigned char*)(fileData), length, width, height);
-	if (imageRGBA.size() == 0)
+	// decode straight into the buffer we keep, instead of copying it through initFromRGBA()
+	size_t sourceWidth, sourceHeight;
+	unsigned char* imageRGBA = ImageIO::decodeFromMemoryRGBA32((const unsigned char*)(fileData), length, width, height, sourceWidth, sourceHeight, mTile ? 0 : mMaxSize);
+	if (imageRGBA == nullptr)
 	{
 		LOG(LogError) << "Could not initialize texture from memory, invalid data!  (file path: " << mPath << ", data ptr: " << (size_t)fileData << ", reported size: " << length << ")";
 		return false;
 	}
 
-	mSourceWidth = (float) width;
-	mSourceHeight = (float) height;
+	return initFromDecodedRGBA(imageRGBA, width, height, sourceWidth, sourceHeight, true, deferCompression);
+}
+
+bool TextureData::initFromDecodedRGBA(unsigned char* dataRGBA, size_t width, size_t height, size_t sourceWidth, size_t sourceHeight, bool saveToCache, bool deferCompression)
+{
+	ThumbnailCache::Info info = { width, height, (float)sourceWidth, (float)sourceHeight, TextureCompression::FORMAT_NONE, 1, width * height * 4 };
+	const bool useCache = isCacheable() && ThumbnailCache::getInstance()->isEnabled();
+	const TextureCompression::Format preferred = getCompressionFormat();
+
+	// on the main thread the pixels are kept as they are, a loader thread compresses them later (see compressDeferred())
+	if (deferCompression && preferred != TextureCompression::FORMAT_NONE)
+		return initFromCompressed(dataRGBA, info, true, saveToCache);
+
+	// compress here on the loader thread, uploadAndBind() then only hands the blocks to GL
+	const TextureCompression::Format format = TextureCompression::chooseFormat(preferred, dataRGBA, width, height);
+	if (format != TextureCompression::FORMAT_NONE)
+	{
+		unsigned char* compressed = TextureCompression::compress(format, dataRGBA, width, height, mMipmaps && TextureCompression::canMipmap(width, height), info.levels);
+		delete[] dataRGBA;
+
+		info.format = format;
+		info.dataSize = TextureCompression::getDataSize(format, width, height, info.levels);
+		if (useCache)
+			ThumbnailCache::getInstance()->save(mPath, mMaxSize, preferred, compressed, info);
+		return initFromCompressed(compressed, info);
+	}
+
+	// only scaled down images are worth caching, anything else decodes just as fast from the source
+	if (saveToCache && useCache && (width != sourceWidth || height != sourceHeight))
+		ThumbnailCache::getInstance()->save(mPath, mMaxSize, TextureCompression::FORMAT_NONE, dataRGBA, info);
+
+	return initFromCompressed(dataRGBA, info);
+}
+
+bool TextureData::initFromCompressed(unsigned char* data, const ThumbnailCache::Info& info, bool compressionDeferred, bool saveToCache)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	if (mDataRGBA)
+	{
+		// someone else got there first
+		delete[] data;
+		return true;
+	}
+
+	// the layout keeps using the size of the source image, even if the pixels were scaled down
+	mSourceWidth = info.sourceWidth;
+	mSourceHeight = info.sourceHeight;
 	mScalable = false;
+	mDataRGBA = data;
+	mWidth = info.width;
+	mHeight = info.height;
+	mFormat = (TextureCompression::Format) info.format;
+	mLevels = info.levels;
+	mCompressionDeferred = compressionDeferred;
+	mDeferredSaveToCache = compressionDeferred && saveToCache;
+	return true;
+}
+
+bool TextureData::hasDeferredCompression()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	return mCompressionDeferred;
+}
+
+bool TextureData::compressDeferred()
+{
+	// work on a copy, the pixels may be released or uploaded while they are compressed
+	unsigned char* pixels;
+	ThumbnailCache::Info info;
+	bool saveToCache;
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		if (!mCompressionDeferred || !mDataRGBA || mFormat != TextureCompression::FORMAT_NONE)
+			return false;
+
+		mCompressionDeferred = false;
+		saveToCache = mDeferredSaveToCache;
+		info.width = mWidth;
+		info.height = mHeight;
+		info.sourceWidth = mSourceWidth;
+		info.sourceHeight = mSourceHeight;
+		info.format = TextureCompression::FORMAT_NONE;
+		info.levels = 1;
+		info.dataSize = mWidth * mHeight * 4;
+		pixels = new unsigned char[info.dataSize];
+		memcpy(pixels, mDataRGBA, info.dataSize);
+	}
 
-	return initFromRGBA(imageRGBA.data(), width, height);
+	const TextureCompression::Format preferred = getCompressionFormat();
+	const TextureCompression::Format format = TextureCompression::chooseFormat(preferred, pixels, info.width, info.height);
+	if (format == TextureCompression::FORMAT_NONE)
+	{
+		// e.g. ETC1 and an image with transparency, it stays RGBA and, like in initFromDecodedRGBA(), is only worth caching if scaled down
+		if (saveToCache && ThumbnailCache::getInstance()->isEnabled() && (info.width != (size_t)info.sourceWidth || info.height != (size_t)info.sourceHeight))
+			ThumbnailCache::getInstance()->save(mPath, mMaxSize, TextureCompression::FORMAT_NONE, pixels, info);
+		delete[] pixels;
+		return false;
+	}
+
+	unsigned char* compressed = TextureCompression::compress(format, pixels, info.width, info.height, mMipmaps && TextureCompression::canMipmap(info.width, info.height), info.levels);
+	delete[] pixels;
+	info.format = format;
+	info.dataSize = TextureCompression::getDataSize(format, info.width, info.height, info.levels);
+	if (ThumbnailCache::getInstance()->isEnabled())
+		ThumbnailCache::getInstance()->save(mPath, mMaxSize, preferred, compressed, info);
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	if (!mDataRGBA || mFormat != TextureCompression::FORMAT_NONE || mWidth != info.width || mHeight != info.height)
+	{
+		// released (or replaced by a load of its own) meanwhile
+		delete[] compressed;
+		return false;
+	}
+
+	delete[] mDataRGBA;
+	mDataRGBA = compressed;
+	mFormat = format;
+	mLevels = info.levels;
+	mCompressionDeferred = false;
+	mReupload = (mTextureID != 0);
+	return true;
 }
 
 bool TextureData::initFromRGBA(const unsigned char* dataRGBA, size_t width, size_t height)
@@ -127,16 +299,49 @@ bool TextureData::initFromRGBA(const unsigned char* dataRGBA, size_t width, size
 	memcpy(mDataRGBA, dataRGBA, width * height * 4);
 	mWidth = width;
 	mHeight = height;
+	mFormat = TextureCompression::FORMAT_NONE;
+	mLevels = 1;
 	return true;
 }
 
-bool TextureData::load()
+bool TextureData::isCacheable()
+{
+	return mMaxSize > 0 && !mTile && !mPath.empty() && mPath[0] != ':' && mPath.substr(mPath.size() - 4, std::string::npos) != ".svg";
+}
+
+TextureCompression::Format TextureData::getCompressionFormat()
+{
+	return (isCacheable() && mAllowCompression) ? TextureCompression::getPreferredFormat() : TextureCompression::FORMAT_NONE;
+}
+
+bool TextureData::load(bool deferCompression)
 {
 	bool retval = false;
 
 	// Need to load. See if there is a file
 	if (!mPath.empty())
 	{
+		mMipmaps = isCacheable() && Settings::getInstance()->getBool("MipmapTextures");
+
+		// a scaled down (or compressed) copy may already be on disk, which saves reading and decoding the source
+		if (isCacheable() && ThumbnailCache::getInstance()->isEnabled())
+		{
+			ThumbnailCache::Info info;
+			const TextureCompression::Format preferred = getCompressionFormat();
+			if (preferred != TextureCompression::FORMAT_NONE)
+			{
+				unsigned char* cached = ThumbnailCache::getInstance()->load(mPath, mMaxSize, preferred, info);
+				// compressed with or without mipmaps, whatever was enabled back then
+				if (cached != nullptr && (info.levels > 1) == (mMipmaps && TextureCompression::canMipmap(info.width, info.height)))
+					return initFromCompressed(cached, info);
+				delete[] cached;
+			}
+
+			unsigned char* cached = ThumbnailCache::getInstance()->load(mPath, mMaxSize, TextureCompression::FORMAT_NONE, info);
+			if (cached != nullptr)
+				return initFromDecodedRGBA(cached, info.width, info.height, (size_t)info.sourceWidth, (size_t)info.sourceHeight, false, deferCompression);
+		}
+
 		std::shared_ptr<ResourceManager>& rm = ResourceManager::getInstance();
 		const ResourceData& data = rm->getFileData(mPath);
 		// is it an SVG?
@@ -146,7 +351,7 @@ bool TextureData::load()
 			retval = initSVGFromMemory((const unsigned char*)data.ptr.get(), data.length);
 		}
 		else
-			retval = initImageFromMemory((const unsigned char*)data.ptr.get(), data.length);
+			retval = decodeImageFromMemory((const unsigned char*)data.ptr.get(), data.length, deferCompression);
 	}
 	return retval;
 }
@@ -163,9 +368,17 @@ bool TextureData::uploadAndBind()
 {
 	// See if it's already been uploaded
 	std::unique_lock<std::mutex> lock(mMutex);
+	if (mReupload)
+	{
+		// the RGBA upload is replaced by the compressed pixels
+		Renderer::deleteTexture(mTextureID);
+		mTextureID = 0;
+		mReupload = false;
+	}
+
 	if (mTextureID != 0)
 	{
-		glBindTexture(GL_TEXTURE_2D, mTextureID);
+		Renderer::bindTexture(mTextureID);
 	}
 	else
 	{
@@ -180,11 +393,34 @@ bool TextureData::uploadAndBind()
 		glGetError();
 		//now for the openGL texture stuff
 		glGenTextures(1, &mTextureID);
-		glBindTexture(GL_TEXTURE_2D, mTextureID);
+		Renderer::bindTexture(mTextureID);
 
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, (GLsizei)mWidth, (GLsizei)mHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, mDataRGBA);
+		if (mFormat != TextureCompression::FORMAT_NONE)
+		{
+			// the mipmaps, if any, were compressed along with the image
+			if (!TextureCompression::upload(mFormat, mWidth, mHeight, mLevels, mDataRGBA))
+			{
+				LOG(LogError) << "Could not upload compressed texture \"" << mPath << "\"";
+				Renderer::deleteTexture(mTextureID);
+				mTextureID = 0;
+				return false;
+			}
+		}
+		else
+		{
+			// let the driver build the mipmaps, it does so when level 0 is uploaded
+			const bool mipmaps = mMipmaps && TextureCompression::canMipmap(mWidth, mHeight);
+			if (mipmaps)
+				glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE);
+
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, (GLsizei)mWidth, (GLsizei)mHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, mDataRGBA);
+
+			mLevels = 1;
+			for (size_t size = std::max(mWidth, mHeight); mipmaps && size > 1; size /= 2)
+				mLevels++;
+		}
 
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mLevels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
 		const GLint wrapMode = mTile ? GL_REPEAT : GL_CLAMP_TO_EDGE;
@@ -194,14 +430,25 @@ bool TextureData::uploadAndBind()
 	return true;
 }
 
+bool TextureData::uploadSubImage(GLint x, GLint y)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	if (!mDataRGBA || mFormat != TextureCompression::FORMAT_NONE)
+		return false;
+
+	glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, (GLsizei)mWidth, (GLsizei)mHeight, GL_RGBA, GL_UNSIGNED_BYTE, mDataRGBA);
+	return true;
+}
+
 void TextureData::releaseVRAM()
 {
 	std::unique_lock<std::mutex> lock(mMutex);
 	if (mTextureID != 0)
 	{
-		glDeleteTextures(1, &mTextureID);
+		Renderer::deleteTexture(mTextureID);
 		mTextureID = 0;
 	}
+	mReupload = false;
 }
 
 void TextureData::releaseRAM()
@@ -209,6 +456,7 @@ void TextureData::releaseRAM()
 	std::unique_lock<std::mutex> lock(mMutex);
 	delete[] mDataRGBA;
 	mDataRGBA = 0;
+	mCompressionDeferred = false;
 }
 
 size_t TextureData::width()
@@ -255,8 +503,9 @@ void TextureData::setSourceSize(float width, float height)
 
 size_t TextureData::getVRAMUsage()
 {
+	// real sizes of compressed textures and all their mipmaps
 	if ((mTextureID != 0) || (mDataRGBA != nullptr))
-		return mWidth * mHeight * 4;
+		return TextureCompression::getDataSize(mFormat, mWidth, mHeight, mLevels);
 	else
 		return 0;
 }
@@ -2,6 +2,8 @@
 #ifndef ES_CORE_RESOURCES_TEXTURE_DATA_H
 #define ES_CORE_RESOURCES_TEXTURE_DATA_H
 
+#include "resources/TextureCompression.h"
+#include "resources/ThumbnailCache.h"
 #include "platform.h"
 #include GLHEADER
 #include <mutex>
@@ -23,8 +25,15 @@ public:
 	bool initImageFromMemory(const unsigned char* fileData, size_t length);
 	bool initFromRGBA(const unsigned char* dataRGBA, size_t width, size_t height);
 
-	// Read the data into memory if necessary
-	bool load();
+	// Read the data into memory if necessary.
+	// deferCompression keeps the pixels as RGBA for now, so a load on the main thread doesn't block on compressing them.
+	bool load(bool deferCompression = false);
+
+	// True if a load(true) kept pixels as RGBA that are still to be compressed.
+	bool hasDeferredCompression();
+	// Compresses those pixels, meant for the loader threads. If the RGBA pixels were uploaded meanwhile,
+	// the next uploadAndBind() replaces that texture with the compressed one. Returns false if there was nothing to compress.
+	bool compressDeferred();
 
 	bool isLoaded();
 
@@ -32,6 +41,10 @@ public:
 	// false if either not loaded
 	bool uploadAndBind();
 
+	// Copy the loaded pixels into the bound texture at x, y (e.g. a TextureAtlas) instead of a texture of their own.
+	// Returns false if not loaded or compressed.
+	bool uploadSubImage(GLint x, GLint y);
+
 	// Release the texture from VRAM
 	void releaseVRAM();
 
@@ -49,18 +62,43 @@ public:
 
 	bool tiled() { return mTile; }
 
+	// The texture will never be drawn larger than this (in pixels, on either side), so larger images
+	// can be scaled down when they are loaded and served from the ThumbnailCache. 0 keeps the full size.
+	// Only these textures are mipmapped and compressed (see the "MipmapTextures" and "CompressTextures" settings).
+	void setMaxSize(size_t maxSize) { mMaxSize = maxSize; }
+	// Keeps the pixels as RGBA even if "CompressTextures" is on, for uploadSubImage().
+	void setAllowCompression(bool allow) { mAllowCompression = allow; }
+
 private:
+	bool isCacheable();
+	TextureCompression::Format getCompressionFormat();
+
+	bool decodeImageFromMemory(const unsigned char* fileData, size_t length, bool deferCompression);
+
+	// takes ownership of dataRGBA (allocated with new[]), compresses it if enabled and not deferred
+	// saveToCache stores scaled down pixels in the ThumbnailCache, compressed data is always stored
+	bool initFromDecodedRGBA(unsigned char* dataRGBA, size_t width, size_t height, size_t sourceWidth, size_t sourceHeight, bool saveToCache, bool deferCompression);
+	bool initFromCompressed(unsigned char* data, const ThumbnailCache::Info& info, bool compressionDeferred = false, bool saveToCache = false);
+
 	std::mutex		mMutex;
 	bool			mTile;
 	std::string		mPath;
 	GLuint 			mTextureID;
-	unsigned char*	mDataRGBA;
+	unsigned char*	mDataRGBA; // holds the compressed levels instead if mFormat isn't FORMAT_NONE
 	size_t			mWidth;
 	size_t			mHeight;
 	float			mSourceWidth;
 	float			mSourceHeight;
 	bool			mScalable;
 	bool			mReloadable;
+	size_t			mMaxSize;
+	bool			mMipmaps;
+	bool			mAllowCompression;
+	TextureCompression::Format mFormat;
+	unsigned int	mLevels;
+	bool			mCompressionDeferred; // mDataRGBA is RGBA that compressDeferred() is still to compress
+	bool			mDeferredSaveToCache; // and to store in the ThumbnailCache if it stays RGBA
+	bool			mReupload; // mDataRGBA was compressed after mTextureID was uploaded from the RGBA pixels
 };
 
 #endif // ES_CORE_RESOURCES_TEXTURE_DATA_H
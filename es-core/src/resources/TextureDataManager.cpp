@@ -39,6 +39,8 @@ void TextureDataManager::remove(const TextureResource* key)
 	auto it = mTextureLookup.find(key);
 	if (it != mTextureLookup.cend())
 	{
+		// Nothing else will ever ask for this texture, so don't waste a loader thread decoding it
+		mLoader->remove(*(*it).second);
 		// Remove the list entry
 		mTextures.erase((*it).second);
 		// And the lookup
@@ -46,7 +48,7 @@ void TextureDataManager::remove(const TextureResource* key)
 	}
 }
 
-std::shared_ptr<TextureData> TextureDataManager::get(const TextureResource* key)
+std::shared_ptr<TextureData> TextureDataManager::get(const TextureResource* key, TextureLoadPriority priority)
 {
 	// If it's in the cache then we want to remove it from it's current location and
 	// move it to the top
@@ -63,14 +65,14 @@ std::shared_ptr<TextureData> TextureDataManager::get(const TextureResource* key)
 		mTextureLookup[key] = mTextures.cbegin();
 
 		// Make sure it's loaded or queued for loading
-		load(tex);
+		load(tex, false, priority);
 	}
 	return tex;
 }
 
 bool TextureDataManager::bind(const TextureResource* key)
 {
-	std::shared_ptr<TextureData> tex = get(key);
+	std::shared_ptr<TextureData> tex = get(key, LOAD_PRIORITY_VISIBLE);
 	bool bound = false;
 	if (tex != nullptr)
 		bound = tex->uploadAndBind();
@@ -100,11 +102,15 @@ size_t TextureDataManager::getQueueSize()
 	return mLoader->getQueueSize();
 }
 
-void TextureDataManager::load(std::shared_ptr<TextureData> tex, bool block)
+void TextureDataManager::load(std::shared_ptr<TextureData> tex, bool block, TextureLoadPriority priority)
 {
-	// See if it's already loaded
+	// See if it's already loaded, pixels a blocking load kept as RGBA are compressed in the background
 	if (tex->isLoaded())
+	{
+		if (tex->hasDeferredCompression())
+			mLoader->load(tex, LOAD_PRIORITY_BACKGROUND);
 		return;
+	}
 	// Not loaded. Make sure there is room
 	size_t size = TextureResource::getTotalMemUsage();
 	size_t max_texture = (size_t)Settings::getInstance()->getInt("MaxVRAM") * 1024 * 1024;
@@ -122,80 +128,143 @@ void TextureDataManager::load(std::shared_ptr<TextureData> tex, bool block)
 		size = TextureResource::getTotalMemUsage();
 	}
 	if (!block)
-		mLoader->load(tex);
+	{
+		mLoader->load(tex, priority);
+	}
 	else
-		tex->load();
+	{
+		// the caller is waiting, so leave the compression to a loader thread
+		tex->load(true);
+		if (tex->hasDeferredCompression())
+			mLoader->load(tex, LOAD_PRIORITY_BACKGROUND);
+	}
 }
 
-TextureLoader::TextureLoader() : mExit(false)
+TextureLoader::TextureLoader() : mExit(false), mDecodeCount(0), mTotalDecodeLatency(0), mCancelledCount(0), mWastedDecodeCount(0)
 {
-	mThread = new std::thread(&TextureLoader::threadProc, this);
+	// threads are started on the first load, this object is created before the settings are loaded
 }
 
 TextureLoader::~TextureLoader()
 {
-	// Just abort any waiting texture
-	mTextureDataQ.clear();
-	mTextureDataLookup.clear();
+	{
+		// Just abort any waiting texture
+		std::unique_lock<std::mutex> lock(mMutex);
+		for (int i = 0; i < LOAD_PRIORITY_COUNT; ++i)
+			mTextureDataQ[i].clear();
+		mTextureDataLookup.clear();
 
-	// Exit the thread
-	mExit = true;
-	mEvent.notify_one();
-	mThread->join();
-	delete mThread;
+		mExit = true;
+	}
+
+	// Exit the threads
+	mEvent.notify_all();
+	for (auto thread : mThreads)
+	{
+		thread->join();
+		delete thread;
+	}
+}
+
+void TextureLoader::startThreads()
+{
+	// Called with mMutex held
+	int threadCount = Settings::getInstance()->getInt("TextureLoaderThreads");
+	if (threadCount <= 0)
+	{
+		threadCount = (int)std::thread::hardware_concurrency();
+		if (threadCount > 4)
+			threadCount = 4;
+		if (threadCount < 1)
+			threadCount = 1;
+	}
+
+	for (int i = 0; i < threadCount; ++i)
+		mThreads.push_back(new std::thread(&TextureLoader::threadProc, this));
 }
 
 void TextureLoader::threadProc()
 {
+	std::unique_lock<std::mutex> lock(mMutex);
 	while (!mExit)
 	{
-		std::shared_ptr<TextureData> textureData;
+		// Take the most urgent texture in the queue
+		QueueEntry entry;
+		for (int i = 0; i < LOAD_PRIORITY_COUNT; ++i)
 		{
-			// Wait for an event to say there is something in the queue
-			std::unique_lock<std::mutex> lock(mMutex);
-			mEvent.wait(lock);
-			if (!mTextureDataQ.empty())
+			if (!mTextureDataQ[i].empty())
 			{
-				textureData = mTextureDataQ.front();
-				mTextureDataQ.pop_front();
-				mTextureDataLookup.erase(mTextureDataLookup.find(textureData.get()));
+				entry = mTextureDataQ[i].front();
+				mTextureDataQ[i].pop_front();
+				mTextureDataLookup.erase(entry.textureData.get());
+				break;
 			}
 		}
-		// Queue has been released here but we might have a texture to process
-		while (textureData)
+
+		if (!entry.textureData)
 		{
-			textureData->load();
+			// Wait for an event to say there is something in the queue
+			mEvent.wait(lock);
+			continue;
+		}
 
-			// See if there is another item in the queue
-			textureData = nullptr;
-			std::unique_lock<std::mutex> lock(mMutex);
-			if (!mTextureDataQ.empty())
-			{
-				textureData = mTextureDataQ.front();
-				mTextureDataQ.pop_front();
-				mTextureDataLookup.erase(mTextureDataLookup.find(textureData.get()));
-			}
+		// If the queue holds the only reference then its TextureResource has gone away
+		if (entry.textureData.use_count() == 1)
+		{
+			++mCancelledCount;
+			continue;
 		}
+
+		// It may have been loaded by a blocking load() since it was queued, which leaves only the compression to do
+		const bool compressOnly = entry.textureData->isLoaded();
+		if (compressOnly && !entry.textureData->hasDeferredCompression())
+			continue;
+
+		// Decode without holding the queue so the other threads can carry on, load() won't queue it again meanwhile
+		mTextureDataInFlight.insert(entry.textureData.get());
+		lock.unlock();
+		if (compressOnly)
+			entry.textureData->compressDeferred();
+		else
+			entry.textureData->load();
+		const bool wasted = entry.textureData.use_count() == 1;
+		lock.lock();
+		mTextureDataInFlight.erase(entry.textureData.get());
+
+		++mDecodeCount;
+		mTotalDecodeLatency += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - entry.queuedTime).count();
+		if (wasted)
+			++mWastedDecodeCount;
 	}
 }
 
-void TextureLoader::load(std::shared_ptr<TextureData> textureData)
+void TextureLoader::load(std::shared_ptr<TextureData> textureData, TextureLoadPriority priority)
 {
-	// Make sure it's not already loaded
-	if (!textureData->isLoaded())
+	// Make sure it's not already loaded, or loaded but still to be compressed
+	if (!textureData->isLoaded() || textureData->hasDeferredCompression())
 	{
 		std::unique_lock<std::mutex> lock(mMutex);
-		// Remove it from the queue if it is already there
+		if (mThreads.empty())
+			startThreads();
+
+		// Another thread is already decoding it
+		if (mTextureDataInFlight.find(textureData.get()) != mTextureDataInFlight.cend())
+			return;
+
+		// Remove it from the queue if it is already there, it keeps the more urgent of the two priorities
+		QueueEntry entry = { textureData, std::chrono::steady_clock::now() };
 		auto td = mTextureDataLookup.find(textureData.get());
 		if (td != mTextureDataLookup.cend())
 		{
-			mTextureDataQ.erase((*td).second);
-			mTextureDataLookup.erase(td);
+			if ((*td).second.first < priority)
+				priority = (TextureLoadPriority)(*td).second.first;
+			entry.queuedTime = (*(*td).second.second).queuedTime;
+			removeLocked(textureData.get());
 		}
 
 		// Put it on the start of the queue as we want the newly requested textures to load first
-		mTextureDataQ.push_front(textureData);
-		mTextureDataLookup[textureData.get()] = mTextureDataQ.cbegin();
+		mTextureDataQ[priority].push_front(entry);
+		mTextureDataLookup[textureData.get()] = std::make_pair((int)priority, mTextureDataQ[priority].begin());
 		mEvent.notify_one();
 	}
 }
@@ -204,10 +273,19 @@ void TextureLoader::remove(std::shared_ptr<TextureData> textureData)
 {
 	// Just remove it from the queue so we don't attempt to load it
 	std::unique_lock<std::mutex> lock(mMutex);
-	auto td = mTextureDataLookup.find(textureData.get());
+	if (mTextureDataLookup.find(textureData.get()) != mTextureDataLookup.cend())
+	{
+		removeLocked(textureData.get());
+		++mCancelledCount;
+	}
+}
+
+void TextureLoader::removeLocked(TextureData* textureData)
+{
+	auto td = mTextureDataLookup.find(textureData);
 	if (td != mTextureDataLookup.cend())
 	{
-		mTextureDataQ.erase((*td).second);
+		mTextureDataQ[(*td).second.first].erase((*td).second.second);
 		mTextureDataLookup.erase(td);
 	}
 }
@@ -218,9 +296,40 @@ size_t TextureLoader::getQueueSize()
 	// the queue are loaded
 	size_t mem = 0;
 	std::unique_lock<std::mutex> lock(mMutex);
-	for (auto tex : mTextureDataQ)
+	for (int i = 0; i < LOAD_PRIORITY_COUNT; ++i)
 	{
-		mem += tex->width() * tex->height() * 4;
+		for (auto& entry : mTextureDataQ[i])
+			mem += entry.textureData->width() * entry.textureData->height() * 4;
 	}
 	return mem;
 }
+
+size_t TextureLoader::getQueueLength()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	return mTextureDataLookup.size();
+}
+
+size_t TextureLoader::getDecodeCount()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	return mDecodeCount;
+}
+
+float TextureLoader::getAverageDecodeLatency()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	return mDecodeCount > 0 ? (float)(mTotalDecodeLatency / mDecodeCount) : 0.0f;
+}
+
+size_t TextureLoader::getCancelledCount()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	return mCancelledCount;
+}
+
+size_t TextureLoader::getWastedDecodeCount()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	return mWastedDecodeCount;
+}
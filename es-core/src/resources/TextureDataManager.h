@@ -2,38 +2,75 @@
 #ifndef ES_CORE_RESOURCES_TEXTURE_DATA_MANAGER_H
 #define ES_CORE_RESOURCES_TEXTURE_DATA_MANAGER_H
 
+#include <chrono>
 #include <condition_variable>
 #include <list>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <set>
 #include <thread>
+#include <vector>
 
 class TextureData;
 class TextureResource;
 
+// Order in which queued textures are decoded. Within a priority the most recent request goes first.
+enum TextureLoadPriority
+{
+	LOAD_PRIORITY_VISIBLE,    // being drawn right now
+	LOAD_PRIORITY_PREFETCH,   // just created, likely to be drawn soon
+	LOAD_PRIORITY_BACKGROUND, // anything else
+
+	LOAD_PRIORITY_COUNT
+};
+
 class TextureLoader
 {
 public:
 	TextureLoader();
 	~TextureLoader();
 
-	void load(std::shared_ptr<TextureData> textureData);
+	void load(std::shared_ptr<TextureData> textureData, TextureLoadPriority priority);
 	void remove(std::shared_ptr<TextureData> textureData);
 
+	// Amount of VRAM the queued textures will use once loaded, in bytes
 	size_t getQueueSize();
+	// Number of textures waiting to be decoded
+	size_t getQueueLength();
+
+	// Statistics since startup
+	size_t getDecodeCount();
+	float getAverageDecodeLatency(); // milliseconds from being queued to being decoded
+	size_t getCancelledCount(); // dropped from the queue because nothing referenced them anymore
+	size_t getWastedDecodeCount(); // decoded after everything referencing them had gone
 
 private:
-	void processQueue();
+	struct QueueEntry
+	{
+		std::shared_ptr<TextureData> textureData;
+		std::chrono::steady_clock::time_point queuedTime;
+	};
+
+	typedef std::list<QueueEntry> Queue;
+
+	void startThreads();
 	void threadProc();
+	void removeLocked(TextureData* textureData);
 
-	std::list<std::shared_ptr<TextureData> > 										mTextureDataQ;
-	std::map<TextureData*, std::list<std::shared_ptr<TextureData> >::const_iterator > 	mTextureDataLookup;
+	Queue 												mTextureDataQ[LOAD_PRIORITY_COUNT];
+	std::map<TextureData*, std::pair<int, Queue::iterator> > 	mTextureDataLookup;
+	std::set<TextureData*>										mTextureDataInFlight; // being decoded by a thread right now
 
-	std::thread*				mThread;
+	std::vector<std::thread*>	mThreads;
 	std::mutex					mMutex;
 	std::condition_variable		mEvent;
 	bool 						mExit;
+
+	size_t						mDecodeCount;
+	double						mTotalDecodeLatency;
+	size_t						mCancelledCount;
+	size_t						mWastedDecodeCount;
 };
 
 //
@@ -63,7 +100,7 @@ public:
 	// will be deleted when the other thread has finished with it
 	void remove(const TextureResource* key);
 
-	std::shared_ptr<TextureData> get(const TextureResource* key);
+	std::shared_ptr<TextureData> get(const TextureResource* key, TextureLoadPriority priority = LOAD_PRIORITY_BACKGROUND);
 	bool bind(const TextureResource* key);
 
 	// Get the total size of all textures managed by this object, loaded and unloaded in bytes
@@ -74,7 +111,9 @@ public:
 	// be committed to VRAM as the queue is processed
 	size_t  getQueueSize();
 	// Load a texture, freeing resources as necessary to make space
-	void load(std::shared_ptr<TextureData> tex, bool block = false);
+	void load(std::shared_ptr<TextureData> tex, bool block = false, TextureLoadPriority priority = LOAD_PRIORITY_BACKGROUND);
+
+	inline TextureLoader* getLoader() { return mLoader; }
 
 private:
 
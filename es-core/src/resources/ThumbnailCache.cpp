@@ -0,0 +1,250 @@
+#include "resources/ThumbnailCache.h"
+
+#include "Log.h"
+#include "platform.h"
+#include "Settings.h"
+#include <boost/filesystem/operations.hpp>
+#include <stdint.h>
+#include <string.h>
+#include <ctime>
+#include <fstream>
+
+// bump this whenever the layout below changes, old entries are then simply missed and evicted over time
+#define THUMBNAIL_CACHE_MAGIC   "ESTC"
+#define THUMBNAIL_CACHE_VERSION 3
+
+// entry layout (native endianness):
+//   magic[4], version, width, height, source width, source height, max size, requested format, format, levels,
+//   data size, source time, source path length, source path, then the data (RGBA or compressed blocks)
+struct ThumbnailHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t width;
+	uint32_t height;
+	float sourceWidth;
+	float sourceHeight;
+	uint32_t maxSize;
+	uint32_t requestedFormat;
+	uint32_t format;
+	uint32_t levels;
+	uint64_t dataSize;
+	int64_t sourceTime;
+	uint32_t pathLength;
+};
+
+ThumbnailCache* ThumbnailCache::getInstance()
+{
+	static ThumbnailCache* sInstance = new ThumbnailCache();
+	return sInstance;
+}
+
+ThumbnailCache::ThumbnailCache() : mIndex(getHomePath() + "/.emulationstation/cache/textures", ".raw"), mHitCount(0), mMissCount(0)
+{
+}
+
+bool ThumbnailCache::isEnabled()
+{
+	return Settings::getInstance()->getInt("ThumbnailCacheSize") > 0;
+}
+
+size_t ThumbnailCache::getMaxTotalSize()
+{
+	return (size_t)Settings::getInstance()->getInt("ThumbnailCacheSize") * 1024 * 1024;
+}
+
+std::string ThumbnailCache::getEntryName(const std::string& path, time_t sourceTime, size_t maxSize, unsigned int format)
+{
+	// the header repeats the full key, so a hash collision is only a miss
+	char name[64];
+	snprintf(name, sizeof(name), "%016llx.raw", (unsigned long long)std::hash<std::string>()(path + "|" + std::to_string((long long)sourceTime) + "|" + std::to_string(maxSize) + "|" + std::to_string(format)));
+	return name;
+}
+
+unsigned char* ThumbnailCache::load(const std::string& path, size_t maxSize, unsigned int format, Info& info)
+{
+	boost::system::error_code ec;
+	const time_t sourceTime = boost::filesystem::last_write_time(path, ec);
+	if(ec)
+		return nullptr;
+
+	return loadEntry(path, sourceTime, maxSize, format, info);
+}
+
+unsigned char* ThumbnailCache::loadRaster(const std::string& key, Info& info)
+{
+	return loadEntry(key, 0, 0, 0, info);
+}
+
+unsigned char* ThumbnailCache::loadEntry(const std::string& path, time_t sourceTime, size_t maxSize, unsigned int format, Info& info)
+{
+	const std::string name = getEntryName(path, sourceTime, maxSize, format);
+	const std::string entryPath = mIndex.getPath(name);
+
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mIndex.scan(getMaxTotalSize());
+
+		if(!mIndex.contains(name))
+		{
+			mMissCount++;
+			return nullptr;
+		}
+
+		mIndex.touch(name);
+	}
+
+	// an entry evicted or replaced meanwhile simply fails to open or to match below
+	std::ifstream file(entryPath.c_str(), std::ios::in | std::ios::binary);
+
+	ThumbnailHeader header;
+	std::string headerPath;
+	if(file.read((char*)&header, sizeof(header)))
+	{
+		headerPath.resize(header.pathLength);
+		file.read(&headerPath[0], header.pathLength);
+	}
+
+	unsigned char* data = nullptr;
+	if(file && memcmp(header.magic, THUMBNAIL_CACHE_MAGIC, 4) == 0 && header.version == THUMBNAIL_CACHE_VERSION &&
+		header.maxSize == maxSize && header.requestedFormat == format && header.sourceTime == (int64_t)sourceTime && headerPath == path)
+	{
+		data = new unsigned char[(size_t)header.dataSize];
+		if(!file.read((char*)data, (size_t)header.dataSize))
+		{
+			LOG(LogWarning) << "Thumbnail cache entry \"" << entryPath << "\" is truncated";
+			delete[] data;
+			data = nullptr;
+		}
+	}
+	file.close();
+
+	if(!data)
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mMissCount++;
+		return nullptr;
+	}
+
+	info.width = header.width;
+	info.height = header.height;
+	info.sourceWidth = header.sourceWidth;
+	info.sourceHeight = header.sourceHeight;
+	info.format = header.format;
+	info.levels = header.levels;
+	info.dataSize = (size_t)header.dataSize;
+
+	// remember the use on disk as well, so the LRU order survives a restart
+	mIndex.markUsedOnDisk(name);
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	mHitCount++;
+	return data;
+}
+
+void ThumbnailCache::save(const std::string& path, size_t maxSize, unsigned int format, const unsigned char* data, const Info& info)
+{
+	boost::system::error_code ec;
+	const time_t sourceTime = boost::filesystem::last_write_time(path, ec);
+	if(ec)
+		return;
+
+	saveEntry(path, sourceTime, maxSize, format, data, info);
+}
+
+void ThumbnailCache::saveRaster(const std::string& key, const unsigned char* data, const Info& info)
+{
+	saveEntry(key, 0, 0, 0, data, info);
+}
+
+void ThumbnailCache::saveEntry(const std::string& path, time_t sourceTime, size_t maxSize, unsigned int format, const unsigned char* data, const Info& info)
+{
+	boost::system::error_code ec;
+	const std::string name = getEntryName(path, sourceTime, maxSize, format);
+	const size_t bytes = info.dataSize;
+
+	ThumbnailHeader header;
+	memcpy(header.magic, THUMBNAIL_CACHE_MAGIC, 4);
+	header.version = THUMBNAIL_CACHE_VERSION;
+	header.width = (uint32_t)info.width;
+	header.height = (uint32_t)info.height;
+	header.sourceWidth = info.sourceWidth;
+	header.sourceHeight = info.sourceHeight;
+	header.maxSize = (uint32_t)maxSize;
+	header.requestedFormat = format;
+	header.format = info.format;
+	header.levels = info.levels;
+	header.dataSize = (uint64_t)bytes;
+	header.sourceTime = (int64_t)sourceTime;
+	header.pathLength = (uint32_t)path.size();
+
+	const size_t entrySize = sizeof(header) + path.size() + bytes;
+	const std::string entryPath = mIndex.getPath(name);
+	const std::string tempPath = entryPath + ".tmp";
+
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		const size_t maxTotalSize = getMaxTotalSize();
+		mIndex.scan(maxTotalSize);
+
+		// fails if another thread is writing the same entry already, a previous entry stays until the new file replaces it
+		if(!mIndex.beginWrite(name, entrySize, maxTotalSize))
+			return;
+	}
+
+	// write through a temporary file so a partially written entry is never picked up
+	boost::filesystem::create_directories(mIndex.getDirectory(), ec);
+
+	bool written = false;
+	std::ofstream file(tempPath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if(file.is_open())
+	{
+		file.write((const char*)&header, sizeof(header));
+		file.write(path.data(), path.size());
+		file.write((const char*)data, bytes);
+		file.close();
+
+		if(file.fail())
+		{
+			LOG(LogWarning) << "Error writing thumbnail cache entry \"" << tempPath << "\"";
+		}else{
+			boost::filesystem::rename(tempPath, entryPath, ec);
+			if(ec)
+				LOG(LogWarning) << "Error writing thumbnail cache entry \"" << entryPath << "\": " << ec.message();
+			else
+				written = true;
+		}
+
+		if(!written)
+			boost::filesystem::remove(tempPath, ec);
+	}else{
+		LOG(LogWarning) << "Could not open \"" << tempPath << "\" for writing";
+	}
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	mIndex.endWrite(name, written);
+}
+
+size_t ThumbnailCache::getHitCount()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	return mHitCount;
+}
+
+size_t ThumbnailCache::getMissCount()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	return mMissCount;
+}
+
+size_t ThumbnailCache::getEvictionCount()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	return mIndex.getEvictionCount();
+}
+
+size_t ThumbnailCache::getTotalSize()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	return mIndex.getTotalSize();
+}
@@ -0,0 +1,63 @@
+#pragma once
+#ifndef ES_CORE_RESOURCES_THUMBNAIL_CACHE_H
+#define ES_CORE_RESOURCES_THUMBNAIL_CACHE_H
+
+#include "utils/DiskCacheIndex.h"
+#include <mutex>
+#include <string>
+
+// Disk cache of downscaled, already decoded images in ~/.emulationstation/cache/textures.
+// Entries are keyed by source path, source modification time, the maximum size they were scaled to and the
+// TextureCompression::Format they were requested in, and are stored as raw RGBA (or raw compressed blocks)
+// so a hit skips the PNG/JPEG decode, and the compression, entirely.
+// Rasterized SVGs are stored here as well, under a key describing their content and size (see SVGRasterCache).
+// The cache is kept below the "ThumbnailCacheSize" setting (in MB) by evicting the least recently used entries.
+// The entry files are read and written without holding the cache's lock, so the texture loader threads don't queue up on disk I/O.
+class ThumbnailCache
+{
+public:
+	static ThumbnailCache* getInstance();
+
+	struct Info
+	{
+		size_t width;
+		size_t height;
+		float sourceWidth; // SVGs can have fractional sizes
+		float sourceHeight;
+		unsigned int format; // what the data actually is, may differ from the format it was requested in
+		unsigned int levels; // mipmap levels stored one after the other
+		size_t dataSize;
+	};
+
+	// Returns the cached data (allocated with new[], owned by the caller) or nullptr on a miss.
+	unsigned char* load(const std::string& path, size_t maxSize, unsigned int format, Info& info);
+	void save(const std::string& path, size_t maxSize, unsigned int format, const unsigned char* data, const Info& info);
+
+	// Entries that don't belong to a file on disk, key must fully describe the data.
+	unsigned char* loadRaster(const std::string& key, Info& info);
+	void saveRaster(const std::string& key, const unsigned char* data, const Info& info);
+
+	bool isEnabled();
+
+	size_t getHitCount();
+	size_t getMissCount();
+	size_t getEvictionCount();
+	size_t getTotalSize(); // bytes on disk
+
+private:
+	ThumbnailCache();
+
+	unsigned char* loadEntry(const std::string& path, time_t sourceTime, size_t maxSize, unsigned int format, Info& info);
+	void saveEntry(const std::string& path, time_t sourceTime, size_t maxSize, unsigned int format, const unsigned char* data, const Info& info);
+
+	std::string getEntryName(const std::string& path, time_t sourceTime, size_t maxSize, unsigned int format);
+	size_t getMaxTotalSize();
+
+	std::mutex mMutex;
+	DiskCacheIndex mIndex;
+
+	size_t mHitCount;
+	size_t mMissCount;
+};
+
+#endif // ES_CORE_RESOURCES_THUMBNAIL_CACHE_H
@@ -0,0 +1,130 @@
+#include "resources/VideoInfoCache.h"
+
+#include "Log.h"
+#include "platform.h"
+#include <boost/filesystem/operations.hpp>
+#include <fstream>
+#include <sstream>
+
+// one entry per line: source time, width, height, path
+// entries are only ever appended, the last line for a path wins
+
+VideoInfoCache* VideoInfoCache::getInstance()
+{
+	static VideoInfoCache* sInstance = new VideoInfoCache();
+	return sInstance;
+}
+
+VideoInfoCache::VideoInfoCache() : mLoaded(false), mHitCount(0), mMissCount(0)
+{
+	mCachePath = getHomePath() + "/.emulationstation/cache/videos.txt";
+}
+
+bool VideoInfoCache::get(const std::string& path, unsigned int& width, unsigned int& height)
+{
+	boost::system::error_code ec;
+	const time_t sourceTime = boost::filesystem::last_write_time(path, ec);
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	loadLocked();
+
+	auto it = mEntries.find(path);
+	if(ec || it == mEntries.cend() || it->second.sourceTime != sourceTime)
+	{
+		mMissCount++;
+		return false;
+	}
+
+	width = it->second.width;
+	height = it->second.height;
+	mHitCount++;
+	return true;
+}
+
+void VideoInfoCache::put(const std::string& path, unsigned int width, unsigned int height)
+{
+	boost::system::error_code ec;
+	const time_t sourceTime = boost::filesystem::last_write_time(path, ec);
+	if(ec || path.find('\n') != std::string::npos)
+		return;
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	loadLocked();
+
+	Entry& entry = mEntries[path];
+	entry.sourceTime = sourceTime;
+	entry.width = width;
+	entry.height = height;
+
+	boost::filesystem::create_directories(boost::filesystem::path(mCachePath).parent_path(), ec);
+	std::ofstream file(mCachePath.c_str(), std::ios::out | std::ios::app);
+	file << (long long)sourceTime << " " << width << " " << height << " " << path << "\n";
+}
+
+void VideoInfoCache::loadLocked()
+{
+	if(mLoaded)
+		return;
+
+	mLoaded = true;
+
+	std::ifstream file(mCachePath.c_str());
+	if(!file.is_open())
+		return;
+
+	size_t lineCount = 0;
+	std::string line;
+	while(std::getline(file, line))
+	{
+		std::istringstream stream(line);
+		long long sourceTime;
+		Entry entry;
+		std::string path;
+		if(!(stream >> sourceTime >> entry.width >> entry.height) || stream.get() != ' ' || !std::getline(stream, path) || path.empty())
+			continue;
+
+		entry.sourceTime = (time_t)sourceTime;
+		mEntries[path] = entry;
+		lineCount++;
+	}
+	file.close();
+
+	// videos that were replaced leave their old lines behind, drop them once they make up most of the file
+	if(lineCount > mEntries.size() * 2 + 64)
+		writeLocked();
+}
+
+void VideoInfoCache::writeLocked()
+{
+	const std::string tempPath = mCachePath + ".tmp";
+	std::ofstream file(tempPath.c_str(), std::ios::out | std::ios::trunc);
+	if(!file.is_open())
+		return;
+
+	for(auto it = mEntries.cbegin(); it != mEntries.cend(); it++)
+		file << (long long)it->second.sourceTime << " " << it->second.width << " " << it->second.height << " " << it->first << "\n";
+	file.close();
+
+	boost::system::error_code ec;
+	if(file.fail())
+	{
+		boost::filesystem::remove(tempPath, ec);
+		return;
+	}
+
+	boost::filesystem::rename(tempPath, mCachePath, ec);
+	if(ec)
+		LOG(LogWarning) << "Error writing video info cache \"" << mCachePath << "\": " << ec.message();
+}
+
+size_t VideoInfoCache::getHitCount()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	return mHitCount;
+}
+
+size_t VideoInfoCache::getMissCount()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	return mMissCount;
+}
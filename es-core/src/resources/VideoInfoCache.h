@@ -0,0 +1,48 @@
+#pragma once
+#ifndef ES_CORE_RESOURCES_VIDEO_INFO_CACHE_H
+#define ES_CORE_RESOURCES_VIDEO_INFO_CACHE_H
+
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <string>
+
+// Dimensions of video files, keyed by path and modification time, so a video that has been played before
+// starts without libVLC parsing it again.
+// Entries are kept in memory and appended to ~/.emulationstation/cache/videos.txt, which is read on first use.
+// The file is touched by the caller's thread, so only use this from a background thread.
+class VideoInfoCache
+{
+public:
+	static VideoInfoCache* getInstance();
+
+	// Returns false on a miss, or if the file changed since its entry was stored.
+	bool get(const std::string& path, unsigned int& width, unsigned int& height);
+	void put(const std::string& path, unsigned int width, unsigned int height);
+
+	size_t getHitCount();
+	size_t getMissCount();
+
+private:
+	VideoInfoCache();
+
+	struct Entry
+	{
+		time_t sourceTime;
+		unsigned int width;
+		unsigned int height;
+	};
+
+	void loadLocked();
+	void writeLocked();
+
+	std::mutex mMutex;
+	std::string mCachePath;
+	bool mLoaded;
+	std::map<std::string, Entry> mEntries;
+
+	size_t mHitCount;
+	size_t mMissCount;
+};
+
+#endif // ES_CORE_RESOURCES_VIDEO_INFO_CACHE_H
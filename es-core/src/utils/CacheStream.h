@@ -0,0 +1,71 @@
+#pragma once
+#ifndef ES_CORE_UTILS_CACHE_STREAM_H
+#define ES_CORE_UTILS_CACHE_STREAM_H
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+
+// Helpers for the binary caches in ~/.emulationstation/cache/.
+// Values are stored in native endianness, the caches are never shared between machines.
+
+class CacheWriter
+{
+public:
+	void writeU8(uint8_t value) { mBuffer.append((const char*)&value, sizeof(value)); }
+	void writeU32(uint32_t value) { mBuffer.append((const char*)&value, sizeof(value)); }
+	void writeI64(int64_t value) { mBuffer.append((const char*)&value, sizeof(value)); }
+	void writeFloat(float value) { mBuffer.append((const char*)&value, sizeof(value)); }
+	void writeString(const std::string& value) { writeU32((uint32_t)value.size()); mBuffer.append(value); }
+
+	const std::string& getBuffer() const { return mBuffer; }
+
+private:
+	std::string mBuffer;
+};
+
+// Reading past the end, or a string longer than what's left, sets ok() to false and returns empty values from then on.
+class CacheReader
+{
+public:
+	CacheReader(const std::string& buffer) : mCursor(buffer.data()), mEnd(buffer.data() + buffer.size()), mOk(true) {}
+
+	uint8_t readU8() { uint8_t value = 0; read(&value, sizeof(value)); return value; }
+	uint32_t readU32() { uint32_t value = 0; read(&value, sizeof(value)); return value; }
+	int64_t readI64() { int64_t value = 0; read(&value, sizeof(value)); return value; }
+	float readFloat() { float value = 0.0f; read(&value, sizeof(value)); return value; }
+	std::string readString()
+	{
+		uint32_t size = readU32();
+		if(!mOk || (size_t)(mEnd - mCursor) < size)
+		{
+			mOk = false;
+			return "";
+		}
+
+		std::string value(mCursor, size);
+		mCursor += size;
+		return value;
+	}
+
+	inline bool ok() const { return mOk; }
+
+private:
+	void read(void* out, size_t size)
+	{
+		if(!mOk || (size_t)(mEnd - mCursor) < size)
+		{
+			mOk = false;
+			return;
+		}
+
+		memcpy(out, mCursor, size);
+		mCursor += size;
+	}
+
+	const char* mCursor;
+	const char* mEnd;
+	bool mOk;
+};
+
+#endif // ES_CORE_UTILS_CACHE_STREAM_H
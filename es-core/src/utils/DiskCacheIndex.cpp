@@ -0,0 +1,144 @@
+#include "utils/DiskCacheIndex.h"
+
+#include <boost/filesystem/operations.hpp>
+#include <algorithm>
+#include <ctime>
+#include <vector>
+
+DiskCacheIndex::DiskCacheIndex(const std::string& directory, const std::string& extension)
+	: mDirectory(directory), mExtension(extension), mScanned(false), mTotalSize(0), mEvictionCount(0)
+{
+}
+
+void DiskCacheIndex::scan(size_t maxTotalSize)
+{
+	if(mScanned)
+		return;
+
+	mScanned = true;
+
+	boost::system::error_code ec;
+	if(!boost::filesystem::is_directory(mDirectory, ec))
+		return;
+
+	std::vector< std::pair<std::time_t, std::string> > scanned;
+	std::map<std::string, size_t> sizes;
+	for(boost::filesystem::directory_iterator it(mDirectory, ec), end; it != end; it.increment(ec))
+	{
+		const std::string name = it->path().filename().string();
+		if(it->path().extension() != mExtension)
+		{
+			// left behind by an interrupted write
+			if(it->path().extension() == ".tmp")
+				boost::filesystem::remove(it->path(), ec);
+			continue;
+		}
+
+		scanned.push_back(std::make_pair(boost::filesystem::last_write_time(it->path(), ec), name));
+		sizes[name] = (size_t)boost::filesystem::file_size(it->path(), ec);
+	}
+
+	// the file times are the last uses, see markUsedOnDisk()
+	std::sort(scanned.begin(), scanned.end());
+	for(auto it = scanned.cbegin(); it != scanned.cend(); ++it)
+	{
+		mLRU.push_back(it->second);
+		Entry entry = { sizes[it->second], 0, true, --mLRU.end() };
+		mEntries[it->second] = entry;
+		mTotalSize += entry.size;
+	}
+
+	evict(maxTotalSize);
+}
+
+bool DiskCacheIndex::contains(const std::string& name) const
+{
+	auto it = mEntries.find(name);
+	return it != mEntries.cend() && it->second.hasFile;
+}
+
+void DiskCacheIndex::touch(const std::string& name)
+{
+	// most recently used goes last
+	auto it = mEntries.find(name);
+	if(it != mEntries.cend())
+		mLRU.splice(mLRU.end(), mLRU, it->second.lru);
+}
+
+void DiskCacheIndex::markUsedOnDisk(const std::string& name) const
+{
+	boost::system::error_code ec;
+	boost::filesystem::last_write_time(getPath(name), std::time(NULL), ec);
+}
+
+bool DiskCacheIndex::beginWrite(const std::string& name, size_t size, size_t maxTotalSize)
+{
+	if(size > maxTotalSize)
+		return false;
+
+	auto it = mEntries.find(name);
+	if(it != mEntries.cend() && it->second.writeSize > 0)
+		return false;
+
+	// make room first, the new file counts against the limit too
+	evict(maxTotalSize - size);
+
+	if(it == mEntries.cend())
+	{
+		mLRU.push_back(name);
+		Entry entry = { 0, size, false, --mLRU.end() };
+		mEntries[name] = entry;
+	}else{
+		it->second.writeSize = size;
+	}
+
+	mTotalSize += size;
+	return true;
+}
+
+void DiskCacheIndex::endWrite(const std::string& name, bool written)
+{
+	// entries being written are never evicted, so it's still there
+	auto it = mEntries.find(name);
+	Entry& entry = it->second;
+
+	if(written)
+	{
+		// the new file replaced any previous one
+		mTotalSize -= entry.size;
+		entry.size = entry.writeSize;
+		entry.hasFile = true;
+		mLRU.splice(mLRU.end(), mLRU, entry.lru);
+	}else{
+		mTotalSize -= entry.writeSize;
+	}
+
+	entry.writeSize = 0;
+	if(!entry.hasFile)
+		remove(it);
+}
+
+void DiskCacheIndex::evict(size_t maxTotalSize)
+{
+	boost::system::error_code ec;
+	auto next = mLRU.begin();
+	while(mTotalSize > maxTotalSize && next != mLRU.end())
+	{
+		// entries being written are left to their writer
+		auto oldest = mEntries.find(*next++);
+		if(oldest->second.writeSize > 0)
+			continue;
+
+		// removing a file is cheap next to reading or writing one, and doing it here keeps a new file of the same name safe
+		boost::filesystem::remove(getPath(oldest->first), ec);
+		remove(oldest);
+		mEvictionCount++;
+	}
+}
+
+void DiskCacheIndex::remove(std::map<std::string, Entry>::iterator it)
+{
+	mTotalSize -= it->second.size;
+	mLRU.erase(it->second.lru);
+	mEntries.erase(it);
+}
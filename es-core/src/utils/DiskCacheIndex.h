@@ -0,0 +1,64 @@
+#pragma once
+#ifndef ES_CORE_UTILS_DISK_CACHE_INDEX_H
+#define ES_CORE_UTILS_DISK_CACHE_INDEX_H
+
+#include <list>
+#include <map>
+#include <string>
+
+// The bookkeeping of a cache directory in ~/.emulationstation/cache/ holding one file per entry, kept below a
+// size limit by evicting the least recently used entries. The file times are the last uses, so the order survives a restart.
+// Not thread-safe, callers hold their own lock. Entry files are listed, timed and removed here, but never read or written.
+class DiskCacheIndex
+{
+public:
+	// extension includes the dot, e.g. ".bin"
+	DiskCacheIndex(const std::string& directory, const std::string& extension);
+
+	// Lists the directory the first time it's called and evicts down to maxTotalSize (the limit may have been lowered since the last run).
+	// Files left behind by interrupted writes are removed.
+	void scan(size_t maxTotalSize);
+
+	// True if name has a complete file, even while a new one is being written for it.
+	bool contains(const std::string& name) const;
+
+	// Makes name the most recently used entry. Only the order in memory, see markUsedOnDisk().
+	void touch(const std::string& name);
+	// Sets the file time of name to now. Only touches the file, so it may be called without the caller's lock.
+	void markUsedOnDisk(const std::string& name) const;
+
+	// Reserves size bytes for a new file for name, evicting older entries to make room.
+	// Returns false if the file can't fit at all, or another write of name is in progress.
+	// An existing file of the same name stays listed until endWrite(), so a failed write leaves it accounted for.
+	bool beginWrite(const std::string& name, size_t size, size_t maxTotalSize);
+	// Ends the write started by beginWrite(), written tells whether the new file was renamed into place.
+	void endWrite(const std::string& name, bool written);
+
+	void evict(size_t maxTotalSize);
+
+	inline const std::string& getDirectory() const { return mDirectory; }
+	inline std::string getPath(const std::string& name) const { return mDirectory + "/" + name; }
+	inline size_t getTotalSize() const { return mTotalSize; }
+	inline size_t getEvictionCount() const { return mEvictionCount; }
+
+private:
+	struct Entry
+	{
+		size_t size; // of the complete file, 0 while the first one is still being written
+		size_t writeSize; // reserved by beginWrite(), 0 when no write is in progress
+		bool hasFile;
+		std::list<std::string>::iterator lru;
+	};
+
+	void remove(std::map<std::string, Entry>::iterator it);
+
+	std::string mDirectory;
+	std::string mExtension;
+	bool mScanned;
+	std::map<std::string, Entry> mEntries;
+	std::list<std::string> mLRU; // entry names, least recently used first
+	size_t mTotalSize; // complete files and writes in progress
+	size_t mEvictionCount;
+};
+
+#endif // ES_CORE_UTILS_DISK_CACHE_INDEX_H
@@ -0,0 +1,168 @@
+// Checks HttpReq's per-host throttling against a local stand-in server:
+// the connection cap is kept per host, requests to one host are spaced by the request rate,
+// and failed requests give their slot back.
+
+#include "HttpReq.h"
+#include "HttpStandIn.h"
+#include "Log.h"
+#include "platform.h"
+#include "Settings.h"
+#include <boost/filesystem/operations.hpp>
+#include <stdio.h>
+#include <stdlib.h>
+#include <memory>
+
+static int sFailures = 0;
+
+#define CHECK(condition) \
+	if(!(condition)) \
+	{ \
+		fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+		sFailures++; \
+	}
+
+// polls every request until none is in progress, false on timeout
+static bool runAll(std::vector< std::unique_ptr<HttpReq> >& requests)
+{
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+	while(std::chrono::steady_clock::now() < deadline)
+	{
+		bool busy = false;
+		for(auto it = requests.begin(); it != requests.end(); it++)
+		{
+			if((*it)->status() == HttpReq::REQ_IN_PROGRESS)
+				busy = true;
+		}
+
+		if(!busy)
+			return true;
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	return false;
+}
+
+static void testHostConnectionLimit()
+{
+	Settings::getInstance()->setInt("HttpMaxHostConnections", 2);
+	Settings::getInstance()->setInt("HttpMaxHostRequestRate", 0);
+
+	HttpStandIn server([](const std::string& host, const std::string& path) { return HttpStandIn::Response(200, host + path, 100); });
+	CHECK(server.isListening());
+
+	// "localhost" and "127.0.0.1" reach the same server, but are two hosts as far as HttpReq is concerned
+	const std::string hosts[2] = { server.getHost(), "localhost:" + std::to_string(server.getPort()) };
+	std::vector< std::unique_ptr<HttpReq> > requests;
+	for(int i = 0; i < 12; i++)
+		requests.push_back(std::unique_ptr<HttpReq>(new HttpReq("http://" + hosts[i % 2] + "/game" + std::to_string(i))));
+
+	CHECK(runAll(requests));
+	for(size_t i = 0; i < requests.size(); i++)
+	{
+		CHECK(requests[i]->status() == HttpReq::REQ_SUCCESS);
+		if(requests[i]->status() == HttpReq::REQ_SUCCESS)
+			CHECK(requests[i]->getContent() == hosts[i % 2] + "/game" + std::to_string(i));
+	}
+
+	CHECK(server.getRequestCount(hosts[0]) == 6);
+	CHECK(server.getRequestCount(hosts[1]) == 6);
+	CHECK(server.getMaxConcurrent(hosts[0]) == 2);
+	CHECK(server.getMaxConcurrent(hosts[1]) == 2);
+
+	// one host being at its cap doesn't hold back the other
+	CHECK(server.getMaxConcurrent("") > 2);
+}
+
+static void testHostRequestRate()
+{
+	Settings::getInstance()->setInt("HttpMaxHostConnections", 0);
+	Settings::getInstance()->setInt("HttpMaxHostRequestRate", 10);
+
+	HttpStandIn server([](const std::string& host, const std::string& path) { return HttpStandIn::Response(200, path); });
+	CHECK(server.isListening());
+
+	std::vector< std::unique_ptr<HttpReq> > requests;
+	for(int i = 0; i < 6; i++)
+		requests.push_back(std::unique_ptr<HttpReq>(new HttpReq("http://" + server.getHost() + "/game" + std::to_string(i))));
+
+	CHECK(runAll(requests));
+	for(size_t i = 0; i < requests.size(); i++)
+		CHECK(requests[i]->status() == HttpReq::REQ_SUCCESS);
+
+	// 10 per second starts one every 100ms, leave a little room for the connection setup
+	std::vector<std::chrono::steady_clock::time_point> arrivals = server.getArrivalTimes(server.getHost());
+	CHECK(arrivals.size() == 6);
+	for(size_t i = 1; i < arrivals.size(); i++)
+		CHECK(std::chrono::duration_cast<std::chrono::milliseconds>(arrivals[i] - arrivals[i - 1]).count() >= 90);
+}
+
+static void testErrorsReleaseConnections()
+{
+	Settings::getInstance()->setInt("HttpMaxHostConnections", 1);
+	Settings::getInstance()->setInt("HttpMaxHostRequestRate", 0);
+
+	// "/drop" closes the connection without an answer, "/missing" answers 404
+	HttpStandIn server([](const std::string& host, const std::string& path)
+	{
+		if(path == "/drop")
+			return HttpStandIn::Response(0);
+		if(path == "/missing")
+			return HttpStandIn::Response(404, "not found");
+		return HttpStandIn::Response(200, "ok");
+	});
+	CHECK(server.isListening());
+
+	std::vector< std::unique_ptr<HttpReq> > requests;
+	requests.push_back(std::unique_ptr<HttpReq>(new HttpReq("http://" + server.getHost() + "/drop")));
+	requests.push_back(std::unique_ptr<HttpReq>(new HttpReq("http://" + server.getHost() + "/drop")));
+	requests.push_back(std::unique_ptr<HttpReq>(new HttpReq("http://" + server.getHost() + "/missing")));
+	requests.push_back(std::unique_ptr<HttpReq>(new HttpReq("http://" + server.getHost() + "/game")));
+
+	// with a single connection every later request only runs if the failed ones gave theirs back
+	CHECK(runAll(requests));
+	CHECK(requests[0]->status() == HttpReq::REQ_IO_ERROR);
+	CHECK(requests[1]->status() == HttpReq::REQ_IO_ERROR);
+	CHECK(requests[2]->status() == HttpReq::REQ_SUCCESS); // error pages are passed on, the caller decides
+	CHECK(requests[3]->status() == HttpReq::REQ_SUCCESS);
+	if(requests[3]->status() == HttpReq::REQ_SUCCESS)
+		CHECK(requests[3]->getContent() == "ok");
+	CHECK(server.getMaxConcurrent(server.getHost()) == 1);
+
+	// a request that is dropped while still waiting for a connection doesn't keep one either
+	{
+		HttpReq waiting("http://" + server.getHost() + "/game");
+		HttpReq queued("http://" + server.getHost() + "/game");
+	}
+	requests.clear();
+	requests.push_back(std::unique_ptr<HttpReq>(new HttpReq("http://" + server.getHost() + "/game")));
+	CHECK(runAll(requests));
+	CHECK(requests[0]->status() == HttpReq::REQ_SUCCESS);
+}
+
+int main(int argc, char* argv[])
+{
+	// keep the settings and log away from the real ones, getHomePath() looks at $PWD first
+	char home[] = "/tmp/es-test-XXXXXX";
+	if(mkdtemp(home) == NULL)
+		return 1;
+	setenv("HOME", home, 1);
+	setenv("PWD", home, 1);
+	unsetenv("http_proxy");
+	boost::filesystem::create_directories(getHomePath() + "/.emulationstation");
+	Log::open();
+
+	Settings::getInstance()->setInt("HttpCacheSize", 0);
+
+	testHostConnectionLimit();
+	testHostRequestRate();
+	testErrorsReleaseConnections();
+
+	Log::close();
+	boost::system::error_code ec;
+	boost::filesystem::remove_all(home, ec);
+
+	if(sFailures)
+		fprintf(stderr, "%d check(s) failed\n", sFailures);
+	return sFailures ? 1 : 0;
+}
@@ -0,0 +1,238 @@
+#pragma once
+#ifndef ES_CORE_TEST_HTTP_STAND_IN_H
+#define ES_CORE_TEST_HTTP_STAND_IN_H
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string.h>
+#include <strings.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ctype.h>
+#include <functional>
+#include <list>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A local HTTP server for the tests, answering each request with whatever the handler returns.
+// It also works as a proxy (curl then asks for "GET http://host/path"), so requests for real hosts such as
+// thegamesdb.net can be pointed at it through the http_proxy environment variable.
+// Every connection serves one request and is closed. Requests are counted per Host header.
+class HttpStandIn
+{
+public:
+	struct Response
+	{
+		Response(int status = 200, const std::string& body = "", unsigned int delayMs = 0) : status(status), body(body), delayMs(delayMs) {};
+
+		int status; // 0 closes the connection without answering
+		std::string body;
+		unsigned int delayMs; // how long the request is held open before answering
+	};
+
+	typedef std::function<Response(const std::string& host, const std::string& path)> Handler;
+
+	HttpStandIn(const Handler& handler) : mHandler(handler), mPort(0), mStopping(false)
+	{
+		mListenSocket = socket(AF_INET, SOCK_STREAM, 0);
+
+		sockaddr_in addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		addr.sin_port = 0;
+
+		socklen_t length = sizeof(addr);
+		if(bind(mListenSocket, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(mListenSocket, 64) != 0 ||
+			getsockname(mListenSocket, (sockaddr*)&addr, &length) != 0)
+		{
+			close(mListenSocket);
+			mListenSocket = -1;
+			return;
+		}
+
+		mPort = ntohs(addr.sin_port);
+		mAcceptThread = std::thread(&HttpStandIn::acceptLoop, this);
+	}
+
+	~HttpStandIn()
+	{
+		mStopping = true;
+		if(mListenSocket >= 0)
+		{
+			shutdown(mListenSocket, SHUT_RDWR);
+			close(mListenSocket);
+			mAcceptThread.join();
+		}
+
+		for(auto it = mConnections.begin(); it != mConnections.end(); it++)
+			it->join();
+	}
+
+	inline bool isListening() const { return mPort != 0; }
+	inline int getPort() const { return mPort; }
+
+	// "127.0.0.1:port", also what requests to it carry in their Host header
+	std::string getHost() const
+	{
+		std::stringstream ss;
+		ss << "127.0.0.1:" << mPort;
+		return ss.str();
+	}
+
+	// an empty host counts over all hosts
+	unsigned int getRequestCount(const std::string& host)
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		return host.empty() ? mTotal.requests : mHosts[host].requests;
+	}
+
+	unsigned int getMaxConcurrent(const std::string& host)
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		return host.empty() ? mTotal.maxActive : mHosts[host].maxActive;
+	}
+
+	// when each request to the host arrived, in arrival order
+	std::vector<std::chrono::steady_clock::time_point> getArrivalTimes(const std::string& host)
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		return mHosts[host].arrivals;
+	}
+
+private:
+	struct HostStats
+	{
+		HostStats() : requests(0), active(0), maxActive(0) {};
+
+		unsigned int requests;
+		unsigned int active;
+		unsigned int maxActive;
+		std::vector<std::chrono::steady_clock::time_point> arrivals;
+	};
+
+	void acceptLoop()
+	{
+		while(!mStopping)
+		{
+			int client = accept(mListenSocket, NULL, NULL);
+			if(client < 0)
+				continue;
+
+			mConnections.push_back(std::thread(&HttpStandIn::serve, this, client));
+		}
+	}
+
+	void serve(int client)
+	{
+		// the tests only send GETs, so the request ends with the headers
+		std::string request;
+		char buffer[4096];
+		while(request.find("\r\n\r\n") == std::string::npos)
+		{
+			ssize_t received = recv(client, buffer, sizeof(buffer), 0);
+			if(received <= 0)
+				break;
+			request.append(buffer, received);
+		}
+
+		std::string target;
+		std::string host;
+		std::istringstream lines(request);
+		std::string line;
+		if(std::getline(lines, line))
+		{
+			std::istringstream requestLine(line);
+			std::string method;
+			requestLine >> method >> target;
+		}
+		while(std::getline(lines, line))
+		{
+			if(line.size() > 5 && strncasecmp(line.c_str(), "Host:", 5) == 0)
+			{
+				host = line.substr(5);
+				host.erase(0, host.find_first_not_of(" \t"));
+				host.erase(host.find_last_not_of(" \t\r") + 1);
+				std::transform(host.begin(), host.end(), host.begin(), ::tolower);
+			}
+		}
+
+		// proxied requests carry the whole url
+		std::string path = target;
+		if(path.compare(0, 7, "http://") == 0)
+		{
+			size_t slash = path.find('/', 7);
+			path = (slash == std::string::npos) ? "/" : path.substr(slash);
+		}
+
+		begin(host);
+		Response response = mHandler(host, path);
+		if(response.delayMs > 0)
+			std::this_thread::sleep_for(std::chrono::milliseconds(response.delayMs));
+
+		// count the request as finished before the client can see the answer and start its next one
+		end(host);
+
+		if(response.status != 0)
+		{
+			std::stringstream ss;
+			ss << "HTTP/1.1 " << response.status << " " << (response.status == 200 ? "OK" : "Error") << "\r\n"
+				<< "Content-Length: " << response.body.size() << "\r\n"
+				<< "Connection: close\r\n\r\n"
+				<< response.body;
+
+			const std::string data = ss.str();
+			size_t sent = 0;
+			while(sent < data.size())
+			{
+				ssize_t count = send(client, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+				if(count <= 0)
+					break;
+				sent += count;
+			}
+		}
+
+		shutdown(client, SHUT_RDWR);
+		close(client);
+	}
+
+	void begin(const std::string& host)
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		HostStats* stats[2] = { &mHosts[host], &mTotal };
+		for(int i = 0; i < 2; i++)
+		{
+			stats[i]->requests++;
+			stats[i]->active++;
+			stats[i]->maxActive = std::max(stats[i]->maxActive, stats[i]->active);
+		}
+		mHosts[host].arrivals.push_back(std::chrono::steady_clock::now());
+	}
+
+	void end(const std::string& host)
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mHosts[host].active--;
+		mTotal.active--;
+	}
+
+	Handler mHandler;
+	int mListenSocket;
+	int mPort;
+	std::atomic<bool> mStopping;
+	std::thread mAcceptThread;
+	std::list<std::thread> mConnections; // only touched by the accept thread until it has been joined
+
+	std::mutex mMutex;
+	std::map<std::string, HostStats> mHosts;
+	HostStats mTotal;
+};
+
+#endif // ES_CORE_TEST_HTTP_STAND_IN_H